@@ -183,6 +183,14 @@
     #define __STL_UNWIND(action)
 #endif
 
+//提示CPU预先把addr所在的cache line载入快取(只是提示,addr无效也不会出错),
+//供批次查找之类"先算出所有位址,再逐一存取"的算法隐藏cache miss的延迟
+#if defined(__GNUC__)
+    #define __STL_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+    #define __STL_PREFETCH(addr)
+#endif
+
 #ifdef __STL_ASSERTIONS
     #include <stdio.h>
     #define __stl_assert(expr) \
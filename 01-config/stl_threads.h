@@ -0,0 +1,218 @@
+/*
+ * 多线程基础设施: 原子操作、锁、线程私有随机数.
+ *
+ * SGI STL本身只在配置器(第二章)中考虑多线程,容器一概不是thread-safe.
+ * 以下这些小工具供"并发容器"(如<stl_concurrent_priority_queue.h>)使用,
+ * 写法仿照SGI <stl_threads.h>: 以条件式编译决定采用pthreads还是编译器内建的原子指令.
+ *
+ * 原子操作以GNU C++的__sync_*内建函数实现(它们同时隐含full memory barrier).
+ * 其他编译器下退化为普通读写,只适用于单线程.
+ */
+
+#ifndef SGI_STL_THREADS_H
+#define SGI_STL_THREADS_H
+
+#include <stddef.h>
+#include "01-config/stl_config.h"
+
+#ifdef __STL_PTHREADS
+    #include <pthread.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+    #include <unistd.h> // sysconf()
+#endif
+
+//同一条cache line内的数据被不同线程写入时会互相踢出(false sharing),
+//并发容器以此值为单位对热点字段做padding
+#define __STL_CACHE_LINE_SIZE 64
+
+/* ============ 原子操作 ============ */
+
+#if defined(__GNUC__)
+
+template <class T>
+inline T __stl_atomic_load(const volatile T* p)
+{
+    T v = *p;
+    __sync_synchronize();
+    return v;
+}
+
+template <class T>
+inline void __stl_atomic_store(volatile T* p, T v)
+{
+    __sync_synchronize();
+    *p = v;
+    __sync_synchronize();
+}
+
+//返回相加之后的值
+template <class T>
+inline T __stl_atomic_add(volatile T* p, T delta) { return __sync_add_and_fetch(p, delta); }
+
+//若*p等于expected就改为desired,返回是否成功
+template <class T>
+inline bool __stl_atomic_cas(volatile T* p, T expected, T desired)
+{
+    return __sync_bool_compare_and_swap(p, expected, desired);
+}
+
+//忙等时提示CPU(x86的pause指令),降低对兄弟超线程及内存总线的干扰
+inline void __stl_cpu_relax()
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __asm__ __volatile__("pause" ::: "memory");
+#else
+    __sync_synchronize();
+#endif
+}
+
+#else // !__GNUC__: 单线程退化版本
+
+template <class T>
+inline T __stl_atomic_load(const volatile T* p) { return *p; }
+template <class T>
+inline void __stl_atomic_store(volatile T* p, T v) { *p = v; }
+template <class T>
+inline T __stl_atomic_add(volatile T* p, T delta) { return *p += delta; }
+template <class T>
+inline bool __stl_atomic_cas(volatile T* p, T expected, T desired)
+{
+    if (*p != expected)
+        return false;
+    *p = desired;
+    return true;
+}
+inline void __stl_cpu_relax() {}
+
+#endif // __GNUC__
+
+/* ============ 锁 ============ */
+
+//自旋锁: 临界区极短(几十个指令)时比mutex便宜,也不会让线程陷入内核
+struct __stl_spin_lock {
+    volatile int lock;
+
+    void initialize() { lock = 0; }
+    bool try_lock() { return lock == 0 && __stl_atomic_cas(&lock, 0, 1); }
+    void acquire_lock()
+    {
+        while (!try_lock())
+            while (lock != 0) //先只读等待,避免不断以CAS抢占cache line
+                __stl_cpu_relax();
+    }
+    void release_lock() { __stl_atomic_store(&lock, 0); }
+};
+
+//互斥锁: 临界区可能较长或可能阻塞时使用
+struct __stl_mutex_lock {
+#ifdef __STL_PTHREADS
+    pthread_mutex_t mutex;
+    void initialize() { pthread_mutex_init(&mutex, 0); }
+    void destroy() { pthread_mutex_destroy(&mutex); }
+    bool try_lock() { return pthread_mutex_trylock(&mutex) == 0; }
+    void acquire_lock() { pthread_mutex_lock(&mutex); }
+    void release_lock() { pthread_mutex_unlock(&mutex); }
+#else
+    __stl_spin_lock spin;
+    void initialize() { spin.initialize(); }
+    void destroy() {}
+    bool try_lock() { return spin.try_lock(); }
+    void acquire_lock() { spin.acquire_lock(); }
+    void release_lock() { spin.release_lock(); }
+#endif
+};
+
+//在构造时加锁,析构时解锁(离开作用域或发生异常都会解锁)
+template <class Lock>
+class __stl_auto_lock {
+private:
+    Lock& lock;
+public:
+    explicit __stl_auto_lock(Lock& l) : lock(l) { lock.acquire_lock(); }
+    ~__stl_auto_lock() { lock.release_lock(); }
+private:
+    __stl_auto_lock(const __stl_auto_lock&);
+    void operator=(const __stl_auto_lock&);
+};
+
+/* ============ 其他 ============ */
+
+//线程私有的xorshift随机数,供随机化的并发算法挑选子结构.
+//不追求统计品质,只求便宜且各线程互不干扰
+inline unsigned long __stl_thread_random()
+{
+#if defined(__GNUC__)
+    static __thread unsigned long state = 0;
+#else
+    static unsigned long state = 0;
+#endif
+    if (state == 0) //以线程私有变量的地址作为种子,各线程自然不同
+        state = (unsigned long)(size_t)&state | 1;
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+//机器上可同时运行的线程数,取不到时返回1
+inline size_t __stl_hardware_concurrency()
+{
+#if defined(_SC_NPROCESSORS_ONLN)
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? size_t(n) : 1;
+#else
+    return 1;
+#endif
+}
+
+/* ============ 平行执行 ============ */
+
+//__stl_parallel_run()一次最多使用的线程数
+static const size_t __stl_max_parallel_threads = 64;
+
+#ifdef __STL_PTHREADS
+template <class Function>
+struct __stl_parallel_task {
+    Function* f;
+    size_t index;
+};
+
+template <class Function>
+void* __stl_parallel_thunk(void* p)
+{
+    __stl_parallel_task<Function>* t = (__stl_parallel_task<Function>*)p;
+    (*t->f)(t->index);
+    return 0;
+}
+#endif
+
+//以threads个线程执行f(0), f(1), ..., f(threads - 1),全部结束之后才返回.
+//f(0)由调用者线程自己执行;建立线程失败或没有pthreads时,其余各份也在调用者线程中依序执行,
+//所以f不可假设各份真的同时进行(例如彼此等待).
+//threads不可超过__stl_max_parallel_threads,f也不可抛出异常(其他线程无从接手)
+template <class Function>
+void __stl_parallel_run(size_t threads, Function& f)
+{
+#ifdef __STL_PTHREADS
+    pthread_t tid[__stl_max_parallel_threads];
+    __stl_parallel_task<Function> task[__stl_max_parallel_threads];
+    size_t started = 1;
+    for (; started < threads; ++started) {
+        task[started].f = &f;
+        task[started].index = started;
+        if (pthread_create(&tid[started], 0, __stl_parallel_thunk<Function>, &task[started]) != 0)
+            break;
+    }
+    for (size_t i = started; i < threads; ++i)
+        f(i);
+    f(0);
+    for (size_t i = 1; i < started; ++i)
+        pthread_join(tid[i], 0);
+#else
+    for (size_t i = 0; i < threads; ++i)
+        f(i);
+#endif
+}
+
+#endif // SGI_STL_THREADS_H
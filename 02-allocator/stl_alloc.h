@@ -4,9 +4,19 @@
 #include "stl_alloc_x1.h"
 #include "stl_alloc_x2.h"
 
+// 第一级配置器无论如何都要有名字: 第二级配置器在区块过大时转调它,
+// 多线程容器也以它作为缺省配置器(malloc本身是thread-safe的)
+typedef __malloc_alloc_template<0> malloc_alloc;
+
+//配置器能否同时被多个线程使用. 第二级配置器的free lists在这份源码中并未加锁,
+//只有直接转调malloc/free的第一级配置器可以;平行算法据此决定配置与归还能否分给各线程
+template <class Alloc>
+struct __alloc_thread_safe { enum { value = false }; };
+template <int inst>
+struct __alloc_thread_safe<__malloc_alloc_template<inst> > { enum { value = true }; };
+
 #ifdef __USE_MALLOC
 //....
-typedef __malloc_alloc_template<0> malloc_alloc;
 typedef malloc_alloc alloc; // 令alloc为第一级配置器
 #else
 //...
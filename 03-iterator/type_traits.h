@@ -156,5 +156,33 @@ struct __type_traits<T*> {
     typedef __true_type is_POD_type;
 };
 
+// 异质查找(heterogeneous lookup)用: 仿函数若定义了is_transparent这个型别,
+// 表示它能直接比较(或hash)键值以外的型别,例如以const char*比较string.
+// 容器只在仿函数透明时才开放find(const K&)等模板版本,
+// 否则find("abc")会选中模板版本,反而每次比较都构造一个临时键值.
+// __enable_if_transparent<F, K, R>::type 在F透明时为R,否则不存在(令该模板函数被排除).
+// K是查找函数自己的模板参数,放进来才能让判断延到推导K时进行(SFINAE),
+// 而不是在容器具现化时就出错.
+// hash容器须hash function与键值比较准则两者皆透明,以__enable_if_transparent2判断
+template <class T, class U = void, class V = void>
+struct __transparent_void { typedef void type; };
+
+template <class F, class K, class Result, class Void = void>
+struct __enable_if_transparent { };
+
+template <class F, class K, class Result>
+struct __enable_if_transparent<F, K, Result,
+    typename __transparent_void<typename F::is_transparent, K>::type> {
+    typedef Result type;
+};
+
+template <class F1, class F2, class K, class Result, class Void = void>
+struct __enable_if_transparent2 { };
+
+template <class F1, class F2, class K, class Result>
+struct __enable_if_transparent2<F1, F2, K, Result,
+    typename __transparent_void<typename F1::is_transparent, typename F2::is_transparent, K>::type> {
+    typedef Result type;
+};
 
 #endif  // SGI_STL_TYPE_TRAITS_H
\ No newline at end of file
@@ -0,0 +1,201 @@
+#ifndef SGI_STL_ADDRESSABLE_HEAP_H
+#define SGI_STL_ADDRESSABLE_HEAP_H
+
+#include <stddef.h>
+#include "01-config/stl_config.h"
+#include "02-allocator/stl_alloc.h"
+#include "02-allocator/stl_construct.h"
+#include "04-container/stl_vector.h"
+#include "04-container/stl_heap.h"
+
+/*
+ * addressable_priority_queue: 可定址的优先队列
+ *
+ * priority_queue只提供push/pop/top,元素一旦进入heap就无从寻址.
+ * 欲调整某个定时器或任务的优先级,只能全部弹出重建,或是"懒惰删除"(留下失效元素,
+ * 弹出时再跳过),后者会让heap不断膨胀.
+ *
+ * 这里每个元素配置一个独立节点,push()返回指向该节点的handle.
+ * 底部容器(vector)存放的是节点指针,节点内记录自己目前在vector中的位置,
+ * 这个位置由<stl_heap.h>的__push_heap_tracked()/__adjust_heap_tracked()在每次
+ * 搬移时维护,于是update/decrease_key/increase_key/erase(handle)都是O(log n).
+ *
+ * 与priority_queue一样是max-heap(以Compare判断,缺省less<T>,堆顶为最大者);
+ * 以greater<T>构造即为最小堆(Dijkstra、deadline调度的典型用法).
+ * 注意: handle在其元素被pop()或erase()之后即失效,不可再使用.
+ */
+
+template <class T>
+struct __addressable_heap_node {
+    T value;
+    size_t index; //节点目前在底部容器中的位置
+};
+
+template <class T, class Compare = less<T>, size_t Arity = 2, class Alloc = alloc>
+class addressable_priority_queue {
+protected:
+    typedef __addressable_heap_node<T> node;
+    typedef simple_alloc<node, Alloc> node_allocator;
+    typedef vector<node*, Alloc> sequence;
+public:
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef const T& const_reference;
+    typedef node* handle_type; //push()返回的句柄
+protected:
+    //以下两个function object把heap算法的操作对象(节点指针)转接到元素值与位置上
+    struct node_compare {
+        Compare comp;
+        node_compare(const Compare& c) : comp(c) {}
+        bool operator()(const node* x, const node* y) const { return comp(x->value, y->value); }
+    };
+    struct node_track {
+        void operator()(node* x, difference_type i) const { x->index = size_type(i); }
+    };
+
+    sequence c;         //底层容器,存放节点指针
+    node_compare comp;  //元素比较大小标准
+public:
+    addressable_priority_queue() : c(), comp(Compare()) {}
+    explicit addressable_priority_queue(const Compare& x) : c(), comp(x) {}
+    ~addressable_priority_queue() { clear(); }
+
+    bool empty() const { return c.empty(); }
+    size_type size() const { return c.size(); }
+    const_reference top() const { return c.front()->value; }
+    handle_type top_handle() const { return c.front(); }
+    //取得handle所指元素的值
+    static const_reference value(handle_type h) { return h->value; }
+
+    handle_type push(const value_type& x)
+    {
+        node* n = create_node(x);
+        n->index = c.size();
+        __STL_TRY {
+            c.push_back(n);
+        }
+        __STL_UNWIND(destroy_node(n));
+        sift_up(n->index);
+        return n;
+    }
+
+    void pop() { erase(c.front()); }
+
+    //以任意新值取代handle所指元素,视新值大小决定上浮或下沉
+    void update(handle_type h, const value_type& x)
+    {
+        h->value = x;
+        fix(h->index);
+    }
+
+    //新值的优先级不低于旧值(即!comp(x, 旧值)),节点只需上浮.
+    //以greater<T>构造最小堆时,这正是把键值调小(Dijkstra的relax操作);
+    //缺省less<T>的最大堆里,名称与方向相反: 此时应把键值调大.
+    //方向不确定时请用update()
+    void decrease_key(handle_type h, const value_type& x)
+    {
+        __stl_assert(!comp.comp(x, h->value));
+        h->value = x;
+        sift_up(h->index);
+    }
+
+    //新值的优先级不高于旧值(即!comp(旧值, x)),节点只需下沉.
+    //名称同样以最小堆为准,最大堆里应把键值调小
+    void increase_key(handle_type h, const value_type& x)
+    {
+        __stl_assert(!comp.comp(h->value, x));
+        h->value = x;
+        sift_down(h->index);
+    }
+
+    //删除handle所指元素: 以最尾端节点填补其位置,再视情况上浮或下沉
+    void erase(handle_type h)
+    {
+        const size_type i = h->index;
+        node* last = c.back();
+        c.pop_back();
+        if (last != h) {
+            c[i] = last;
+            last->index = i;
+            fix(i);
+        }
+        destroy_node(h);
+    }
+
+    void clear()
+    {
+        for (size_type i = 0; i < c.size(); ++i)
+            destroy_node(c[i]);
+        c.clear();
+    }
+protected:
+    node* create_node(const value_type& x)
+    {
+        node* n = node_allocator::allocate();
+        __STL_TRY {
+            construct(&n->value, x);
+        }
+        __STL_UNWIND(node_allocator::deallocate(n));
+        return n;
+    }
+    void destroy_node(node* n)
+    {
+        destory(&n->value);
+        node_allocator::deallocate(n);
+    }
+
+    void sift_up(size_type i)
+    {
+        __push_heap_tracked<Arity>(c.begin(), difference_type(i), difference_type(0),
+                                   c[i], comp, node_track());
+    }
+    void sift_down(size_type i)
+    {
+        __adjust_heap_tracked<Arity>(c.begin(), difference_type(i), difference_type(c.size()),
+                                     c[i], comp, node_track());
+    }
+    void fix(size_type i)
+    {
+        if (i > 0 && comp(c[(i - 1) / Arity], c[i]))
+            sift_up(i);
+        else
+            sift_down(i);
+    }
+private:
+    //节点由本容器独占,handle不可复制到另一个容器,所以不提供复制
+    addressable_priority_queue(const addressable_priority_queue&);
+    addressable_priority_queue& operator=(const addressable_priority_queue&);
+};
+
+#endif // SGI_STL_ADDRESSABLE_HEAP_H
+
+
+/*
+ * ========= TEST DEMO ============
+
+#include <iostream>
+using namespace std;
+
+int main()
+{
+    //以greater构造最小堆,模拟Dijkstra的距离队列
+    addressable_priority_queue<int, greater<int> > pq;
+    addressable_priority_queue<int, greater<int> >::handle_type h[5];
+    int dist[5] = { 50, 40, 30, 20, 10 };
+    for (int i = 0; i < 5; ++i)
+        h[i] = pq.push(dist[i]);
+
+    cout << pq.top() << endl;   // 10
+    pq.decrease_key(h[0], 5);   // relax: 50 -> 5
+    cout << pq.top() << endl;   // 5
+    pq.erase(h[4]);             // 删除10
+    pq.update(h[1], 45);        // 40 -> 45
+    while (!pq.empty()) {
+        cout << pq.top() << ' ';
+        pq.pop();
+    }
+    cout << endl;               // 5 20 30 45
+}
+
+ */
@@ -0,0 +1,250 @@
+#ifndef SGI_STL_CONCURRENT_PRIORITY_QUEUE_H
+#define SGI_STL_CONCURRENT_PRIORITY_QUEUE_H
+
+#include <stddef.h>
+#include "01-config/stl_config.h"
+#include "01-config/stl_threads.h"
+#include "02-allocator/stl_alloc.h"
+#include "02-allocator/stl_construct.h"
+#include "04-container/stl_vector.h"
+#include "04-container/stl_heap.h"
+
+/*
+ * concurrent_priority_queue: 可供多线程同时push/pop的优先队列(MultiQueue)
+ *
+ * priority_queue只是vector加上heap算法,没有任何并发控制,
+ * 外加一把mutex之后,所有工作线程都被串行化在这把锁上.
+ *
+ * MultiQueue的做法是准备c*p个各自带锁的小heap(p为线程数,c通常取2~4):
+ *   push: 随机挑一个子heap,抢到锁就放进去,抢不到就换一个
+ *   pop:  随机挑两个子heap,同时抢到两把锁后比较两者的堆顶,取较优者弹出
+ * 锁的竞争被分散到许多子heap上,而"两个里挑较好的一个"(two-choice)让弹出的元素
+ * 在期望上仍非常接近全局最优.代价是顺序放松(relaxed): pop()不保证取得全局最大值,
+ * 只保证取得"排名很靠前"的元素.工作调度之类的场合正好可以接受这种放松.
+ *
+ * 与priority_queue的接口差异: 多线程下"先top()再pop()"必然有竞争,
+ * 所以两者合并为try_pop(x),成功时将弹出的元素写入x并返回true.
+ * size()/empty()只是瞬间快照.
+ *
+ * 注意: SGI的alloc(第二级配置器)在这份源码中并未加锁,所以缺省改用malloc_alloc.
+ */
+
+template <class T, class Compare = less<T>, size_t Arity = 2, class Alloc = malloc_alloc>
+class concurrent_priority_queue {
+public:
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef const T& const_reference;
+protected:
+    //每个子heap独占若干条cache line,避免相邻子heap的锁互相false sharing
+    struct sub_queue {
+        __stl_spin_lock lock;
+        vector<T, Alloc> c;
+        char pad[__STL_CACHE_LINE_SIZE];
+    };
+    typedef simple_alloc<sub_queue, Alloc> queue_allocator;
+
+    sub_queue* queues;
+    size_type num_queues;
+    Compare comp;
+    volatile size_type count; //元素总数(以原子操作维护)
+public:
+    //threads: 预计同时访问的线程数; factor: 每个线程分摊的子heap个数
+    explicit concurrent_priority_queue(size_type threads = __stl_hardware_concurrency(),
+                                       size_type factor = 2,
+                                       const Compare& x = Compare())
+        : queues(0), num_queues(threads * factor), comp(x), count(0)
+    {
+        if (num_queues < 2)
+            num_queues = 2;
+        queues = queue_allocator::allocate(num_queues);
+        size_type i = 0;
+        __STL_TRY {
+            for (; i < num_queues; ++i) {
+                construct(&queues[i], sub_queue());
+                queues[i].lock.initialize();
+            }
+        }
+        __STL_UNWIND(destroy_queues(i));
+    }
+    ~concurrent_priority_queue() { destroy_queues(num_queues); }
+
+    bool empty() const { return __stl_atomic_load(&count) == 0; }
+    size_type size() const { return __stl_atomic_load(&count); }
+
+    void push(const value_type& x)
+    {
+        for (;;) {
+            sub_queue& q = queues[__stl_thread_random() % num_queues];
+            if (!q.lock.try_lock()) {
+                __stl_cpu_relax();
+                continue; //被占用就换一个,不在锁上等待
+            }
+            const size_type n = q.c.size();
+            __STL_TRY {
+                q.c.push_back(x);
+                push_heap<Arity>(q.c.begin(), q.c.end(), comp);
+            }
+            //比较抛出异常时去掉尾端元素,使子队列仍是合法的heap
+            __STL_UNWIND(if (q.c.size() > n) q.c.pop_back(); q.lock.release_lock());
+            //在锁内计数: 元素对其他线程可见之前count已包含它,try_pop()的empty()检查才不会漏掉
+            __stl_atomic_add(&count, size_type(1));
+            q.lock.release_lock();
+            return;
+        }
+    }
+
+    //弹出一个"接近最大"的元素写入x;队列为空时返回false
+    bool try_pop(value_type& x)
+    {
+        //随机试探的次数上限,超过之后改为逐一扫描,保证只要还有元素就一定取得到
+        const size_type max_tries = 2 * num_queues;
+        for (size_type tries = 0; tries < max_tries; ++tries) {
+            if (empty())
+                return false;
+            size_type i = __stl_thread_random() % num_queues;
+            size_type j = __stl_thread_random() % num_queues;
+            if (i == j)
+                j = (j + 1) % num_queues;
+            //只用try_lock,所以同时持有两把锁也不会死锁
+            if (!queues[i].lock.try_lock())
+                continue;
+            if (!queues[j].lock.try_lock()) {
+                queues[i].lock.release_lock();
+                continue;
+            }
+            sub_queue* best = better_of(&queues[i], &queues[j]);
+            if (best)
+                pop_from(*best, x);
+            queues[i].lock.release_lock();
+            queues[j].lock.release_lock();
+            if (best)
+                return true;
+        }
+        //随机试探屡屡落空(元素很少或竞争激烈): 从随机起点逐一扫描
+        const size_type start = __stl_thread_random() % num_queues;
+        for (size_type k = 0; k < num_queues; ++k) {
+            sub_queue& q = queues[(start + k) % num_queues];
+            q.lock.acquire_lock();
+            bool found = !q.c.empty();
+            if (found)
+                pop_from(q, x);
+            q.lock.release_lock();
+            if (found)
+                return true;
+        }
+        return false;
+    }
+protected:
+    //两个子heap皆已加锁;返回堆顶较优者,两者皆空则返回0
+    sub_queue* better_of(sub_queue* a, sub_queue* b) const
+    {
+        if (a->c.empty())
+            return b->c.empty() ? 0 : b;
+        if (b->c.empty())
+            return a;
+        return comp(a->c.front(), b->c.front()) ? b : a;
+    }
+    //调用者必须持有q的锁
+    void pop_from(sub_queue& q, value_type& x)
+    {
+        x = q.c.front();
+        pop_heap<Arity>(q.c.begin(), q.c.end(), comp);
+        q.c.pop_back();
+        __stl_atomic_add(&count, size_type(-1));
+    }
+    void destroy_queues(size_type n)
+    {
+        for (size_type i = 0; i < n; ++i)
+            destory(&queues[i]);
+        queue_allocator::deallocate(queues, num_queues);
+    }
+private:
+    concurrent_priority_queue(const concurrent_priority_queue&);
+    concurrent_priority_queue& operator=(const concurrent_priority_queue&);
+};
+
+#endif // SGI_STL_CONCURRENT_PRIORITY_QUEUE_H
+
+
+/*
+ * ========= BENCHMARK DEMO ============
+ * 以1,2,4,...直到全部硬件线程,比较"priority_queue+mutex"与concurrent_priority_queue
+ * 在push/pop各半的负载下的总吞吐量. 编译时需定义_PTHREADS并链接-lpthread
+
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/time.h>
+
+const size_t ops_per_thread = 2000000;
+
+struct locked_pq {
+    priority_queue<unsigned> pq;
+    pthread_mutex_t m;
+    locked_pq() { pthread_mutex_init(&m, 0); }
+    void push(unsigned x) { pthread_mutex_lock(&m); pq.push(x); pthread_mutex_unlock(&m); }
+    bool try_pop(unsigned& x)
+    {
+        pthread_mutex_lock(&m);
+        bool ok = !pq.empty();
+        if (ok) { x = pq.top(); pq.pop(); }
+        pthread_mutex_unlock(&m);
+        return ok;
+    }
+};
+
+template <class Q>
+struct worker_arg { Q* q; };
+
+template <class Q>
+void* worker(void* p)
+{
+    Q* q = ((worker_arg<Q>*)p)->q;
+    unsigned x;
+    for (size_t i = 0; i < ops_per_thread; ++i) {
+        if (__stl_thread_random() & 1)
+            q->push((unsigned)__stl_thread_random());
+        else
+            q->try_pop(x);
+    }
+    return 0;
+}
+
+static double now()
+{
+    timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+template <class Q>
+double run(Q& q, size_t threads)
+{
+    for (size_t i = 0; i < 100000; ++i) //预先放入一些元素,让pop有东西可取
+        q.push((unsigned)__stl_thread_random());
+    pthread_t tid[256];
+    worker_arg<Q> arg = { &q };
+    double t0 = now();
+    for (size_t i = 0; i < threads; ++i)
+        pthread_create(&tid[i], 0, worker<Q>, &arg);
+    for (size_t i = 0; i < threads; ++i)
+        pthread_join(tid[i], 0);
+    return threads * ops_per_thread / (now() - t0) / 1e6;
+}
+
+int main()
+{
+    size_t hw = __stl_hardware_concurrency();
+    for (size_t t = 1; ; t *= 2) {
+        if (t > hw) t = hw;
+        locked_pq lq;
+        concurrent_priority_queue<unsigned> cq(t);
+        double a = run(lq, t);
+        double b = run(cq, t);
+        printf("threads=%3zu  mutex+priority_queue %8.2f Mops/s  multiqueue %8.2f Mops/s\n",
+               t, a, b);
+        if (t == hw) break;
+    }
+}
+
+ */
@@ -1,7 +1,9 @@
 #ifndef SGI_STL_HEAP_H
 #define SGI_STL_HEAP_H
 
+#include <stddef.h>
 #include "03-iterator/stl_iterator.h"
+#include "07-functional/stl_function.h"
 
 template <class RandomAccessIterator>
 inline void push_heap(RandomAccessIterator first, RandomAccessIterator last)
@@ -124,6 +126,200 @@ void __make_heap(RandomAccessIterator first, RandomAccessIterator last, T*, Dist
     }
 }
 
+/* ===========================================================
+ * d叉堆(d-ary heap)版本: 以上各函数把二叉树写死在 (holeIndex-1)/2 与 2*holeIndex+2 里.
+ * 以下将叉数Arity作为编译期常量(template non-type parameter)提出来:
+ *   节点i的父节点为 (i-1)/Arity, 子节点为 Arity*i+1 ... Arity*i+Arity
+ * Arity取4或8时,树高降为log4(n)/log8(n),且同一节点的所有子节点在底部容器中连续存放,
+ * 多半落在同一条cache line内;代价是percolate down时每层要做Arity-1次比较.
+ * Arity==2时与上面的二叉堆布局完全相同.
+ *
+ * 用法: push_heap<4>(first, last) / push_heap<4>(first, last, comp), 其余三者类推.
+ * 注意Arity必须显式指定,所以不会与上面的版本产生重载歧义
+ * =========================================================== */
+
+//以下两个__xxx_heap_tracked()在每个元素落定位置时调用track(元素, 新位置),
+//供需要"位置追踪"的容器(如<stl_addressable_heap.h>)维护元素在底部容器中的索引.
+//不需要追踪时传入__heap_no_track,空函数会被编译器完全内联掉
+struct __heap_no_track {
+    template <class T, class Distance>
+    void operator()(const T&, Distance) const {}
+};
+
+template <size_t Arity, class RandomAccessIterator, class Distance, class T, 
+          class Compare, class Track>
+void __push_heap_tracked(RandomAccessIterator first, Distance holeIndex, Distance topIndex, 
+                         T value, Compare comp, Track track)
+{
+    Distance parent = (holeIndex - 1) / Distance(Arity); //找出父节点
+    while (holeIndex > topIndex && comp(*(first + parent), value)) {
+        *(first + holeIndex) = *(first + parent); //令洞值为父值
+        track(*(first + holeIndex), holeIndex);
+        holeIndex = parent; //percolate up
+        parent = (holeIndex - 1) / Distance(Arity);
+    }
+    *(first + holeIndex) = value; //令洞值为新值
+    track(*(first + holeIndex), holeIndex);
+}
+
+template <size_t Arity, class RandomAccessIterator, class Distance, class T, 
+          class Compare, class Track>
+void __adjust_heap_tracked(RandomAccessIterator first, Distance holeIndex, Distance len, 
+                           T value, Compare comp, Track track)
+{
+    Distance topIndex = holeIndex;
+    Distance child = Distance(Arity) * holeIndex + 1; //洞节点的第一个子节点
+    //以下处理Arity个子节点齐全的情况,从中选出最大子节点
+    while (child + Distance(Arity) <= len) {
+        Distance bestChild = child;
+        for (Distance i = child + 1; i < child + Distance(Arity); ++i)
+            if (comp(*(first + bestChild), *(first + i)))
+                bestChild = i;
+        //percolate down: 令最大子值为洞值,再令洞号下移至最大子节点处
+        *(first + holeIndex) = *(first + bestChild);
+        track(*(first + holeIndex), holeIndex);
+        holeIndex = bestChild;
+        child = Distance(Arity) * holeIndex + 1;
+    }
+    if (child < len) { //最后一层子节点不齐全(相当于二叉版本的"只有左子节点")
+        Distance bestChild = child;
+        for (Distance i = child + 1; i < len; ++i)
+            if (comp(*(first + bestChild), *(first + i)))
+                bestChild = i;
+        *(first + holeIndex) = *(first + bestChild);
+        track(*(first + holeIndex), holeIndex);
+        holeIndex = bestChild;
+    }
+    __push_heap_tracked<Arity>(first, holeIndex, topIndex, value, comp, track);
+}
+
+//以下这个__push_heap_d()允许指定"大小比较标准"
+template <size_t Arity, class RandomAccessIterator, class Distance, class T, class Compare>
+inline void __push_heap_d(RandomAccessIterator first, Distance holeIndex, Distance topIndex, 
+                          T value, Compare comp)
+{
+    __push_heap_tracked<Arity>(first, holeIndex, topIndex, value, comp, __heap_no_track());
+}
+
+//以下这个__adjust_heap_d()允许指定"大小比较标准"
+template <size_t Arity, class RandomAccessIterator, class Distance, class T, class Compare>
+inline void __adjust_heap_d(RandomAccessIterator first, Distance holeIndex, Distance len, 
+                            T value, Compare comp)
+{
+    __adjust_heap_tracked<Arity>(first, holeIndex, len, value, comp, __heap_no_track());
+}
+
+template <size_t Arity, class RandomAccessIterator, class Distance, class T, class Compare>
+inline void __push_heap_aux_d(RandomAccessIterator first, RandomAccessIterator last, 
+                              Compare comp, Distance*, T*)
+{
+    __push_heap_d<Arity>(first, Distance((last - first) - 1), Distance(0), 
+                         T(*(last - 1)), comp);
+}
+
+template <size_t Arity, class RandomAccessIterator, class Compare>
+inline void push_heap(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+{
+    //注意,此函数被调用时, 新元素已置于底部容器的最尾端
+    __push_heap_aux_d<Arity>(first, last, comp, distance_type(first), value_type(first));
+}
+
+template <size_t Arity, class RandomAccessIterator, class T>
+inline void __push_heap_less_d(RandomAccessIterator first, RandomAccessIterator last, T*)
+{
+    push_heap<Arity>(first, last, less<T>());
+}
+
+template <size_t Arity, class RandomAccessIterator>
+inline void push_heap(RandomAccessIterator first, RandomAccessIterator last)
+{
+    __push_heap_less_d<Arity>(first, last, value_type(first));
+}
+
+template <size_t Arity, class RandomAccessIterator, class T, class Compare, class Distance>
+inline void __pop_heap_d(RandomAccessIterator first, RandomAccessIterator last, 
+                         RandomAccessIterator result, T value, Compare comp, Distance*)
+{
+    *result = *first; //设定尾值为首值
+    __adjust_heap_d<Arity>(first, Distance(0), Distance(last - first), value, comp);
+}
+
+template <size_t Arity, class RandomAccessIterator, class T, class Compare>
+inline void __pop_heap_aux_d(RandomAccessIterator first, RandomAccessIterator last, 
+                             Compare comp, T*)
+{
+    __pop_heap_d<Arity>(first, last - 1, last - 1, T(*(last - 1)), comp, distance_type(first));
+}
+
+template <size_t Arity, class RandomAccessIterator, class Compare>
+inline void pop_heap(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+{
+    __pop_heap_aux_d<Arity>(first, last, comp, value_type(first));
+}
+
+template <size_t Arity, class RandomAccessIterator, class T>
+inline void __pop_heap_less_d(RandomAccessIterator first, RandomAccessIterator last, T*)
+{
+    pop_heap<Arity>(first, last, less<T>());
+}
+
+template <size_t Arity, class RandomAccessIterator>
+inline void pop_heap(RandomAccessIterator first, RandomAccessIterator last)
+{
+    __pop_heap_less_d<Arity>(first, last, value_type(first));
+}
+
+template <size_t Arity, class RandomAccessIterator, class Compare>
+void sort_heap(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+{
+    while (last - first > 1)
+        pop_heap<Arity>(first, last--, comp);
+}
+
+template <size_t Arity, class RandomAccessIterator>
+void sort_heap(RandomAccessIterator first, RandomAccessIterator last)
+{
+    while (last - first > 1)
+        pop_heap<Arity>(first, last--);
+}
+
+template <size_t Arity, class RandomAccessIterator, class Compare, class T, class Distance>
+void __make_heap_d(RandomAccessIterator first, RandomAccessIterator last, 
+                   Compare comp, T*, Distance*)
+{
+    if (last - first < 2)
+        return;
+
+    Distance len = last - first;
+    //最后一个非叶节点为最后一个元素(len-1)的父节点
+    Distance parent = (len - 2) / Distance(Arity);
+
+    while (true) {
+        __adjust_heap_d<Arity>(first, parent, len, T(*(first + parent)), comp);
+        if (parent == 0)
+            return;
+        parent--;
+    }
+}
+
+template <size_t Arity, class RandomAccessIterator, class Compare>
+inline void make_heap(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+{
+    __make_heap_d<Arity>(first, last, comp, value_type(first), distance_type(first));
+}
+
+template <size_t Arity, class RandomAccessIterator, class T>
+inline void __make_heap_less_d(RandomAccessIterator first, RandomAccessIterator last, T*)
+{
+    make_heap<Arity>(first, last, less<T>());
+}
+
+template <size_t Arity, class RandomAccessIterator>
+inline void make_heap(RandomAccessIterator first, RandomAccessIterator last)
+{
+    __make_heap_less_d<Arity>(first, last, value_type(first));
+}
+
 /*
 // heap不提供遍历功能, 没有迭代器
 
@@ -1,9 +1,14 @@
 #ifndef SGI_STL_PRIORITY_QUEUE_H
 #define SGI_STL_PRIORITY_QUEUE_H
 
+#include <stddef.h>
 #include "stl_vector.h"
+#include "stl_heap.h"
 
-template <class T, class Sequeue = vector<T>, class Compare = less<typename Sequence::value_type>>
+//Arity: 底层heap的叉数(见<stl_heap.h>的d叉堆版本),缺省为2即传统二叉堆.
+//元素多且比较便宜时(大型调度队列),取4或8可降低树高并让子节点落在同一cache line
+template <class T, class Sequence = vector<T>, class Compare = less<typename Sequence::value_type>,
+          size_t Arity = 2>
 class priority_queue {
 public:
     typedef typename Sequence::value_type value_type;
@@ -21,11 +26,11 @@ public:
     //注意:任何一个构造函数都立刻于底层容器内产生一个implicit representation heap
     template <class InputIterator>
     priority_queue(InputIterator first, InputIterator last, const Compare& x)
-        : c(first, last), comp(x) { make_heap(c.begin(), c.end(), comp); }
+        : c(first, last), comp(x) { make_heap<Arity>(c.begin(), c.end(), comp); }
 
     template <class InputIterator>
     priority_queue(InputIterator first, InputIterator last)
-        : c(first, last) { make_heap(c.begin(), c.end(), comp); }
+        : c(first, last) { make_heap<Arity>(c.begin(), c.end(), comp); }
 
     bool empty() const { return c.empty(); }
     size_type size() const { return c.size(); }
@@ -34,7 +39,7 @@ public:
         __STL_TRY {
             //push_heap是泛型算法,先利用底层容器的push_back()将元素压入末端,再重排heap
             c.push_back(x);
-            push_heap(c.begin(), c.end(), comp);
+            push_heap<Arity>(c.begin(), c.end(), comp);
         }
         __STL_UNWIND(c.clear());
     }
@@ -43,13 +48,121 @@ public:
         __STL_TRY {
             //pop_heap()是泛型算法,从heap内取出一个元素.它并不是真正将元素弹出
             //而是重排heap,然后再以底层容器的pop_back()取得被弹出的元素
-            pop_heap(c.begin(), c.end(), comp);
+            pop_heap<Arity>(c.begin(), c.end(), comp);
             c.pop_back();
         }
         __STL_UNWIND(c.clear());
     }
+
+    //批量插入[first, last): 先全部附加于底层容器尾端,再决定如何恢复heap次序.
+    //逐个上浮的最坏代价约为 k*log_Arity(n+k) 次比较, 整体重建(make_heap)约为 2*(n+k) 次,
+    //批量相对于既有元素越大,越适合整体重建
+    template <class InputIterator>
+    void push_range(InputIterator first, InputIterator last)
+    {
+        __STL_TRY {
+            const size_type old_size = c.size();
+            for (; first != last; ++first) //底层容器不一定提供区间insert(如vector)
+                c.push_back(*first);
+            const size_type new_size = c.size();
+            const size_type k = new_size - old_size;
+            if (k * __heap_depth(new_size) > 2 * new_size)
+                make_heap<Arity>(c.begin(), c.end(), comp);
+            else
+                for (size_type i = old_size + 1; i <= new_size; ++i)
+                    push_heap<Arity>(c.begin(), c.begin() + i, comp);
+        }
+        __STL_UNWIND(c.clear());
+    }
+
+    //依序取出最大的k个元素(不足k个就全部取出),写入result,返回写入后的result.
+    //做法是连续k次pop_heap,被取出者依次落在底层容器尾端,最后一次性复制并截断,
+    //避免每次pop_back()
+    template <class OutputIterator>
+    OutputIterator pop_n(size_type k, OutputIterator result)
+    {
+        if (k > c.size())
+            k = c.size();
+        __STL_TRY {
+            typename Sequence::iterator last = c.end();
+            for (size_type i = 0; i < k; ++i)
+                pop_heap<Arity>(c.begin(), last--, comp);
+            //此时[last, end)由小到大存放取出的元素,最大者在最尾端
+            for (typename Sequence::iterator i = c.end(); i != last; )
+                *result++ = *--i;
+            c.erase(last, c.end());
+        }
+        __STL_UNWIND(c.clear());
+        return result;
+    }
+protected:
+    //Arity叉堆容纳n个元素时的树高(上浮最多经过的层数)
+    static size_type __heap_depth(size_type n)
+    {
+        size_type depth = 0;
+        for (; n > 1; n /= Arity)
+            ++depth;
+        return depth;
+    }
 };
 
 // priority_queue 不提供遍历功能, 不提供迭代器
 
-#endif // SGI_STL_PRIORITY_QUEUE_H
\ No newline at end of file
+#endif // SGI_STL_PRIORITY_QUEUE_H
+
+/*
+ * ========= BENCHMARK DEMO ============
+ * 比较不同叉数(Arity)与不同元素大小下push/pop的吞吐量
+
+#include <queue>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+template <size_t Bytes>
+struct elem {
+    unsigned key[Bytes / sizeof(unsigned)]; //只以key[0]比较,其余部分撑大元素
+    bool operator<(const elem& x) const { return key[0] < x.key[0]; }
+};
+
+template <size_t Arity, size_t Bytes>
+void bench(size_t n)
+{
+    priority_queue<elem<Bytes>, vector<elem<Bytes> >, less<elem<Bytes> >, Arity> pq;
+    elem<Bytes> e;
+    srand(1);
+
+    clock_t t0 = clock();
+    for (size_t i = 0; i < n; ++i) {
+        e.key[0] = rand();
+        pq.push(e);
+    }
+    clock_t t1 = clock();
+    while (!pq.empty())
+        pq.pop();
+    clock_t t2 = clock();
+
+    double push_s = double(t1 - t0) / CLOCKS_PER_SEC;
+    double pop_s = double(t2 - t1) / CLOCKS_PER_SEC;
+    printf("arity=%zu elem=%3zuB  push %7.2f Mops/s  pop %7.2f Mops/s\n",
+           Arity, Bytes, n / push_s / 1e6, n / pop_s / 1e6);
+}
+
+template <size_t Bytes>
+void bench_all(size_t n)
+{
+    bench<2, Bytes>(n);
+    bench<4, Bytes>(n);
+    bench<8, Bytes>(n);
+}
+
+int main()
+{
+    const size_t n = 10000000;
+    bench_all<4>(n);
+    bench_all<16>(n);
+    bench_all<64>(n);
+}
+
+ */
\ No newline at end of file
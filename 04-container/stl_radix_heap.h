@@ -0,0 +1,186 @@
+#ifndef SGI_STL_RADIX_HEAP_H
+#define SGI_STL_RADIX_HEAP_H
+
+#include <stddef.h>
+#include "01-config/stl_config.h"
+#include "02-allocator/stl_alloc.h"
+#include "04-container/stl_vector.h"
+#include "05-container/stl_pair.h"
+
+/*
+ * radix_heap: 单调(monotone)整数优先队列
+ *
+ * 许多队列的优先级是单调的整数: 时间戳、Dijkstra的距离...
+ * 也就是说,每次push的键值都不小于最近一次pop出来的键值.
+ * 对这类负载,以比较为基础的priority_queue每个操作都要付出log n次比较,
+ * radix heap则利用"键值单调"与"整数的二进制表示"免除大部分比较:
+ *
+ *   以last记录最近一次弹出的键值(初值0). 键值k被放进第 bit_width(k ^ last) 号桶,
+ *   亦即"k与last最高的相异位"决定桶号;0号桶恰好存放等于last的元素.
+ *   pop时若0号桶为空,找出编号最小的非空桶,以其中的最小键值为新的last,
+ *   再把该桶的元素全部重新分派: 它们与新last的最高相异位必定更低,所以只会往低号桶移动.
+ *
+ * 每个元素最多下移 位数(32或64)次,所以push为O(1),pop摊还O(log C)(C为键值范围),
+ * 且与元素个数n无关.
+ * "decrease key"以再push一次较小键值的方式完成(O(1)),弹出时由用户略过过期项目,
+ * 这正是Dijkstra在radix heap上的标准用法.
+ *
+ * 键值只能是无号整数型别;与priority_queue的缺省(max-heap)相反,堆顶为最小者.
+ */
+
+//bit_width(x): 表示x所需的位数,亦即最高位1的位置加1; bit_width(0) == 0
+#if defined(__GNUC__)
+inline size_t __radix_bit_width(unsigned int x)
+{
+    return x == 0 ? 0 : sizeof(unsigned int) * 8 - __builtin_clz(x);
+}
+inline size_t __radix_bit_width(unsigned long x)
+{
+    return x == 0 ? 0 : sizeof(unsigned long) * 8 - __builtin_clzl(x);
+}
+inline size_t __radix_bit_width(unsigned long long x)
+{
+    return x == 0 ? 0 : sizeof(unsigned long long) * 8 - __builtin_clzll(x);
+}
+inline size_t __radix_bit_width(unsigned short x) { return __radix_bit_width((unsigned int)x); }
+inline size_t __radix_bit_width(unsigned char x) { return __radix_bit_width((unsigned int)x); }
+#else
+template <class UInt>
+inline size_t __radix_bit_width(UInt x)
+{
+    size_t n = 0;
+    for (; x != 0; x >>= 1)
+        ++n;
+    return n;
+}
+#endif
+
+template <class Key, class T, class Alloc = alloc>
+class radix_heap {
+public:
+    typedef Key key_type;
+    typedef T data_type;
+    typedef pair<Key, T> value_type;
+    typedef size_t size_type;
+    typedef const value_type& const_reference;
+protected:
+    enum { num_buckets = sizeof(Key) * 8 + 1 }; //0号桶加上每个位一个桶
+    typedef vector<value_type, Alloc> bucket_type;
+
+    bucket_type buckets[num_buckets];
+    Key last;               //最近一次弹出的键值,所有元素的键值都不小于它
+    size_type num_elements;
+public:
+    radix_heap() : last(0), num_elements(0) {}
+
+    bool empty() const { return num_elements == 0; }
+    size_type size() const { return num_elements; }
+    //最近一次弹出的键值,新push的键值不可小于它
+    key_type last_key() const { return last; }
+
+    //返回键值最小的元素;会视需要把非空的最低号桶重新分派到0号桶.
+    //不同于priority_queue::top(),此函数不是const: 重新分派时last前进到目前的最小键值,
+    //last_key()随之改变,此后push的键值也不可小于它
+    const_reference top() { pull(); return buckets[0].back(); }
+
+    void push(const value_type& x)
+    {
+        __stl_assert(!(x.first < last)); //键值必须单调
+        buckets[bucket_of(x.first)].push_back(x);
+        ++num_elements;
+    }
+    void push(const key_type& k, const data_type& v) { push(value_type(k, v)); }
+
+    void pop()
+    {
+        pull();
+        buckets[0].pop_back();
+        --num_elements;
+    }
+
+    void clear()
+    {
+        for (size_type i = 0; i < num_buckets; ++i)
+            buckets[i].clear();
+        last = 0;
+        num_elements = 0;
+    }
+protected:
+    //Key为unsigned short/char时k ^ last提升为int,须转回Key才能选中正确的__radix_bit_width
+    size_type bucket_of(const key_type& k) const { return __radix_bit_width(Key(k ^ last)); }
+
+    //确保0号桶非空(调用者须保证heap非空)
+    void pull()
+    {
+        if (!buckets[0].empty())
+            return;
+        size_type i = 1;
+        while (buckets[i].empty()) //找出编号最小的非空桶
+            ++i;
+        bucket_type& b = buckets[i];
+        //该桶中的最小键值即为新的last
+        typename bucket_type::iterator first = b.begin();
+        typename bucket_type::iterator last_it = b.end();
+        Key new_last = first->first;
+        for (typename bucket_type::iterator it = first; it != last_it; ++it)
+            if (it->first < new_last)
+                new_last = it->first;
+        last = new_last;
+        //重新分派: 每个元素只会落入比i更低的桶
+        for (typename bucket_type::iterator it = first; it != last_it; ++it)
+            buckets[bucket_of(it->first)].push_back(*it);
+        b.clear();
+    }
+};
+
+#endif // SGI_STL_RADIX_HEAP_H
+
+
+/*
+ * ========= BENCHMARK DEMO ============
+ * 单调负载(模拟事件驱动的模拟器/Dijkstra): 每弹出一个键值k,就推入若干个 k+随机增量.
+ * 比较radix_heap与以greater构造的priority_queue(二叉堆)
+
+#include <queue>
+#include <vector>
+#include <functional>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+typedef unsigned long key;
+
+int main()
+{
+    const size_t live = 1000000;    //队列中维持的元素数
+    const size_t ops = 20000000;    //push/pop对数
+
+    {
+        radix_heap<key, unsigned> rh;
+        srand(1);
+        for (size_t i = 0; i < live; ++i)
+            rh.push(key(rand() % 10000), 0);
+        clock_t t0 = clock();
+        for (size_t i = 0; i < ops; ++i) {
+            key k = rh.top().first;
+            rh.pop();
+            rh.push(k + 1 + rand() % 1000, 0);
+        }
+        printf("radix_heap   : %6.2f Mops/s\n", ops / (double(clock() - t0) / CLOCKS_PER_SEC) / 1e6);
+    }
+    {
+        priority_queue<key, vector<key>, greater<key> > pq;
+        srand(1);
+        for (size_t i = 0; i < live; ++i)
+            pq.push(key(rand() % 10000));
+        clock_t t0 = clock();
+        for (size_t i = 0; i < ops; ++i) {
+            key k = pq.top();
+            pq.pop();
+            pq.push(k + 1 + rand() % 1000);
+        }
+        printf("binary heap  : %6.2f Mops/s\n", ops / (double(clock() - t0) / CLOCKS_PER_SEC) / 1e6);
+    }
+}
+
+ */
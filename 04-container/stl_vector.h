@@ -14,6 +14,7 @@ public:
     typedef T               value_type;
     typedef value_type*     pointer;
     typedef value_type*     iterator;
+    typedef const value_type* const_iterator;
     typedef value_type&     reference;
     typedef size_t*         size_type;
     typedef ptrfdiff_t      difference_type;
@@ -38,7 +39,9 @@ protected:
 public:
     iterator begin() { return start; }
     iterator end() { return finish; }
-    size_type size() { return size_type(end() - begin()); }
+    const_iterator begin() const { return start; }
+    const_iterator end() const { return finish; }
+    size_type size() const { return size_type(end() - begin()); }
     size_type capacity() const { return size_type(end_of_storage - begin()); }
     bool empty() const { return begin() == end(); }
     reference operator[](size_type n) { return (begin() + n); }
@@ -91,6 +94,28 @@ public:
     }
     void resize(size_type new_size) { resize(new_size, T()); }
     void clear() { erase(begin(), end()); }
+    // 预先配置至少n个元素的空间,之后的push_back在用完之前不会再搬移元素
+    void reserve(size_type n) {
+        if (capacity() < n) {
+            const size_type old_size = size();
+            iterator tmp = data_allocator::allocate(n);
+            __STL_TRY {
+                uninitialized_copy(start, finish, tmp);
+            }
+            __STL_UNWIND(data_allocator::deallocate(tmp, n));
+            destory(start, finish);
+            deallocate();
+            start = tmp;
+            finish = tmp + old_size;
+            end_of_storage = start + n;
+        }
+    }
+    // 只对调三个指针,不搬移任何元素
+    void swap(vector<T, Alloc>& x) {
+        __STD::swap(start, x.start);
+        __STD::swap(finish, x.finish);
+        __STD::swap(end_of_storage, x.end_of_storage);
+    }
 protected:
     // 配置空间并填满内容
     iterator allocate_and_fill(size_type n, const T& x) {
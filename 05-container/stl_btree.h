@@ -0,0 +1,851 @@
+#ifndef SGI_STL_BTREE_H
+#define SGI_STL_BTREE_H
+
+#include <stddef.h>
+#include "01-config/stl_config.h"
+#include "02-allocator/stl_alloc.h"
+#include "02-allocator/stl_construct.h"
+#include "03-iterator/stl_iterator.h"
+#include "05-container/stl_pair.h"
+#include "03-iterator/type_traits.h" // __enable_if_transparent
+#include "06-algorithms/stl_algobase.h"
+
+/*
+ * btree: B+-tree,可取代rb_tree作为map/set/multimap/multiset的底层机制
+ *
+ * rb_tree每个节点只放一个元素,另带color/parent/left/right,
+ * 在千万个元素的map中查找一次约要走过24个互相依赖(dependent)的节点,几乎每一个都是cache miss.
+ * B+-tree的每个节点是一块数百字节的连续空间,一次容纳数十个键值:
+ *
+ *   leaf(叶节点):     所有元素都放在叶节点中,以数组连续存放;叶节点之间以prev/next串成双向串行,
+ *                      迭代时只是在数组中前进,走完一个叶节点才跳到下一个
+ *   internal(内节点): 只放分隔键值(separator)与子节点指针,k个键值对应k+1个子节点.
+ *                      第i个键值不小于第i个子树中的所有元素,且不大于第i+1个子树中的所有元素
+ *
+ * 树高约为log_B(n)(B为每个节点的分支数),千万个元素的树只有4~5层,每层查找都在同一块内存中完成.
+ * 节点大小由NodeBytes决定(缺省256字节,即四条cache line),键值个数依元素大小自动推算.
+ *
+ * 插入时节点满了就对半分裂,分隔键值往上插入父节点(父节点满了也分裂,树因而由根部长高);
+ * 删除后节点少于半满时,先向相邻兄弟借一个元素,兄弟也只有半满就与它合并.
+ *
+ * 与rb_tree的语意差异: 元素存放在节点的数组中,插入与删除会搬移同一节点(乃至兄弟节点)中的元素,
+ * 所以会使迭代器与元素的reference失效(end()也一样).
+ */
+
+//节点中容纳的个数: 扣除节点头部之后NodeBytes能放下几个,至少4个
+template <size_t NodeBytes, size_t Header, size_t Slot>
+struct __btree_slots {
+    enum {
+        raw = NodeBytes > Header ? (NodeBytes - Header) / Slot : 0,
+        value = raw < 4 ? 4 : (raw > 0xFFFF ? 0xFFFF : raw)
+    };
+};
+
+struct __btree_node_base {
+    __btree_node_base* parent;
+    unsigned short count; //叶节点: 元素个数; 内节点: 键值个数(子节点个数为count + 1)
+    bool leaf;
+};
+
+//未初始化的数组空间,元素以construct()/destory()逐一建构与解构
+template <class T, size_t N>
+union __btree_storage {
+    char buf[N * sizeof(T)];
+    double align_d;
+    void* align_p;
+    long long align_ll;
+
+    T* data() { return (T*)buf; }
+};
+
+template <class Value, size_t N>
+struct __btree_leaf : public __btree_node_base {
+    __btree_leaf* prev;
+    __btree_leaf* next;
+    __btree_storage<Value, N> values;
+};
+
+template <class Key, size_t N>
+struct __btree_internal : public __btree_node_base {
+    __btree_node_base* children[N + 1];
+    __btree_storage<Key, N> keys;
+};
+
+//B+-tree的迭代器: 叶节点与其中的位置. end()是最右叶节点的count位置
+template <class Value, class Ref, class Ptr, class Leaf>
+struct __btree_iterator {
+    typedef __btree_iterator<Value, Value&, Value*, Leaf> iterator;
+    typedef __btree_iterator<Value, const Value&, const Value*, Leaf> const_iterator;
+    typedef __btree_iterator<Value, Ref, Ptr, Leaf> self;
+
+    typedef bidirectional_iterator_tag iterator_category;
+    typedef Value value_type;
+    typedef ptrdiff_t difference_type;
+    typedef Ref reference;
+    typedef Ptr pointer;
+
+    Leaf* node;
+    size_t pos;
+
+    __btree_iterator() {}
+    __btree_iterator(Leaf* n, size_t i) : node(n), pos(i) {}
+    __btree_iterator(const iterator& it) : node(it.node), pos(it.pos) {}
+
+    reference operator*() const { return node->values.data()[pos]; }
+    pointer operator->() const { return &(operator*()); }
+
+    //走完一个叶节点才跳到下一个;最右叶节点走完即停在end()
+    self& operator++()
+    {
+        if (++pos == node->count && node->next) {
+            node = node->next;
+            pos = 0;
+        }
+        return *this;
+    }
+    self& operator--()
+    {
+        if (pos == 0) {
+            node = node->prev;
+            pos = node->count;
+        }
+        --pos;
+        return *this;
+    }
+    self operator++(int) { self tmp = *this; ++*this; return tmp; }
+    self operator--(int) { self tmp = *this; --*this; return tmp; }
+    bool operator==(const self& x) const { return node == x.node && pos == x.pos; }
+    bool operator!=(const self& x) const { return !(*this == x); }
+};
+
+//Key, Value, KeyOfValue, Compare, Alloc的意义与rb_tree相同
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc = alloc,
+          size_t NodeBytes = 256>
+class btree {
+public:
+    typedef Key key_type;
+    typedef Value value_type;
+    typedef value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+protected:
+    typedef __btree_node_base node_base;
+    enum {
+        leaf_slots = __btree_slots<NodeBytes, 4 * sizeof(void*), sizeof(Value)>::value,
+        inner_slots = __btree_slots<NodeBytes, 3 * sizeof(void*), sizeof(Key) + sizeof(void*)>::value,
+        leaf_min = leaf_slots / 2,   //非根节点至少这么多个元素
+        inner_min = inner_slots / 2  //非根内节点至少这么多个键值
+    };
+    typedef __btree_leaf<Value, leaf_slots> leaf;
+    typedef __btree_internal<Key, inner_slots> internal;
+    typedef simple_alloc<leaf, Alloc> leaf_allocator;
+    typedef simple_alloc<internal, Alloc> internal_allocator;
+public:
+    typedef __btree_iterator<Value, Value&, Value*, leaf> iterator;
+    typedef __btree_iterator<Value, const Value&, const Value*, leaf> const_iterator;
+protected:
+    node_base* root_node;
+    leaf* first_leaf;       //最左叶节点,begin()所在
+    leaf* last_leaf;        //最右叶节点,end()所在
+    size_type node_count;   //元素个数
+    Compare key_compare;
+public:
+    btree(const Compare& comp = Compare()) : node_count(0), key_compare(comp) { init(); }
+    btree(const btree& x) : node_count(0), key_compare(x.key_compare)
+    {
+        init();
+        copy_from(x);
+    }
+    btree& operator=(const btree& x)
+    {
+        if (this != &x) {
+            clear();
+            key_compare = x.key_compare;
+            copy_from(x);
+        }
+        return *this;
+    }
+    ~btree() { destroy_subtree(root_node); }
+
+    Compare key_comp() const { return key_compare; }
+    iterator begin() { return iterator(first_leaf, 0); }
+    iterator end() { return iterator(last_leaf, last_leaf->count); }
+    const_iterator begin() const { return const_iterator(first_leaf, 0); }
+    const_iterator end() const { return const_iterator(last_leaf, last_leaf->count); }
+    bool empty() const { return node_count == 0; }
+    size_type size() const { return node_count; }
+    size_type max_size() const { return size_type(-1); }
+    //每个叶节点与内节点各容纳几个元素/键值,供估算记忆体用量
+    static size_type leaf_capacity() { return leaf_slots; }
+    static size_type internal_capacity() { return inner_slots; }
+
+    void swap(btree& t)
+    {
+        __STD::swap(root_node, t.root_node);
+        __STD::swap(first_leaf, t.first_leaf);
+        __STD::swap(last_leaf, t.last_leaf);
+        __STD::swap(node_count, t.node_count);
+        __STD::swap(key_compare, t.key_compare);
+    }
+
+    //insert/erase
+    pair<iterator, bool> insert_unique(const value_type& v);
+    iterator insert_equal(const value_type& v);
+    //position只是提示: 搬移元素的B+-tree无法像rb_tree那样直接挂在提示的节点旁,仍从根部查找
+    iterator insert_unique(iterator, const value_type& v) { return insert_unique(v).first; }
+    iterator insert_equal(iterator, const value_type& v) { return insert_equal(v); }
+    template <class InputIterator>
+    void insert_unique(InputIterator first, InputIterator last)
+    {
+        for (; first != last; ++first)
+            insert_unique(*first);
+    }
+    template <class InputIterator>
+    void insert_equal(InputIterator first, InputIterator last)
+    {
+        for (; first != last; ++first)
+            insert_equal(*first);
+    }
+
+    //删除position所指元素,返回指向其下一个元素的迭代器
+    iterator erase(iterator position);
+    size_type erase(const key_type& k)
+    {
+        iterator first = lower_bound(k);
+        size_type n = 0;
+        //每次删除都可能搬移元素,所以以返回的迭代器继续,而不是事先求出upper_bound
+        while (first != end() && !key_compare(k, KeyOfValue()(*first))) {
+            first = erase(first);
+            ++n;
+        }
+        return n;
+    }
+    void erase(iterator first, iterator last)
+    {
+        if (first == begin() && last == end()) {
+            clear();
+            return;
+        }
+        size_type n = 0;
+        for (iterator it = first; it != last; ++it)
+            ++n;
+        while (n--)
+            first = erase(first);
+    }
+    void clear();
+
+    //查找操作
+    iterator find(const key_type& k) { return __find(k); }
+    const_iterator find(const key_type& k) const { return __find(k); }
+    size_type count(const key_type& k) const { return __count(k); }
+    iterator lower_bound(const key_type& k) { return __lower_bound(k); }
+    const_iterator lower_bound(const key_type& k) const { return __lower_bound(k); }
+    iterator upper_bound(const key_type& k) { return __upper_bound(k); }
+    const_iterator upper_bound(const key_type& k) const { return __upper_bound(k); }
+    pair<iterator, iterator> equal_range(const key_type& k)
+    {
+        return pair<iterator, iterator>(__lower_bound(k), __upper_bound(k));
+    }
+    pair<const_iterator, const_iterator> equal_range(const key_type& k) const
+    {
+        return pair<const_iterator, const_iterator>(__lower_bound(k), __upper_bound(k));
+    }
+
+    //异质查找: Compare透明(如less<void>)时开放,见rb_tree
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    find(const K& k) { return __find(k); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, const_iterator>::type
+    find(const K& k) const { return __find(k); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, size_type>::type
+    count(const K& k) const { return __count(k); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    lower_bound(const K& k) { return __lower_bound(k); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    upper_bound(const K& k) { return __upper_bound(k); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, pair<iterator, iterator> >::type
+    equal_range(const K& k)
+    {
+        return pair<iterator, iterator>(__lower_bound(k), __upper_bound(k));
+    }
+protected:
+    static Value* values(leaf* n) { return n->values.data(); }
+    static Key* keys(internal* n) { return n->keys.data(); }
+    static internal* as_internal(node_base* n) { return (internal*)n; }
+    static leaf* as_leaf(node_base* n) { return (leaf*)n; }
+    static const Key& key(const Value& v) { return KeyOfValue()(v); }
+
+    //把*src搬到未初始化的*dst(不可重叠)
+    template <class T>
+    static void move_slot(T* dst, T* src)
+    {
+        construct(dst, *src);
+        destory(src);
+    }
+    //把[first, last)往后(往前)挪一格,last(first - 1)处必须是未初始化的空间
+    template <class T>
+    static void shift_right(T* first, T* last)
+    {
+        for (; last != first; --last)
+            move_slot(last, last - 1);
+    }
+    template <class T>
+    static void shift_left(T* first, T* last)
+    {
+        for (; first != last; ++first)
+            move_slot(first - 1, first);
+    }
+
+    leaf* new_leaf()
+    {
+        leaf* n = leaf_allocator::allocate();
+        n->parent = 0;
+        n->count = 0;
+        n->leaf = true;
+        n->prev = n->next = 0;
+        return n;
+    }
+    internal* new_internal()
+    {
+        internal* n = internal_allocator::allocate();
+        n->parent = 0;
+        n->count = 0;
+        n->leaf = false;
+        return n;
+    }
+    void destroy_leaf(leaf* n)
+    {
+        for (size_type i = 0; i < n->count; ++i)
+            destory(values(n) + i);
+        leaf_allocator::deallocate(n);
+    }
+    void destroy_internal(internal* n)
+    {
+        for (size_type i = 0; i < n->count; ++i)
+            destory(keys(n) + i);
+        internal_allocator::deallocate(n);
+    }
+    void init()
+    {
+        first_leaf = last_leaf = new_leaf(); //空树也有一个(空的)根叶节点,end()才有处可指
+        root_node = first_leaf;
+    }
+
+    //以下节点内的查找以二分法进行
+    //第一个不小于k的元素/键值
+    template <class K>
+    size_type leaf_lower(leaf* n, const K& k) const
+    {
+        size_type lo = 0, hi = n->count;
+        while (lo < hi) {
+            size_type mid = (lo + hi) >> 1;
+            if (key_compare(key(values(n)[mid]), k))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+    //第一个大于k的元素/键值
+    template <class K>
+    size_type leaf_upper(leaf* n, const K& k) const
+    {
+        size_type lo = 0, hi = n->count;
+        while (lo < hi) {
+            size_type mid = (lo + hi) >> 1;
+            if (key_compare(k, key(values(n)[mid])))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        return lo;
+    }
+    template <class K>
+    size_type inner_lower(internal* n, const K& k) const
+    {
+        size_type lo = 0, hi = n->count;
+        while (lo < hi) {
+            size_type mid = (lo + hi) >> 1;
+            if (key_compare(keys(n)[mid], k))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+    template <class K>
+    size_type inner_upper(internal* n, const K& k) const
+    {
+        size_type lo = 0, hi = n->count;
+        while (lo < hi) {
+            size_type mid = (lo + hi) >> 1;
+            if (key_compare(k, keys(n)[mid]))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        return lo;
+    }
+
+    //由根往下,走到k的lower_bound(upper_bound)所在的叶节点
+    template <class K>
+    leaf* descend_lower(const K& k) const
+    {
+        node_base* x = root_node;
+        while (!x->leaf)
+            x = as_internal(x)->children[inner_lower(as_internal(x), k)];
+        return as_leaf(x);
+    }
+    template <class K>
+    leaf* descend_upper(const K& k) const
+    {
+        node_base* x = root_node;
+        while (!x->leaf)
+            x = as_internal(x)->children[inner_upper(as_internal(x), k)];
+        return as_leaf(x);
+    }
+    //位置i可能恰为叶节点的尾端: 除非它是最右叶节点,否则答案是下一个叶节点的第一个元素
+    iterator make_iterator(leaf* n, size_type i) const
+    {
+        if (i == n->count && n->next)
+            return iterator(n->next, 0);
+        return iterator(n, i);
+    }
+
+    template <class K>
+    iterator __lower_bound(const K& k) const
+    {
+        leaf* n = descend_lower(k);
+        return make_iterator(n, leaf_lower(n, k));
+    }
+    template <class K>
+    iterator __upper_bound(const K& k) const
+    {
+        leaf* n = descend_upper(k);
+        return make_iterator(n, leaf_upper(n, k));
+    }
+    template <class K>
+    iterator __find(const K& k) const
+    {
+        iterator j = __lower_bound(k);
+        iterator e(last_leaf, last_leaf->count);
+        return (j == e || key_compare(k, key(*j))) ? e : j;
+    }
+    template <class K>
+    size_type __count(const K& k) const
+    {
+        iterator first = __lower_bound(k);
+        iterator last = __upper_bound(k);
+        size_type n = 0;
+        for (; first != last; ++first)
+            ++n;
+        return n;
+    }
+
+    //在叶节点n的位置i插入v,必要时先分裂n
+    iterator insert_at(leaf* n, size_type i, const value_type& v);
+    //n已满: 把后半段搬进新的右兄弟,并把分隔键值插入父节点,返回右兄弟
+    leaf* split_leaf(leaf* n);
+    void split_internal(internal* n);
+    //在父节点中紧接着left之后插入分隔键值sep与新的子节点right
+    void insert_in_parent(node_base* left, const Key& sep, node_base* right);
+    static size_type child_index(internal* p, node_base* n)
+    {
+        size_type i = 0;
+        while (p->children[i] != n)
+            ++i;
+        return i;
+    }
+
+    //叶节点n少于半满: 向兄弟借一个元素或与兄弟合并. next为删除后的"下一个元素",随元素搬移而修正
+    void rebalance_leaf(leaf* n, iterator& next);
+    //b并入其左兄弟a,sep为两者在父节点中的分隔键值位置
+    void merge_leaves(leaf* a, leaf* b, size_type sep, iterator& next);
+    void rebalance_internal(internal* n);
+    //从内节点p中移除第i个键值与第i + 1个子节点
+    void remove_from_parent(internal* p, size_type i);
+
+    void destroy_subtree(node_base* x);
+    //复制x为根的子树,叶节点依序串接在prev之后;返回新子树的根
+    node_base* copy_subtree(node_base* x, internal* parent, leaf*& prev);
+    //复制内节点n失败: 清除已复制好的子树children[0, built]与键值
+    void destroy_partial(internal* n, size_type built);
+    void copy_from(const btree& x);
+};
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+pair<typename btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::iterator, bool>
+btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::insert_unique(const value_type& v)
+{
+    const Key& k = key(v);
+    leaf* n = descend_lower(k);
+    size_type i = leaf_lower(n, k);
+    //第一个不小于k的元素若不大于k即为重复;它可能位于下一个叶节点的开头
+    if (i < n->count) {
+        if (!key_compare(k, key(values(n)[i])))
+            return pair<iterator, bool>(iterator(n, i), false);
+    } else if (n->next && !key_compare(k, key(values(n->next)[0]))) {
+        return pair<iterator, bool>(iterator(n->next, 0), false);
+    }
+    return pair<iterator, bool>(insert_at(n, i, v), true);
+}
+
+//与rb_tree相同,重复的键值插在既有者之后
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::iterator
+btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::insert_equal(const value_type& v)
+{
+    const Key& k = key(v);
+    leaf* n = descend_upper(k);
+    return insert_at(n, leaf_upper(n, k), v);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::iterator
+btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::insert_at(leaf* n, size_type i, const value_type& v)
+{
+    if (n->count == leaf_slots) {
+        leaf* r = split_leaf(n);
+        //落在分裂点(含)之后者放进右半: 它不小于左半的最大者,也就是新的分隔键值
+        if (i >= n->count) {
+            i -= n->count;
+            n = r;
+        }
+    }
+    Value* p = values(n);
+    shift_right(p + i, p + n->count);
+    __STL_TRY {
+        construct(p + i, v);
+    }
+    __STL_UNWIND(shift_left(p + i + 1, p + n->count + 1));
+    ++n->count;
+    ++node_count;
+    return iterator(n, i);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::leaf*
+btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::split_leaf(leaf* n)
+{
+    leaf* r = new_leaf();
+    const size_type mid = n->count / 2;
+    for (size_type i = mid; i < n->count; ++i)
+        move_slot(values(r) + (i - mid), values(n) + i);
+    r->count = n->count - mid;
+    n->count = mid;
+    //把r串进叶节点串行
+    r->next = n->next;
+    if (r->next)
+        r->next->prev = r;
+    else
+        last_leaf = r;
+    r->prev = n;
+    n->next = r;
+    //左半的最大键值即为分隔键值
+    insert_in_parent(n, key(values(n)[mid - 1]), r);
+    return r;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+void btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::split_internal(internal* n)
+{
+    internal* r = new_internal();
+    const size_type mid = n->count / 2;
+    //左半保留键值[0, mid)与子节点[0, mid],键值mid往上送,右半取得其余
+    for (size_type i = mid + 1; i < n->count; ++i)
+        move_slot(keys(r) + (i - mid - 1), keys(n) + i);
+    for (size_type i = mid + 1; i <= n->count; ++i) {
+        r->children[i - mid - 1] = n->children[i];
+        n->children[i]->parent = r;
+    }
+    r->count = n->count - mid - 1;
+    Key sep = keys(n)[mid];
+    destory(keys(n) + mid);
+    n->count = mid;
+    insert_in_parent(n, sep, r);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+void btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::
+    insert_in_parent(node_base* left, const Key& sep, node_base* right)
+{
+    if (left == root_node) { //根节点分裂,树长高一层
+        internal* p = new_internal();
+        construct(keys(p), sep);
+        p->children[0] = left;
+        p->children[1] = right;
+        p->count = 1;
+        left->parent = right->parent = p;
+        root_node = p;
+        return;
+    }
+    internal* p = as_internal(left->parent);
+    if (p->count == inner_slots) {
+        split_internal(p);
+        p = as_internal(left->parent); //left可能已被分到右半
+    }
+    const size_type i = child_index(p, left);
+    shift_right(keys(p) + i, keys(p) + p->count);
+    construct(keys(p) + i, sep);
+    for (size_type j = p->count + 1; j > i + 1; --j)
+        p->children[j] = p->children[j - 1];
+    p->children[i + 1] = right;
+    right->parent = p;
+    ++p->count;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::iterator
+btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::erase(iterator position)
+{
+    leaf* n = position.node;
+    const size_type i = position.pos;
+    Value* p = values(n);
+    destory(p + i);
+    shift_left(p + i + 1, p + n->count);
+    --n->count;
+    --node_count;
+    iterator next = i < n->count || !n->next ? iterator(n, i) : iterator(n->next, 0);
+    if (n != root_node && n->count < leaf_min)
+        rebalance_leaf(n, next);
+    return next;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+void btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::rebalance_leaf(leaf* n, iterator& next)
+{
+    internal* p = as_internal(n->parent);
+    const size_type j = child_index(p, n);
+    leaf* left = j > 0 ? as_leaf(p->children[j - 1]) : 0;
+    leaf* right = j < p->count ? as_leaf(p->children[j + 1]) : 0;
+
+    if (left && left->count > leaf_min) { //向左兄弟借其最大者
+        shift_right(values(n), values(n) + n->count);
+        move_slot(values(n), values(left) + left->count - 1);
+        --left->count;
+        ++n->count;
+        destory(keys(p) + j - 1);
+        construct(keys(p) + j - 1, key(values(left)[left->count - 1]));
+        if (next.node == n)
+            ++next.pos;
+    } else if (right && right->count > leaf_min) { //向右兄弟借其最小者
+        move_slot(values(n) + n->count, values(right));
+        shift_left(values(right) + 1, values(right) + right->count);
+        --right->count;
+        ++n->count;
+        destory(keys(p) + j);
+        construct(keys(p) + j, key(values(n)[n->count - 1]));
+        if (next.node == right) {
+            if (next.pos == 0)
+                next = iterator(n, n->count - 1);
+            else
+                --next.pos;
+        }
+    } else if (left) {
+        merge_leaves(left, n, j - 1, next);
+    } else {
+        merge_leaves(n, right, j, next);
+    }
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+void btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::
+    merge_leaves(leaf* a, leaf* b, size_type sep, iterator& next)
+{
+    const size_type base = a->count;
+    for (size_type i = 0; i < b->count; ++i)
+        move_slot(values(a) + base + i, values(b) + i);
+    a->count += b->count;
+    b->count = 0;
+    if (next.node == b)
+        next = iterator(a, base + next.pos);
+    a->next = b->next;
+    if (a->next)
+        a->next->prev = a;
+    else
+        last_leaf = a;
+    internal* p = as_internal(a->parent);
+    destroy_leaf(b);
+    remove_from_parent(p, sep);
+    rebalance_internal(p);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+void btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::remove_from_parent(internal* p, size_type i)
+{
+    destory(keys(p) + i);
+    shift_left(keys(p) + i + 1, keys(p) + p->count);
+    for (size_type j = i + 1; j < p->count; ++j)
+        p->children[j] = p->children[j + 1];
+    --p->count;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+void btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::rebalance_internal(internal* n)
+{
+    if (n == root_node) {
+        if (n->count == 0) { //根只剩一个子节点: 树变矮一层
+            root_node = n->children[0];
+            root_node->parent = 0;
+            internal_allocator::deallocate(n);
+        }
+        return;
+    }
+    if (n->count >= inner_min)
+        return;
+    internal* p = as_internal(n->parent);
+    const size_type j = child_index(p, n);
+    internal* left = j > 0 ? as_internal(p->children[j - 1]) : 0;
+    internal* right = j < p->count ? as_internal(p->children[j + 1]) : 0;
+
+    if (left && left->count > inner_min) {
+        //经由父节点旋转: 父节点的分隔键值下移到n的最前面,左兄弟的最大键值上移取代它
+        shift_right(keys(n), keys(n) + n->count);
+        move_slot(keys(n), keys(p) + j - 1);
+        for (size_type i = n->count + 1; i > 0; --i)
+            n->children[i] = n->children[i - 1];
+        n->children[0] = left->children[left->count];
+        n->children[0]->parent = n;
+        move_slot(keys(p) + j - 1, keys(left) + left->count - 1);
+        --left->count;
+        ++n->count;
+    } else if (right && right->count > inner_min) {
+        move_slot(keys(n) + n->count, keys(p) + j);
+        n->children[n->count + 1] = right->children[0];
+        n->children[n->count + 1]->parent = n;
+        move_slot(keys(p) + j, keys(right));
+        shift_left(keys(right) + 1, keys(right) + right->count);
+        for (size_type i = 0; i < right->count; ++i)
+            right->children[i] = right->children[i + 1];
+        --right->count;
+        ++n->count;
+    } else {
+        //与兄弟合并: a + 分隔键值 + b
+        internal* a = left ? left : n;
+        internal* b = left ? n : right;
+        const size_type sep = left ? j - 1 : j;
+        construct(keys(a) + a->count, keys(p)[sep]);
+        for (size_type i = 0; i < b->count; ++i)
+            move_slot(keys(a) + a->count + 1 + i, keys(b) + i);
+        for (size_type i = 0; i <= b->count; ++i) {
+            a->children[a->count + 1 + i] = b->children[i];
+            b->children[i]->parent = a;
+        }
+        a->count += 1 + b->count;
+        internal_allocator::deallocate(b);
+        remove_from_parent(p, sep);
+        rebalance_internal(p);
+    }
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+void btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::destroy_subtree(node_base* x)
+{
+    if (x->leaf) {
+        destroy_leaf(as_leaf(x));
+        return;
+    }
+    internal* n = as_internal(x);
+    for (size_type i = 0; i <= n->count; ++i)
+        destroy_subtree(n->children[i]);
+    destroy_internal(n);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+void btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::destroy_partial(internal* n, size_type built)
+{
+    //第built个子树可能已复制好(失败的是其后的键值),也可能正是失败者(仍为0)
+    for (size_type i = 0; i <= built; ++i)
+        if (n->children[i])
+            destroy_subtree(n->children[i]);
+    destroy_internal(n);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+void btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::clear()
+{
+    destroy_subtree(root_node);
+    node_count = 0;
+    init();
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+typename btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::node_base*
+btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::
+    copy_subtree(node_base* x, internal* parent, leaf*& prev)
+{
+    if (x->leaf) {
+        leaf* src = as_leaf(x);
+        leaf* n = new_leaf();
+        __STL_TRY {
+            for (; n->count < src->count; ++n->count)
+                construct(values(n) + n->count, values(src)[n->count]);
+        }
+        __STL_UNWIND(destroy_leaf(n));
+        n->parent = parent;
+        n->prev = prev;
+        if (prev)
+            prev->next = n;
+        prev = n;
+        return n;
+    }
+    internal* src = as_internal(x);
+    internal* n = new_internal();
+    n->parent = parent;
+    size_type built = 0; //已复制好的子树个数
+    //任何一步失败,已建好的子树与键值都挂在n之下,由destroy_partial()一并清除
+    __STL_TRY {
+        for (; built <= src->count; ++built) {
+            n->children[built] = 0;
+            n->children[built] = copy_subtree(src->children[built], n, prev);
+            if (built < src->count) {
+                construct(keys(n) + built, keys(src)[built]);
+                n->count = (unsigned short)(built + 1);
+            }
+        }
+    }
+    __STL_UNWIND(destroy_partial(n, built));
+    return n;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+void btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>::copy_from(const btree& x)
+{
+    //目前是只有一个空根叶节点的空树
+    if (x.node_count == 0)
+        return;
+    leaf* prev = 0;
+    node_base* r = copy_subtree(x.root_node, 0, prev);
+    destroy_leaf(first_leaf);
+    root_node = r;
+    node_base* n = r;
+    while (!n->leaf)
+        n = as_internal(n)->children[0];
+    first_leaf = as_leaf(n);
+    last_leaf = prev;
+    node_count = x.node_count;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+inline bool operator==(const btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>& x,
+                       const btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>& y)
+{
+    return x.size() == y.size() && equal(x.begin(), x.end(), y.begin());
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, size_t NodeBytes>
+inline bool operator<(const btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>& x,
+                      const btree<Key, Value, KeyOfValue, Compare, Alloc, NodeBytes>& y)
+{
+    return lexicographical_compare(x.begin(), x.end(), y.begin(), y.end());
+}
+
+#endif // SGI_STL_BTREE_H
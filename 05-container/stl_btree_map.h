@@ -0,0 +1,206 @@
+#ifndef SGI_STL_BTREE_MAP_H
+#define SGI_STL_BTREE_MAP_H
+
+#include "02-allocator/stl_alloc.h"
+#include "07-functional/stl_function.h"
+#include "05-container/stl_btree.h"
+
+//btree_map的接口与map相同,只是底层改为B+-tree(见<stl_btree.h>).
+//数十个pair<const Key, T>连续存放在同一个叶节点中,查找与迭代的cache miss远少于红黑树.
+//与map唯一的语意差异: insert/erase会搬移元素,使既有迭代器与元素reference失效
+
+template <class Key, class T, class Compare = less<Key>, class Alloc = alloc>
+class btree_map;
+
+template <class Key, class T, class Compare, class Alloc>
+inline bool operator==(const btree_map<Key, T, Compare, Alloc>& x,
+                       const btree_map<Key, T, Compare, Alloc>& y);
+template <class Key, class T, class Compare, class Alloc>
+inline bool operator<(const btree_map<Key, T, Compare, Alloc>& x,
+                      const btree_map<Key, T, Compare, Alloc>& y);
+
+template <class Key, class T, class Compare, class Alloc>
+class btree_map {
+public:
+    typedef Key key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef pair<const Key, T> value_type;
+    typedef Compare key_compare;
+
+    class value_compare : public binary_function<value_type, value_type, bool> {
+    friend class btree_map<Key, T, Compare, Alloc>;
+    protected:
+        Compare comp;
+        value_compare(Compare c) : comp(c) {}
+    public:
+        bool operator()(const value_type& x, const value_type& y) const
+        {
+            return comp(x.first, y.first);
+        }
+    };
+private:
+    typedef btree<key_type, value_type, select1st<value_type>, key_compare, Alloc> rep_type;
+    rep_type t; //以B+-tree表现map
+public:
+    typedef typename rep_type::pointer pointer;
+    typedef typename rep_type::const_pointer const_pointer;
+    typedef typename rep_type::reference reference;
+    typedef typename rep_type::const_reference const_reference;
+    typedef typename rep_type::iterator iterator;
+    typedef typename rep_type::const_iterator const_iterator;
+    typedef typename rep_type::size_type size_type;
+    typedef typename rep_type::difference_type difference_type;
+
+    btree_map() : t(Compare()) {}
+    explicit btree_map(const Compare& comp) : t(comp) {}
+    template <class InputIterator>
+    btree_map(InputIterator first, InputIterator last) :
+        t(Compare()) { t.insert_unique(first, last); }
+    template <class InputIterator>
+    btree_map(InputIterator first, InputIterator last, const Compare& comp) :
+        t(comp) { t.insert_unique(first, last); }
+
+    //accessors
+    key_compare key_comp() const { return t.key_comp(); }
+    value_compare value_comp() const { return value_compare(t.key_comp()); }
+    iterator begin() { return t.begin(); }
+    const_iterator begin() const { return t.begin(); }
+    iterator end() { return t.end(); }
+    const_iterator end() const { return t.end(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    size_type max_size() const { return t.max_size(); }
+    T& operator[](const key_type& k) {
+        return (*((insert(value_type(k, T()))).first)).second;
+    }
+    void swap(btree_map& x) { t.swap(x.t); }
+
+    //insert/erase
+    pair<iterator, bool> insert(const value_type& x) { return t.insert_unique(x); }
+    iterator insert(iterator position, const value_type& x) { return t.insert_unique(position, x); }
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last) { t.insert_unique(first, last); }
+
+    //与map不同,返回被删元素的下一个位置: 删除会搬移元素,调用者无法自行保留它
+    iterator erase(iterator position) { return t.erase(position); }
+    size_type erase(const key_type& x) { return t.erase(x); }
+    void erase(iterator first, iterator last) { t.erase(first, last); }
+    void clear() { t.clear(); }
+
+    //map operations
+    iterator find(const key_type& x) { return t.find(x); }
+    const_iterator find(const key_type& x) const { return t.find(x); }
+    size_type count(const key_type& x) const { return t.count(x); }
+    iterator lower_bound(const key_type& x) { return t.lower_bound(x); }
+    const_iterator lower_bound(const key_type& x) const { return t.lower_bound(x); }
+    iterator upper_bound(const key_type& x) { return t.upper_bound(x); }
+    const_iterator upper_bound(const key_type& x) const { return t.upper_bound(x); }
+    pair<iterator, iterator> equal_range(const key_type& x) { return t.equal_range(x); }
+    pair<const_iterator, const_iterator> equal_range(const key_type& x) const { return t.equal_range(x); }
+    //异质查找: 仅当Compare透明(如less<void>)时开放,见rb_tree
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    find(const K& x) { return t.find(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, const_iterator>::type
+    find(const K& x) const { return t.find(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, size_type>::type
+    count(const K& x) const { return t.count(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    lower_bound(const K& x) { return t.lower_bound(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    upper_bound(const K& x) { return t.upper_bound(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, pair<iterator, iterator> >::type
+    equal_range(const K& x) { return t.equal_range(x); }
+
+    friend bool operator== __STL_NULL_TMPL_ARGS (const btree_map&, const btree_map&);
+    friend bool operator< __STL_NULL_TMPL_ARGS (const btree_map&, const btree_map&);
+};
+
+template <class Key, class T, class Compare, class Alloc>
+inline bool operator==(const btree_map<Key, T, Compare, Alloc>& x,
+                       const btree_map<Key, T, Compare, Alloc>& y)
+{
+    return x.t == y.t;
+}
+
+template <class Key, class T, class Compare, class Alloc>
+inline bool operator<(const btree_map<Key, T, Compare, Alloc>& x,
+                      const btree_map<Key, T, Compare, Alloc>& y)
+{
+    return x.t < y.t;
+}
+
+#endif // SGI_STL_BTREE_MAP_H
+
+
+/*
+ * ========= BENCHMARK DEMO ============
+ * 随机键值: 比较map(红黑树)与btree_map的插入、查找、有序迭代,以及每个元素的记忆体用量
+
+#include <map>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+typedef unsigned long key;
+
+int main()
+{
+    const size_t n = 4000000, lookups = 20000000;
+    vector<key> keys;
+    for (size_t i = 0; i < n; ++i)
+        keys.push_back(((key)rand() << 31) ^ rand());
+
+    map<key, key> m;
+    btree_map<key, key> bm;
+    clock_t t0 = clock();
+    for (size_t i = 0; i < n; ++i)
+        m[keys[i]] = i;
+    clock_t t1 = clock();
+    for (size_t i = 0; i < n; ++i)
+        bm[keys[i]] = i;
+    clock_t t2 = clock();
+    printf("insert  map %6.2f  btree_map %6.2f Mops/s\n",
+           n / (double(t1 - t0) / CLOCKS_PER_SEC) / 1e6, n / (double(t2 - t1) / CLOCKS_PER_SEC) / 1e6);
+
+    key sum = 0;
+    t0 = clock();
+    for (size_t i = 0; i < lookups; ++i)
+        sum += m.find(keys[(i * 7919) % n])->second;
+    t1 = clock();
+    for (size_t i = 0; i < lookups; ++i)
+        sum += bm.find(keys[(i * 7919) % n])->second;
+    t2 = clock();
+    printf("find    map %6.2f  btree_map %6.2f Mops/s\n",
+           lookups / (double(t1 - t0) / CLOCKS_PER_SEC) / 1e6,
+           lookups / (double(t2 - t1) / CLOCKS_PER_SEC) / 1e6);
+
+    t0 = clock();
+    for (int r = 0; r < 10; ++r)
+        for (map<key, key>::iterator it = m.begin(); it != m.end(); ++it)
+            sum += it->second;
+    t1 = clock();
+    for (int r = 0; r < 10; ++r)
+        for (btree_map<key, key>::iterator it = bm.begin(); it != bm.end(); ++it)
+            sum += it->second;
+    t2 = clock();
+    printf("iterate map %6.2f  btree_map %6.2f Mops/s\n",
+           10 * n / (double(t1 - t0) / CLOCKS_PER_SEC) / 1e6,
+           10 * n / (double(t2 - t1) / CLOCKS_PER_SEC) / 1e6);
+    printf("(%lu)\n", sum);
+
+    //记忆体: 红黑树每个元素一个节点(color + parent/left/right + pair);
+    //B+-tree随机插入后叶节点平均约2/3满,内节点所占不到叶节点的十分之一
+    printf("map       ~%zu bytes/elem\n", 4 * sizeof(void*) + sizeof(pair<const key, key>));
+    const size_t per_leaf = (256 - 4 * sizeof(void*)) / sizeof(pair<const key, key>);
+    printf("btree_map ~%zu bytes/elem (%zu elems/leaf)\n", 256 / (per_leaf * 2 / 3), per_leaf);
+}
+
+ */
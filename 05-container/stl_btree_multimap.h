@@ -0,0 +1,135 @@
+#ifndef SGI_STL_BTREE_MULTIMAP_H
+#define SGI_STL_BTREE_MULTIMAP_H
+
+#include "02-allocator/stl_alloc.h"
+#include "07-functional/stl_function.h"
+#include "05-container/stl_btree.h"
+
+//btree_multimap的接口与multimap相同,只是底层改为B+-tree(见<stl_btree.h>),
+//重复的键值依插入次序排列. 与multimap唯一的语意差异: insert/erase会使既有迭代器失效
+
+template <class Key, class T, class Compare = less<Key>, class Alloc = alloc>
+class btree_multimap;
+
+template <class Key, class T, class Compare, class Alloc>
+inline bool operator==(const btree_multimap<Key, T, Compare, Alloc>& x,
+                       const btree_multimap<Key, T, Compare, Alloc>& y);
+template <class Key, class T, class Compare, class Alloc>
+inline bool operator<(const btree_multimap<Key, T, Compare, Alloc>& x,
+                      const btree_multimap<Key, T, Compare, Alloc>& y);
+
+template <class Key, class T, class Compare, class Alloc>
+class btree_multimap {
+public:
+    typedef Key key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef pair<const Key, T> value_type;
+    typedef Compare key_compare;
+
+    class value_compare : public binary_function<value_type, value_type, bool> {
+    friend class btree_multimap<Key, T, Compare, Alloc>;
+    protected:
+        Compare comp;
+        value_compare(Compare c) : comp(c) {}
+    public:
+        bool operator()(const value_type& x, const value_type& y) const
+        {
+            return comp(x.first, y.first);
+        }
+    };
+private:
+    typedef btree<key_type, value_type, select1st<value_type>, key_compare, Alloc> rep_type;
+    rep_type t; //以B+-tree表现multimap
+public:
+    typedef typename rep_type::pointer pointer;
+    typedef typename rep_type::const_pointer const_pointer;
+    typedef typename rep_type::reference reference;
+    typedef typename rep_type::const_reference const_reference;
+    typedef typename rep_type::iterator iterator;
+    typedef typename rep_type::const_iterator const_iterator;
+    typedef typename rep_type::size_type size_type;
+    typedef typename rep_type::difference_type difference_type;
+
+    btree_multimap() : t(Compare()) {}
+    explicit btree_multimap(const Compare& comp) : t(comp) {}
+    template <class InputIterator>
+    btree_multimap(InputIterator first, InputIterator last) :
+        t(Compare()) { t.insert_equal(first, last); }
+    template <class InputIterator>
+    btree_multimap(InputIterator first, InputIterator last, const Compare& comp) :
+        t(comp) { t.insert_equal(first, last); }
+
+    //accessors
+    key_compare key_comp() const { return t.key_comp(); }
+    value_compare value_comp() const { return value_compare(t.key_comp()); }
+    iterator begin() { return t.begin(); }
+    const_iterator begin() const { return t.begin(); }
+    iterator end() { return t.end(); }
+    const_iterator end() const { return t.end(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    size_type max_size() const { return t.max_size(); }
+    void swap(btree_multimap& x) { t.swap(x.t); }
+
+    //insert/erase
+    iterator insert(const value_type& x) { return t.insert_equal(x); }
+    iterator insert(iterator position, const value_type& x) { return t.insert_equal(position, x); }
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last) { t.insert_equal(first, last); }
+
+    //与multimap不同,返回被删元素的下一个位置: 删除会搬移元素,调用者无法自行保留它
+    iterator erase(iterator position) { return t.erase(position); }
+    size_type erase(const key_type& x) { return t.erase(x); }
+    void erase(iterator first, iterator last) { t.erase(first, last); }
+    void clear() { t.clear(); }
+
+    //multimap operations
+    iterator find(const key_type& x) { return t.find(x); }
+    const_iterator find(const key_type& x) const { return t.find(x); }
+    size_type count(const key_type& x) const { return t.count(x); }
+    iterator lower_bound(const key_type& x) { return t.lower_bound(x); }
+    const_iterator lower_bound(const key_type& x) const { return t.lower_bound(x); }
+    iterator upper_bound(const key_type& x) { return t.upper_bound(x); }
+    const_iterator upper_bound(const key_type& x) const { return t.upper_bound(x); }
+    pair<iterator, iterator> equal_range(const key_type& x) { return t.equal_range(x); }
+    pair<const_iterator, const_iterator> equal_range(const key_type& x) const { return t.equal_range(x); }
+    //异质查找: 仅当Compare透明(如less<void>)时开放,见rb_tree
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    find(const K& x) { return t.find(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, const_iterator>::type
+    find(const K& x) const { return t.find(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, size_type>::type
+    count(const K& x) const { return t.count(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    lower_bound(const K& x) { return t.lower_bound(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    upper_bound(const K& x) { return t.upper_bound(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, pair<iterator, iterator> >::type
+    equal_range(const K& x) { return t.equal_range(x); }
+
+    friend bool operator== __STL_NULL_TMPL_ARGS (const btree_multimap&, const btree_multimap&);
+    friend bool operator< __STL_NULL_TMPL_ARGS (const btree_multimap&, const btree_multimap&);
+};
+
+template <class Key, class T, class Compare, class Alloc>
+inline bool operator==(const btree_multimap<Key, T, Compare, Alloc>& x,
+                       const btree_multimap<Key, T, Compare, Alloc>& y)
+{
+    return x.t == y.t;
+}
+
+template <class Key, class T, class Compare, class Alloc>
+inline bool operator<(const btree_multimap<Key, T, Compare, Alloc>& x,
+                      const btree_multimap<Key, T, Compare, Alloc>& y)
+{
+    return x.t < y.t;
+}
+
+#endif // SGI_STL_BTREE_MULTIMAP_H
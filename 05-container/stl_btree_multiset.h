@@ -0,0 +1,116 @@
+#ifndef SGI_STL_BTREE_MULTISET_H
+#define SGI_STL_BTREE_MULTISET_H
+
+#include "02-allocator/stl_alloc.h"
+#include "07-functional/stl_function.h"
+#include "05-container/stl_btree.h"
+
+//btree_multiset的接口与multiset相同,只是底层改为B+-tree(见<stl_btree.h>),
+//重复的键值依插入次序排列. 与multiset唯一的语意差异: insert/erase会使既有迭代器失效
+
+template <class Key, class Compare = less<Key>, class Alloc = alloc>
+class btree_multiset;
+
+template <class Key, class Compare, class Alloc>
+inline bool operator==(const btree_multiset<Key, Compare, Alloc>& x,
+                       const btree_multiset<Key, Compare, Alloc>& y);
+template <class Key, class Compare, class Alloc>
+inline bool operator<(const btree_multiset<Key, Compare, Alloc>& x,
+                      const btree_multiset<Key, Compare, Alloc>& y);
+
+template <class Key, class Compare, class Alloc>
+class btree_multiset {
+public:
+    typedef Key key_type;
+    typedef Key value_type;
+    typedef Compare key_compare;
+    typedef Compare value_compare;
+private:
+    typedef btree<key_type, value_type, identity<value_type>, key_compare, Alloc> rep_type;
+    rep_type t; //以B+-tree表现multiset
+public:
+    typedef typename rep_type::const_pointer pointer;
+    typedef typename rep_type::const_pointer const_pointer;
+    typedef typename rep_type::const_reference reference;
+    typedef typename rep_type::const_reference const_reference;
+    //与multiset相同,迭代器不允许写入元素
+    typedef typename rep_type::const_iterator iterator;
+    typedef typename rep_type::const_iterator const_iterator;
+    typedef typename rep_type::size_type size_type;
+    typedef typename rep_type::difference_type difference_type;
+
+    btree_multiset() : t(Compare()) {}
+    explicit btree_multiset(const Compare& comp) : t(comp) {}
+    template <class InputIterator>
+    btree_multiset(InputIterator first, InputIterator last) :
+        t(Compare()) { t.insert_equal(first, last); }
+    template <class InputIterator>
+    btree_multiset(InputIterator first, InputIterator last, const Compare& comp) :
+        t(comp) { t.insert_equal(first, last); }
+
+    //accessors
+    key_compare key_comp() const { return t.key_comp(); }
+    value_compare value_comp() const { return t.key_comp(); }
+    iterator begin() const { return t.begin(); }
+    iterator end() const { return t.end(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    size_type max_size() const { return t.max_size(); }
+    void swap(btree_multiset& x) { t.swap(x.t); }
+
+    //insert/erase
+    iterator insert(const value_type& x) { return t.insert_equal(x); }
+    iterator insert(iterator position, const value_type& x)
+    {
+        typedef typename rep_type::iterator rep_iterator;
+        return t.insert_equal((rep_iterator&)position, x);
+    }
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last) { t.insert_equal(first, last); }
+    //与multiset不同,返回被删元素的下一个位置: 删除会搬移元素,调用者无法自行保留它
+    iterator erase(iterator position)
+    {
+        typedef typename rep_type::iterator rep_iterator;
+        return t.erase((rep_iterator&)position);
+    }
+    size_type erase(const key_type& x) { return t.erase(x); }
+    void erase(iterator first, iterator last)
+    {
+        typedef typename rep_type::iterator rep_iterator;
+        t.erase((rep_iterator&)first, (rep_iterator&)last);
+    }
+    void clear() { t.clear(); }
+
+    //multiset operations
+    iterator find(const key_type& x) const { return t.find(x); }
+    size_type count(const key_type& x) const { return t.count(x); }
+    iterator lower_bound(const key_type& x) const { return t.lower_bound(x); }
+    iterator upper_bound(const key_type& x) const { return t.upper_bound(x); }
+    pair<iterator, iterator> equal_range(const key_type& x) const { return t.equal_range(x); }
+    //异质查找: 仅当Compare透明(如less<void>)时开放,见rb_tree
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    find(const K& x) const { return t.find(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, size_type>::type
+    count(const K& x) const { return t.count(x); }
+
+    friend bool operator== __STL_NULL_TMPL_ARGS (const btree_multiset&, const btree_multiset&);
+    friend bool operator< __STL_NULL_TMPL_ARGS (const btree_multiset&, const btree_multiset&);
+};
+
+template <class Key, class Compare, class Alloc>
+inline bool operator==(const btree_multiset<Key, Compare, Alloc>& x,
+                       const btree_multiset<Key, Compare, Alloc>& y)
+{
+    return x.t == y.t;
+}
+
+template <class Key, class Compare, class Alloc>
+inline bool operator<(const btree_multiset<Key, Compare, Alloc>& x,
+                      const btree_multiset<Key, Compare, Alloc>& y)
+{
+    return x.t < y.t;
+}
+
+#endif // SGI_STL_BTREE_MULTISET_H
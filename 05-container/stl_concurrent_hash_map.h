@@ -0,0 +1,453 @@
+#ifndef SGI_STL_CONCURRENT_HASH_MAP_H
+#define SGI_STL_CONCURRENT_HASH_MAP_H
+
+#include <stddef.h>
+#include "01-config/stl_config.h"
+#include "01-config/stl_threads.h"
+#include "02-allocator/stl_alloc.h"
+#include "02-allocator/stl_construct.h"
+#include "05-container/stl_pair.h"
+#include "05-container/stl_hash_fun.h"
+
+/*
+ * concurrent_hash_map: 可供多线程同时读写的hash map(lock striping)
+ *
+ * hashtable(以及hash_map/hash_set)完全不考虑多线程,共享时只能在外面包一把读写锁,
+ * 于是所有写入互相串行,连读取也要在同一个锁字上争抢cache line.
+ *
+ * 这里把整个表切成若干个segment(段),每段是一个独立的小hashtable,
+ * 拥有自己的锁、bucket数组与元素计数:
+ *   键值的hash先经__stl_hash_mix打散,高位决定segment,低位决定segment内的bucket
+ *   find/insert/insert_or_assign/erase只锁住键值所属的那一段
+ *   某一段的负载过高时,由当时持有该段锁的线程独自把该段的bucket数加倍,
+ *   其他段照常读写,所以重建(resize)本身也是并发进行的,不会有全表停顿
+ * segment个数取"线程数的4倍"并进位为2的幂,两个线程落在同一段上的机率因而很低.
+ * 每段独占若干条cache line,相邻两段的锁与计数不会互相false sharing.
+ *
+ * 与hash_map的接口差异: 元素随时可能被其他线程删除,所以不提供迭代器,
+ * 也不返回元素的reference. find(k, x)把找到的值复制到x; 需要"读-改-写"时
+ * 以visit(k, f)在锁内对元素调用f. size()/empty()只是瞬间快照.
+ *
+ * 注意: SGI的alloc(第二级配置器)在这份源码中并未加锁,所以缺省改用malloc_alloc.
+ */
+
+template <class Value>
+struct __concurrent_hash_node {
+    __concurrent_hash_node* next;
+    size_t hash_code; //打散后的hash值,重建与比对时免去再次计算
+    Value val;
+};
+
+template <class Key, class T, class HashFcn = hash<Key>,
+          class EqualKey = equal_to<Key>, class Alloc = malloc_alloc>
+class concurrent_hash_map {
+public:
+    typedef Key key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef pair<const Key, T> value_type;
+    typedef HashFcn hasher;
+    typedef EqualKey key_equal;
+    typedef size_t size_type;
+protected:
+    typedef __concurrent_hash_node<value_type> node;
+    typedef simple_alloc<node, Alloc> node_allocator;
+    typedef simple_alloc<node*, Alloc> bucket_allocator;
+    typedef __stl_auto_lock<__stl_mutex_lock> scoped_lock;
+
+    //segment内的bucket数恒为2的幂,负载因子超过1即加倍
+    struct segment {
+        __stl_mutex_lock lock;
+        node** buckets;
+        size_type num_buckets;
+        volatile size_type num_elements;
+        char pad[__STL_CACHE_LINE_SIZE];
+    };
+    typedef simple_alloc<segment, Alloc> segment_allocator;
+
+    enum { __min_segment_buckets = 8 };
+
+    segment* segments;
+    size_type num_segments; //2的幂
+    size_type segment_shift; //hash值右移segment_shift位即为segment编号
+    hasher hash;
+    key_equal equals;
+public:
+    //n: 预计的元素个数; threads: 预计同时访问的线程数
+    explicit concurrent_hash_map(size_type n = 0,
+                                 size_type threads = __stl_hardware_concurrency(),
+                                 const hasher& hf = hasher(),
+                                 const key_equal& eql = key_equal())
+        : segments(0), num_segments(0), segment_shift(0), hash(hf), equals(eql)
+    {
+        initialize_segments(n, threads);
+    }
+    ~concurrent_hash_map()
+    {
+        clear();
+        destroy_segments(num_segments);
+    }
+
+    hasher hash_funct() const { return hash; }
+    key_equal key_eq() const { return equals; }
+
+    size_type size() const
+    {
+        size_type n = 0;
+        for (size_type i = 0; i < num_segments; ++i)
+            n += __stl_atomic_load(&segments[i].num_elements);
+        return n;
+    }
+    bool empty() const { return size() == 0; }
+    size_type segment_count() const { return num_segments; }
+
+    //键值不存在时插入obj,返回是否插入
+    bool insert(const value_type& obj)
+    {
+        const size_t h = hash_of(obj.first);
+        segment& s = segment_of(h);
+        scoped_lock guard(s.lock);
+        if (find_node(s, obj.first, h))
+            return false;
+        insert_node(s, obj, h);
+        return true;
+    }
+
+    //键值不存在时插入(k, v),已存在时以v取代旧值;返回是否为新插入
+    bool insert_or_assign(const key_type& k, const data_type& v)
+    {
+        const size_t h = hash_of(k);
+        segment& s = segment_of(h);
+        scoped_lock guard(s.lock);
+        node* cur = find_node(s, k, h);
+        if (cur) {
+            cur->val.second = v;
+            return false;
+        }
+        insert_node(s, value_type(k, v), h);
+        return true;
+    }
+
+    //找到时把值复制到x并返回true
+    bool find(const key_type& k, data_type& x) const
+    {
+        const size_t h = hash_of(k);
+        segment& s = segment_of(h);
+        scoped_lock guard(s.lock);
+        node* cur = find_node(s, k, h);
+        if (!cur)
+            return false;
+        x = cur->val.second;
+        return true;
+    }
+
+    size_type count(const key_type& k) const
+    {
+        const size_t h = hash_of(k);
+        segment& s = segment_of(h);
+        scoped_lock guard(s.lock);
+        return find_node(s, k, h) ? 1 : 0;
+    }
+
+    //在segment锁内对k所在的元素调用f(value_type&),供原子的"读-改-写"使用.
+    //f不可再存取同一个concurrent_hash_map(会在同一把锁上自我死锁)
+    template <class Function>
+    bool visit(const key_type& k, Function f)
+    {
+        const size_t h = hash_of(k);
+        segment& s = segment_of(h);
+        scoped_lock guard(s.lock);
+        node* cur = find_node(s, k, h);
+        if (!cur)
+            return false;
+        f(cur->val);
+        return true;
+    }
+
+    //返回是否确实删除了元素
+    bool erase(const key_type& k)
+    {
+        const size_t h = hash_of(k);
+        segment& s = segment_of(h);
+        node* victim = 0;
+        {
+            scoped_lock guard(s.lock);
+            node** link = &s.buckets[h & (s.num_buckets - 1)];
+            for (; *link; link = &(*link)->next)
+                if ((*link)->hash_code == h && equals((*link)->val.first, k))
+                    break;
+            victim = *link;
+            if (!victim)
+                return false;
+            *link = victim->next;
+            __stl_atomic_store(&s.num_elements, s.num_elements - 1);
+        }
+        destroy_node(victim); //节点已摘下,解构与归还可以在锁外进行
+        return true;
+    }
+
+    //逐段清空;与其他线程的插入交错时,清空后未必为空
+    void clear()
+    {
+        for (size_type i = 0; i < num_segments; ++i) {
+            segment& s = segments[i];
+            scoped_lock guard(s.lock);
+            for (size_type b = 0; b < s.num_buckets; ++b) {
+                node* cur = s.buckets[b];
+                while (cur) {
+                    node* next = cur->next;
+                    destroy_node(cur);
+                    cur = next;
+                }
+                s.buckets[b] = 0;
+            }
+            __stl_atomic_store(&s.num_elements, size_type(0));
+        }
+    }
+
+    //让每一段都足以容纳n / segment_count()个元素而不必重建
+    void reserve(size_type n)
+    {
+        const size_type per_segment = n / num_segments + 1;
+        for (size_type i = 0; i < num_segments; ++i) {
+            segment& s = segments[i];
+            scoped_lock guard(s.lock);
+            if (per_segment > s.num_buckets)
+                resize_segment(s, next_power_of_two(per_segment));
+        }
+    }
+
+    //逐段在锁内对每个元素调用f(value_type&).
+    //所见的是每一段各自的一致状态,而非整个表某一瞬间的快照
+    template <class Function>
+    void for_each(Function f)
+    {
+        for (size_type i = 0; i < num_segments; ++i) {
+            segment& s = segments[i];
+            scoped_lock guard(s.lock);
+            for (size_type b = 0; b < s.num_buckets; ++b)
+                for (node* cur = s.buckets[b]; cur; cur = cur->next)
+                    f(cur->val);
+        }
+    }
+protected:
+    size_t hash_of(const key_type& k) const { return __stl_hash_mix(hash(k)); }
+    //高位选segment,低位选bucket,两者互不相关
+    segment& segment_of(size_t h) const { return segments[h >> segment_shift]; }
+
+    static size_type next_power_of_two(size_type n)
+    {
+        size_type p = 1;
+        while (p < n)
+            p <<= 1;
+        return p;
+    }
+
+    //调用者必须持有s的锁
+    node* find_node(const segment& s, const key_type& k, size_t h) const
+    {
+        node* cur = s.buckets[h & (s.num_buckets - 1)];
+        for (; cur; cur = cur->next)
+            if (cur->hash_code == h && equals(cur->val.first, k))
+                return cur;
+        return 0;
+    }
+
+    //调用者必须持有s的锁,且确定键值不存在
+    void insert_node(segment& s, const value_type& obj, size_t h)
+    {
+        if (s.num_elements + 1 > s.num_buckets)
+            resize_segment(s, s.num_buckets * 2);
+        node* tmp = create_node(obj, h);
+        node** bucket = &s.buckets[h & (s.num_buckets - 1)];
+        tmp->next = *bucket;
+        *bucket = tmp;
+        __stl_atomic_store(&s.num_elements, s.num_elements + 1);
+    }
+
+    //调用者必须持有s的锁.节点原地重新串接,不配置也不复制元素
+    void resize_segment(segment& s, size_type n)
+    {
+        node** tmp = bucket_allocator::allocate(n);
+        for (size_type i = 0; i < n; ++i)
+            tmp[i] = 0;
+        for (size_type b = 0; b < s.num_buckets; ++b) {
+            node* first = s.buckets[b];
+            while (first) {
+                node* next = first->next;
+                node** dest = &tmp[first->hash_code & (n - 1)];
+                first->next = *dest;
+                *dest = first;
+                first = next;
+            }
+        }
+        bucket_allocator::deallocate(s.buckets, s.num_buckets);
+        s.buckets = tmp;
+        s.num_buckets = n;
+    }
+
+    node* create_node(const value_type& obj, size_t h)
+    {
+        node* n = node_allocator::allocate();
+        n->next = 0;
+        n->hash_code = h;
+        __STL_TRY {
+            construct(&n->val, obj);
+        }
+        __STL_UNWIND(node_allocator::deallocate(n));
+        return n;
+    }
+    void destroy_node(node* n)
+    {
+        destory(&n->val);
+        node_allocator::deallocate(n);
+    }
+
+    void initialize_segments(size_type n, size_type threads)
+    {
+        num_segments = next_power_of_two(threads * 4);
+        if (num_segments < 2)
+            num_segments = 2;
+        size_type bits = 0;
+        while ((size_type(1) << bits) < num_segments)
+            ++bits;
+        segment_shift = sizeof(size_t) * 8 - bits;
+
+        size_type per_segment = next_power_of_two(n / num_segments + 1);
+        if (per_segment < __min_segment_buckets)
+            per_segment = __min_segment_buckets;
+
+        segments = segment_allocator::allocate(num_segments);
+        size_type i = 0;
+        __STL_TRY {
+            for (; i < num_segments; ++i) {
+                segment& s = segments[i];
+                s.lock.initialize();
+                s.num_elements = 0;
+                s.num_buckets = per_segment;
+                s.buckets = bucket_allocator::allocate(per_segment);
+                for (size_type b = 0; b < per_segment; ++b)
+                    s.buckets[b] = 0;
+            }
+        }
+        __STL_UNWIND(destroy_segments(i));
+    }
+    //前n个segment已初始化(其中的元素须已清空)
+    void destroy_segments(size_type n)
+    {
+        for (size_type i = 0; i < n; ++i) {
+            bucket_allocator::deallocate(segments[i].buckets, segments[i].num_buckets);
+            segments[i].lock.destroy();
+        }
+        segment_allocator::deallocate(segments, num_segments);
+    }
+private:
+    concurrent_hash_map(const concurrent_hash_map&);
+    concurrent_hash_map& operator=(const concurrent_hash_map&);
+};
+
+#endif // SGI_STL_CONCURRENT_HASH_MAP_H
+
+
+/*
+ * ========= BENCHMARK DEMO ============
+ * 以1,2,4,...直到全部硬件线程,比较"hash_map+pthread_rwlock"与concurrent_hash_map
+ * 在三种负载下的总吞吐量(find/insert_or_assign/erase的比例):
+ *   read-heavy 90/5/5, mixed 50/25/25, write-heavy 10/45/45
+ * 键值取自固定范围,表的大小因而维持在稳定状态. 编译时需定义_PTHREADS并链接-lpthread
+
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/time.h>
+
+const size_t ops_per_thread = 2000000;
+const unsigned key_range = 1u << 20;
+
+struct locked_map {
+    hash_map<unsigned, unsigned> m;
+    pthread_rwlock_t rw;
+    locked_map() { pthread_rwlock_init(&rw, 0); }
+    bool find(unsigned k, unsigned& v)
+    {
+        pthread_rwlock_rdlock(&rw);
+        hash_map<unsigned, unsigned>::iterator it = m.find(k);
+        bool ok = it != m.end();
+        if (ok) v = it->second;
+        pthread_rwlock_unlock(&rw);
+        return ok;
+    }
+    void insert_or_assign(unsigned k, unsigned v)
+    {
+        pthread_rwlock_wrlock(&rw); m[k] = v; pthread_rwlock_unlock(&rw);
+    }
+    void erase(unsigned k)
+    {
+        pthread_rwlock_wrlock(&rw); m.erase(k); pthread_rwlock_unlock(&rw);
+    }
+};
+
+template <class M>
+struct worker_arg { M* m; unsigned read_pct; unsigned insert_pct; };
+
+template <class M>
+void* worker(void* p)
+{
+    worker_arg<M>* a = (worker_arg<M>*)p;
+    unsigned v;
+    for (size_t i = 0; i < ops_per_thread; ++i) {
+        unsigned long r = __stl_thread_random();
+        unsigned k = unsigned(r >> 8) % key_range;
+        unsigned op = unsigned(r % 100);
+        if (op < a->read_pct)
+            a->m->find(k, v);
+        else if (op < a->read_pct + a->insert_pct)
+            a->m->insert_or_assign(k, k);
+        else
+            a->m->erase(k);
+    }
+    return 0;
+}
+
+static double now()
+{
+    timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+template <class M>
+double run(M& m, size_t threads, unsigned read_pct, unsigned insert_pct)
+{
+    for (unsigned k = 0; k < key_range; k += 2) //预先填入一半的键值
+        m.insert_or_assign(k, k);
+    pthread_t tid[256];
+    worker_arg<M> arg = { &m, read_pct, insert_pct };
+    double t0 = now();
+    for (size_t i = 0; i < threads; ++i)
+        pthread_create(&tid[i], 0, worker<M>, &arg);
+    for (size_t i = 0; i < threads; ++i)
+        pthread_join(tid[i], 0);
+    return threads * ops_per_thread / (now() - t0) / 1e6;
+}
+
+int main()
+{
+    const char* names[3] = { "read-heavy ", "mixed      ", "write-heavy" };
+    const unsigned reads[3] = { 90, 50, 10 };
+    const unsigned inserts[3] = { 5, 25, 45 };
+    size_t hw = __stl_hardware_concurrency();
+    for (int w = 0; w < 3; ++w) {
+        for (size_t t = 1; ; t *= 2) {
+            if (t > hw) t = hw;
+            locked_map lm;
+            concurrent_hash_map<unsigned, unsigned> cm(key_range, t);
+            double a = run(lm, t, reads[w], inserts[w]);
+            double b = run(cm, t, reads[w], inserts[w]);
+            printf("%s threads=%3zu  rwlock+hash_map %8.2f Mops/s  concurrent_hash_map %8.2f Mops/s\n",
+                   names[w], t, a, b);
+            if (t == hw) break;
+        }
+    }
+}
+
+ */
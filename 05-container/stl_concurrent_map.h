@@ -0,0 +1,682 @@
+#ifndef SGI_STL_CONCURRENT_MAP_H
+#define SGI_STL_CONCURRENT_MAP_H
+
+#include <stddef.h>
+#include "01-config/stl_config.h"
+#include "01-config/stl_threads.h"
+#include "02-allocator/stl_alloc.h"
+#include "02-allocator/stl_construct.h"
+#include "05-container/stl_pair.h"
+#include "07-functional/stl_function.h"
+
+/*
+ * concurrent_map: 可供多线程同时读写的有序map(lock-free skiplist)
+ *
+ * map/set底层的rb_tree完全不考虑多线程;而且插入/删除后的旋转会改动一路往上的祖先,
+ * 很难只锁住局部,只能在外面包一把读写锁,所有写入因而串行.
+ *
+ * skiplist把元素串成一条有序的链表(第0层),每个节点再以1/4的机率逐层往上"晋级",
+ * 高层链表跳过大段元素,查找因而是期望O(log N).它没有旋转: 插入/删除只改动
+ * 节点前后的指针,每一层都可以各自用一次CAS完成(Harris/Fraser的做法):
+ *   删除: 先在节点自己的next指针最低位打上标记(逻辑删除),由上而下逐层标记,
+ *         第0层标记成功的线程即为删除者;被标记的next指针从此冻结,不会再被改动
+ *   摘除: 任何一次查找途中遇到已标记的节点,都顺手以CAS把它从前驱之后摘掉
+ *   插入: 先在第0层以CAS串入(插入成功的那一刻),再逐层往上串接
+ * 读者(find/lower_bound/范围扫描)完全不写入共享数据,只是略过已标记的节点.
+ *
+ * 节点摘除之后,可能还有其他线程正在读它,不能立即归还. 这里以epoch-based reclamation
+ * 延后归还(见__epoch_domain): 每次操作期间登记当时的全局epoch,
+ * 被摘下的节点挂在"退休名单"上,等到所有仍在进行的操作都已登记过更新的epoch,
+ * 就不可能还有人拿着它,这时才真正解构、归还.
+ *
+ * 与map的接口差异: 元素随时可能被其他线程删除,所以不提供迭代器,也不返回reference.
+ * find(k, x)/lower_bound(k, x)把找到的元素复制出来; 范围扫描以for_each_range(first, last, f)
+ * 对每个元素调用f,所见的是"弱一致"的结果(扫描途中其他线程的插入/删除可能看到也可能看不到,
+ * 但不会看到重复或乱序的元素). 元素插入之后不可修改(读者随时在读它),
+ * 要更新请先erase再insert. size()/empty()只是瞬间快照. Compare不可抛出异常.
+ *
+ * 注意: SGI的alloc(第二级配置器)在这份源码中并未加锁,所以缺省改用malloc_alloc.
+ */
+
+/* ============ epoch-based reclamation ============ */
+
+//线程私有的slot提示,让同一线程每次先试同一个slot,该slot的cache line因而留在本核
+inline size_t& __epoch_slot_hint()
+{
+#if defined(__GNUC__)
+    static __thread size_t hint = 0;
+#else
+    static size_t hint = 0;
+#endif
+    if (hint == 0)
+        hint = size_t(__stl_thread_random()) | 1;
+    return hint;
+}
+
+//Node必须有一个Node* limbo_next字段,供串成退休名单
+template <class Node, class Alloc>
+class __epoch_domain {
+protected:
+    //每个进行中的操作占用一个slot;state为0表示闲置,否则为(登记的epoch << 1) | 1.
+    //退休名单依退休时的全局epoch分成三份,由当时占用该slot的线程独自维护
+    struct slot {
+        volatile size_t state;
+        Node* limbo[3];
+        size_t limbo_epoch[3];
+        size_t retired; //自上次尝试推进epoch以来退休的节点数
+        char pad[__STL_CACHE_LINE_SIZE];
+    };
+    typedef simple_alloc<slot, Alloc> slot_allocator;
+
+    //每退休这么多个节点,就尝试推进一次全局epoch
+    enum { __advance_interval = 64 };
+
+    volatile size_t global_epoch;
+    char pad[__STL_CACHE_LINE_SIZE]; //全局epoch经常被读取,别与slots指针挤在同一条cache line
+    slot* slots;
+    size_t num_slots; //2的幂
+    void (*reclaim)(Node*);
+public:
+    //threads: 预计同时访问的线程数
+    __epoch_domain(size_t threads, void (*f)(Node*))
+        : global_epoch(1), slots(0), num_slots(8), reclaim(f)
+    {
+        while (num_slots < threads * 2)
+            num_slots <<= 1;
+        slots = slot_allocator::allocate(num_slots);
+        for (size_t i = 0; i < num_slots; ++i) {
+            slot& s = slots[i];
+            s.state = 0;
+            s.limbo[0] = s.limbo[1] = s.limbo[2] = 0;
+            s.limbo_epoch[0] = s.limbo_epoch[1] = s.limbo_epoch[2] = 0;
+            s.retired = 0;
+        }
+    }
+    //调用时不可再有任何进行中的操作
+    ~__epoch_domain()
+    {
+        for (size_t i = 0; i < num_slots; ++i)
+            for (int j = 0; j < 3; ++j)
+                free_list(slots[i].limbo[j]);
+        slot_allocator::deallocate(slots, num_slots);
+    }
+
+    //在构造时登记目前的epoch,析构时撤销;两者之间读到的节点都不会被归还
+    class guard {
+    private:
+        __epoch_domain& domain;
+        slot* s;
+    public:
+        explicit guard(__epoch_domain& d) : domain(d), s(d.enter()) {}
+        ~guard() { domain.leave(s); }
+        //n必须已从所有共享结构中摘下,此后没有新的读者能再找到它
+        void retire(Node* n) { domain.retire(s, n); }
+    private:
+        guard(const guard&);
+        void operator=(const guard&);
+    };
+protected:
+    slot* enter()
+    {
+        size_t& hint = __epoch_slot_hint();
+        for (size_t i = hint; ; ++i) {
+            slot& s = slots[i & (num_slots - 1)];
+            const size_t e = __stl_atomic_load(&global_epoch);
+            //CAS隐含full barrier: 之后读取的指针一定晚于登记
+            if (s.state == 0 && __stl_atomic_cas(&s.state, size_t(0), (e << 1) | 1)) {
+                hint = i;
+                collect(s, e);
+                return &s;
+            }
+            if (((i + 1 - hint) & (num_slots - 1)) == 0)
+                __stl_cpu_relax(); //所有slot都被占用(同时进行的操作多于slot数),绕一圈后稍候
+        }
+    }
+    void leave(slot* s) { __stl_atomic_store(&s->state, size_t(0)); }
+
+    void retire(slot* s, Node* n)
+    {
+        //以摘除之后的全局epoch为准: 当时还拿着n的操作,登记的epoch都不会比它新
+        const size_t e = __stl_atomic_load(&global_epoch);
+        const size_t i = e % 3;
+        if (s->limbo_epoch[i] != e) { //同余而不相等,必为e-3或更早,早已安全
+            free_list(s->limbo[i]);
+            s->limbo[i] = 0;
+            s->limbo_epoch[i] = e;
+        }
+        n->limbo_next = s->limbo[i];
+        s->limbo[i] = n;
+        if (++s->retired >= __advance_interval) {
+            s->retired = 0;
+            try_advance();
+            collect(*s, __stl_atomic_load(&global_epoch));
+        }
+    }
+
+    //所有进行中的操作都已登记目前的epoch,才能推进到下一个
+    void try_advance()
+    {
+        const size_t e = __stl_atomic_load(&global_epoch);
+        for (size_t i = 0; i < num_slots; ++i) {
+            const size_t st = __stl_atomic_load(&slots[i].state);
+            if (st != 0 && (st >> 1) != e)
+                return;
+        }
+        __stl_atomic_cas(&global_epoch, e, e + 1);
+    }
+
+    //在epoch x退休的节点,等全局epoch到达x + 2时必已无人持有:
+    //推进到x + 2需要所有进行中的操作都登记了x + 1,而持有者登记的epoch不超过x
+    void collect(slot& s, size_t e)
+    {
+        for (int j = 0; j < 3; ++j)
+            if (s.limbo[j] && s.limbo_epoch[j] + 2 <= e) {
+                free_list(s.limbo[j]);
+                s.limbo[j] = 0;
+            }
+    }
+    void free_list(Node* n)
+    {
+        while (n) {
+            Node* next = n->limbo_next;
+            reclaim(n);
+            n = next;
+        }
+    }
+private:
+    __epoch_domain(const __epoch_domain&);
+    void operator=(const __epoch_domain&);
+};
+
+/* ============ skiplist ============ */
+
+//节点的大小随高度而变: next[]实际配置height个
+//next[i]存放第i层后继的地址,最低位为1表示本节点已被删除(该指针从此冻结)
+template <class Value>
+struct __skiplist_node {
+    Value val;
+    __skiplist_node* limbo_next;
+    volatile int link_refs; //插入者串接完毕、删除者摘除完毕各减一,归零者负责退休,见erase()
+    int height;
+    volatile size_t next[1];
+};
+
+//最高层数;晋级机率1/4,足以容纳4^19个元素
+static const int __skiplist_max_height = 20;
+
+template <class Key, class T, class Compare = less<Key>, class Alloc = malloc_alloc>
+class concurrent_map {
+public:
+    typedef Key key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef pair<const Key, T> value_type;
+    typedef Compare key_compare;
+    typedef size_t size_type;
+protected:
+    typedef __skiplist_node<value_type> node;
+    typedef simple_alloc<char, Alloc> byte_allocator;
+    typedef __epoch_domain<node, Alloc> domain_type;
+    typedef typename domain_type::guard guard;
+
+    //范围扫描每走过这么多个元素就重新登记一次epoch,以免长时间的扫描拖住所有节点的归还
+    enum { __scan_batch = 256 };
+
+    node* head; //高度为__skiplist_max_height,不含元素
+    volatile int top_height; //目前用到的最高层数,只增不减
+    volatile size_type num_elements;
+    Compare comp;
+    mutable domain_type epoch;
+public:
+    //threads: 预计同时访问的线程数
+    explicit concurrent_map(size_type threads = __stl_hardware_concurrency(),
+                            const Compare& c = Compare())
+        : head(0), top_height(1), num_elements(0), comp(c), epoch(threads, destroy_node)
+    {
+        head = allocate_node(__skiplist_max_height);
+        for (int i = 0; i < __skiplist_max_height; ++i)
+            head->next[i] = 0;
+    }
+    //调用时不可再有其他线程存取
+    ~concurrent_map()
+    {
+        node* cur = link_node(head->next[0]);
+        while (cur) {
+            node* next = link_node(cur->next[0]);
+            destroy_node(cur);
+            cur = next;
+        }
+        deallocate_node(head);
+    }
+
+    key_compare key_comp() const { return comp; }
+    size_type size() const { return __stl_atomic_load(&num_elements); }
+    bool empty() const { return size() == 0; }
+
+    //键值不存在时插入obj,返回是否插入
+    bool insert(const value_type& obj)
+    {
+        guard g(epoch);
+        const int h = random_height();
+        raise_top_height(h); //先升高,之后的search()才会定位到第h层
+        node* preds[__skiplist_max_height];
+        node* succs[__skiplist_max_height];
+        node* x = 0;
+        for (;;) {
+            if (search(obj.first, preds, succs)) {
+                if (x)
+                    destroy_node(x); //尚未公开,直接归还
+                return false;
+            }
+            if (!x)
+                x = create_node(obj, h);
+            for (int i = 0; i < h; ++i)
+                x->next[i] = size_t(succs[i]);
+            if (__stl_atomic_cas(&preds[0]->next[0], size_t(succs[0]), size_t(x)))
+                break; //插入成功
+        }
+        __stl_atomic_add(&num_elements, size_type(1));
+
+        //逐层往上串接;x一旦被删除就停止,剩下的交给摘除
+        for (int i = 1; i < h; ++i) {
+            for (;;) {
+                const size_t old = x->next[i];
+                if (link_marked(old))
+                    goto linked;
+                if (link_node(old) != succs[i] && !__stl_atomic_cas(&x->next[i], old, size_t(succs[i])))
+                    goto linked; //只可能是刚被标记
+                if (__stl_atomic_cas(&preds[i]->next[i], size_t(succs[i]), size_t(x)))
+                    break;
+                search(x->val.first, preds, succs); //前驱已改变,重新定位
+                if (succs[0] != x)
+                    goto linked; //x已被删除且摘离第0层
+            }
+        }
+    linked:
+        //删除者可能在我们串接上层之前就已摘除完毕,由我们补做
+        if (link_marked(x->next[0]))
+            search(x->val.first, preds, succs);
+        release_link(g, x);
+        return true;
+    }
+
+    //返回是否确实删除了元素
+    bool erase(const key_type& k)
+    {
+        guard g(epoch);
+        node* preds[__skiplist_max_height];
+        node* succs[__skiplist_max_height];
+        if (!search(k, preds, succs))
+            return false;
+        node* x = succs[0];
+        for (int i = x->height - 1; i > 0; --i) { //由上而下标记
+            size_t s = x->next[i];
+            while (!link_marked(s)) {
+                __stl_atomic_cas(&x->next[i], s, s | 1);
+                s = x->next[i];
+            }
+        }
+        for (;;) { //第0层标记成功者才是删除者
+            const size_t s = x->next[0];
+            if (link_marked(s))
+                return false; //其他线程抢先删除了它
+            if (__stl_atomic_cas(&x->next[0], s, s | 1))
+                break;
+        }
+        __stl_atomic_add(&num_elements, size_type(-1));
+        search(k, preds, succs); //把x从各层摘除
+        release_link(g, x);
+        return true;
+    }
+
+    //逐一删除;与其他线程的插入交错时,清空后未必为空
+    void clear()
+    {
+        pair<key_type, data_type> x;
+        while (lower_bound_copy(0, false, x))
+            erase(x.first);
+    }
+
+    //找到时把值复制到x并返回true
+    bool find(const key_type& k, data_type& x) const
+    {
+        guard g(epoch);
+        node* cur = lower_node(k, false);
+        if (!cur || comp(k, cur->val.first))
+            return false;
+        x = cur->val.second;
+        return true;
+    }
+
+    size_type count(const key_type& k) const
+    {
+        guard g(epoch);
+        node* cur = lower_node(k, false);
+        return cur && !comp(k, cur->val.first) ? 1 : 0;
+    }
+
+    //键值不小于k的第一个元素复制到x;不存在时返回false
+    bool lower_bound(const key_type& k, pair<key_type, data_type>& x) const
+    {
+        return lower_bound_copy(&k, false, x);
+    }
+    //键值大于k的第一个元素复制到x;不存在时返回false
+    bool upper_bound(const key_type& k, pair<key_type, data_type>& x) const
+    {
+        return lower_bound_copy(&k, true, x);
+    }
+    //键值最小的元素复制到x;为空时返回false
+    bool front(pair<key_type, data_type>& x) const { return lower_bound_copy(0, false, x); }
+
+    //依键值由小而大,对[first, last)之间的每个元素调用f(const value_type&),返回f.
+    //f在epoch登记期间被调用,应当简短;f可以存取同一个concurrent_map
+    template <class Function>
+    Function for_each_range(const key_type& first, const key_type& last, Function f) const
+    {
+        if (!comp(first, last))
+            return f;
+        key_type from = first;
+        bool strict = false;
+        for (;;) {
+            guard g(epoch);
+            node* cur = lower_node(from, strict);
+            for (int n = 0; cur && comp(cur->val.first, last); cur = next_live(cur)) {
+                f(cur->val);
+                if (++n == __scan_batch) { //从最后一个键值之后接续
+                    from = cur->val.first;
+                    strict = true;
+                    break;
+                }
+            }
+            if (!cur || !comp(cur->val.first, last))
+                return f;
+        }
+    }
+    //对所有元素调用f,规则同for_each_range
+    template <class Function>
+    Function for_each(Function f) const
+    {
+        pair<key_type, data_type> x;
+        if (!front(x))
+            return f;
+        bool strict = false;
+        for (;;) {
+            guard g(epoch);
+            node* cur = lower_node(x.first, strict);
+            for (int n = 0; cur; cur = next_live(cur)) {
+                f(cur->val);
+                if (++n == __scan_batch) {
+                    x.first = cur->val.first;
+                    strict = true;
+                    break;
+                }
+            }
+            if (!cur)
+                return f;
+        }
+    }
+protected:
+    static node* link_node(size_t w) { return (node*)(w & ~size_t(1)); }
+    static bool link_marked(size_t w) { return (w & 1) != 0; }
+
+    static int random_height()
+    {
+        unsigned long r = __stl_thread_random();
+        int h = 1;
+        while (h < __skiplist_max_height && (r & 3) == 0) {
+            ++h;
+            r >>= 2;
+        }
+        return h;
+    }
+    void raise_top_height(int h)
+    {
+        int cur = top_height;
+        while (cur < h && !__stl_atomic_cas(&top_height, cur, h))
+            cur = top_height;
+    }
+
+    //在每一层找出preds[i](键值小于k的最后一个节点)与succs[i](其后继),
+    //途中把已标记的节点摘除;CAS失败表示前驱也已被删除或已改变,从头再来.
+    //返回succs[0]的键值是否为k.
+    //遍历时的读取只依赖数据相依(data dependency)的顺序,以volatile直接读取,
+    //免去每一步一次full barrier;写入则一律经由__stl_atomic_cas
+    bool search(const key_type& k, node** preds, node** succs) const
+    {
+    retry:
+        node* pred = head;
+        for (int i = __stl_atomic_load(&top_height) - 1; i >= 0; --i) {
+            node* cur = link_node(pred->next[i]);
+            while (cur) {
+                size_t succ = cur->next[i];
+                if (link_marked(succ)) {
+                    if (!__stl_atomic_cas(&pred->next[i], size_t(cur), succ & ~size_t(1)))
+                        goto retry;
+                    cur = link_node(succ);
+                    continue;
+                }
+                if (!comp(cur->val.first, k))
+                    break;
+                pred = cur;
+                cur = link_node(succ);
+            }
+            preds[i] = pred;
+            succs[i] = cur;
+        }
+        return succs[0] && !comp(k, succs[0]->val.first);
+    }
+
+    //读者用的查找: 不写入,只略过已标记的节点.
+    //返回第0层第一个键值不小于k(strict时为大于k)且未被删除的节点
+    node* lower_node(const key_type& k, bool strict) const
+    {
+        node* pred = head;
+        node* cur = 0;
+        for (int i = __stl_atomic_load(&top_height) - 1; i >= 0; --i) {
+            cur = link_node(pred->next[i]);
+            while (cur) {
+                const size_t succ = cur->next[i];
+                if (!link_marked(succ)) {
+                    if (strict ? comp(k, cur->val.first) : !comp(cur->val.first, k))
+                        break;
+                    pred = cur;
+                }
+                cur = link_node(succ);
+            }
+        }
+        return cur;
+    }
+    //第0层中x之后第一个未被删除的节点
+    static node* next_live(node* x)
+    {
+        node* cur = link_node(x->next[0]);
+        while (cur && link_marked(cur->next[0]))
+            cur = link_node(cur->next[0]);
+        return cur;
+    }
+
+    //k为0时从最小的元素开始
+    bool lower_bound_copy(const key_type* k, bool strict, pair<key_type, data_type>& x) const
+    {
+        guard g(epoch);
+        node* cur = k ? lower_node(*k, strict) : next_live(head);
+        if (!cur)
+            return false;
+        x.first = cur->val.first;
+        x.second = cur->val.second;
+        return true;
+    }
+
+    //插入者与删除者都完成之后,x才可能已从每一层摘除,由后完成的一方退休
+    void release_link(guard& g, node* x)
+    {
+        if (__stl_atomic_add(&x->link_refs, -1) == 0)
+            g.retire(x);
+    }
+
+    static size_t node_bytes(int h) { return sizeof(node) + (h - 1) * sizeof(size_t); }
+    static node* allocate_node(int h)
+    {
+        node* n = (node*)byte_allocator::allocate(node_bytes(h));
+        n->limbo_next = 0;
+        n->link_refs = 2;
+        n->height = h;
+        return n;
+    }
+    static void deallocate_node(node* n) { byte_allocator::deallocate((char*)n, node_bytes(n->height)); }
+    static node* create_node(const value_type& obj, int h)
+    {
+        node* n = allocate_node(h);
+        __STL_TRY {
+            construct(&n->val, obj);
+        }
+        __STL_UNWIND(deallocate_node(n));
+        return n;
+    }
+    static void destroy_node(node* n)
+    {
+        destory(&n->val);
+        deallocate_node(n);
+    }
+private:
+    concurrent_map(const concurrent_map&);
+    concurrent_map& operator=(const concurrent_map&);
+};
+
+#endif // SGI_STL_CONCURRENT_MAP_H
+
+
+/*
+ * ========= BENCHMARK DEMO ============
+ * 以1,2,4,...直到全部硬件线程,比较"map+pthread_rwlock"与concurrent_map
+ * 在三种负载下的总吞吐量(find/insert/erase的比例),其中find有十分之一改为
+ * 扫描lower_bound之后的16个元素(订单簿取前几档的典型操作):
+ *   read-heavy 90/5/5, mixed 50/25/25, write-heavy 10/45/45
+ * 键值取自固定范围,元素个数因而维持在稳定状态. 编译时需定义_PTHREADS并链接-lpthread
+
+#include <map>
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/time.h>
+
+const size_t ops_per_thread = 1000000;
+const unsigned key_range = 1u << 20;
+
+struct sum_values {
+    unsigned long sum;
+    int n;
+    sum_values() : sum(0), n(0) {}
+    void operator()(const pair<const unsigned, unsigned>& x) { sum += x.second; ++n; }
+};
+
+struct locked_map {
+    std::map<unsigned, unsigned> m;
+    pthread_rwlock_t rw;
+    locked_map() { pthread_rwlock_init(&rw, 0); }
+    bool find(unsigned k, unsigned& v)
+    {
+        pthread_rwlock_rdlock(&rw);
+        std::map<unsigned, unsigned>::iterator it = m.find(k);
+        bool ok = it != m.end();
+        if (ok) v = it->second;
+        pthread_rwlock_unlock(&rw);
+        return ok;
+    }
+    unsigned long scan(unsigned k, int n)
+    {
+        unsigned long sum = 0;
+        pthread_rwlock_rdlock(&rw);
+        std::map<unsigned, unsigned>::iterator it = m.lower_bound(k);
+        for (; it != m.end() && n > 0; ++it, --n)
+            sum += it->second;
+        pthread_rwlock_unlock(&rw);
+        return sum;
+    }
+    void insert(const pair<const unsigned, unsigned>& x)
+    {
+        pthread_rwlock_wrlock(&rw); m.insert(x); pthread_rwlock_unlock(&rw);
+    }
+    void erase(unsigned k)
+    {
+        pthread_rwlock_wrlock(&rw); m.erase(k); pthread_rwlock_unlock(&rw);
+    }
+};
+
+struct lock_free_map : concurrent_map<unsigned, unsigned> {
+    explicit lock_free_map(size_t threads) : concurrent_map<unsigned, unsigned>(threads) {}
+    unsigned long scan(unsigned k, int n) //[k, k + 4n)之间大约有n个元素
+    {
+        return for_each_range(k, k + 4 * n, sum_values()).sum;
+    }
+};
+
+template <class M>
+struct worker_arg { M* m; unsigned read_pct; unsigned insert_pct; };
+
+template <class M>
+void* worker(void* p)
+{
+    worker_arg<M>* a = (worker_arg<M>*)p;
+    unsigned v;
+    unsigned long sum = 0;
+    for (size_t i = 0; i < ops_per_thread; ++i) {
+        unsigned long r = __stl_thread_random();
+        unsigned k = unsigned(r >> 8) % key_range;
+        unsigned op = unsigned(r % 100);
+        if (op < a->read_pct) {
+            if (op % 10 == 0)
+                sum += a->m->scan(k, 16);
+            else
+                a->m->find(k, v);
+        }
+        else if (op < a->read_pct + a->insert_pct)
+            a->m->insert(pair<const unsigned, unsigned>(k, k));
+        else
+            a->m->erase(k);
+    }
+    return (void*)sum;
+}
+
+static double now()
+{
+    timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+template <class M>
+double run(M& m, size_t threads, unsigned read_pct, unsigned insert_pct)
+{
+    for (unsigned k = 0; k < key_range; k += 2) //预先填入一半的键值
+        m.insert(pair<const unsigned, unsigned>(k, k));
+    pthread_t tid[256];
+    worker_arg<M> arg = { &m, read_pct, insert_pct };
+    double t0 = now();
+    for (size_t i = 0; i < threads; ++i)
+        pthread_create(&tid[i], 0, worker<M>, &arg);
+    for (size_t i = 0; i < threads; ++i)
+        pthread_join(tid[i], 0);
+    return threads * ops_per_thread / (now() - t0) / 1e6;
+}
+
+int main()
+{
+    const char* names[3] = { "read-heavy ", "mixed      ", "write-heavy" };
+    const unsigned reads[3] = { 90, 50, 10 };
+    const unsigned inserts[3] = { 5, 25, 45 };
+    size_t hw = __stl_hardware_concurrency();
+    for (int w = 0; w < 3; ++w) {
+        for (size_t t = 1; ; t *= 2) {
+            if (t > hw) t = hw;
+            locked_map lm;
+            lock_free_map cm(t);
+            double a = run(lm, t, reads[w], inserts[w]);
+            double b = run(cm, t, reads[w], inserts[w]);
+            printf("%s threads=%3zu  rwlock+map %8.2f Mops/s  concurrent_map %8.2f Mops/s\n",
+                   names[w], t, a, b);
+            if (t == hw) break;
+        }
+    }
+}
+
+ */
@@ -0,0 +1,176 @@
+#ifndef SGI_STL_FLAT_HASH_MAP_H
+#define SGI_STL_FLAT_HASH_MAP_H
+
+#include "02-allocator/stl_alloc.h"
+#include "05-container/stl_hash_fun.h"
+#include "05-container/stl_flat_hashtable.h"
+
+//flat_hash_map的接口与hash_map相同,只是底层改为开放定址的flat_hashtable.
+//每个pair<const Key, T>直接存放在连续的槽中,省去每个元素一个节点与一个next指针的开销.
+//与hash_map唯一的语意差异: insert可能引发重建而搬移元素,使既有迭代器与元素reference失效
+
+template <class Key,
+          class T,
+          class HashFcn = hash<Key>,
+          class EqualKey = equal_to<Key>,
+          class Alloc = alloc>
+class flat_hash_map;
+
+template <class Key, class T, class HashFcn, class EqualKey, class Alloc>
+inline bool operator==(const flat_hash_map<Key, T, HashFcn, EqualKey, Alloc>& hm1,
+                       const flat_hash_map<Key, T, HashFcn, EqualKey, Alloc>& hm2);
+
+template <class Key, class T, class HashFcn, class EqualKey, class Alloc>
+class flat_hash_map
+{
+private:
+    typedef flat_hashtable<pair<const Key, T>, Key, HashFcn,
+                           select1st<pair<const Key, T> >, EqualKey, Alloc> ht;
+    ht rep; //底层机制以flat hash table完成
+public:
+    typedef typename ht::key_type key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef typename ht::value_type value_type;
+    typedef typename ht::hasher hasher;
+    typedef typename ht::key_equal key_equal;
+
+    typedef typename ht::size_type size_type;
+    typedef typename ht::difference_type difference_type;
+
+    typedef typename ht::pointer pointer;
+    typedef typename ht::iterator iterator;
+    typedef typename ht::reference reference;
+    typedef typename ht::const_pointer const_pointer;
+    typedef typename ht::const_iterator const_iterator;
+    typedef typename ht::const_reference const_reference;
+
+    hasher hash_funct() const { return rep.hash_funct(); }
+    key_equal key_eq() const { return rep.key_eq(); }
+public:
+    //开放定址的表格不必预先配置,n只是预计的元素个数
+    flat_hash_map() : rep(0, hasher(), key_equal()) {}
+    explicit flat_hash_map(size_type n) : rep(n, hasher(), key_equal()) {}
+    flat_hash_map(size_type n, const hasher& hf) : rep(n, hf, key_equal()) {}
+    flat_hash_map(size_type n, const hasher& hf, const key_equal& eql) :
+        rep(n, hf, eql) {}
+
+    template <class InputIterator>
+    flat_hash_map(InputIterator f, InputIterator l) :
+        rep(0, hasher(), key_equal()) { rep.insert_unique(f, l); }
+
+    template <class InputIterator>
+    flat_hash_map(InputIterator f, InputIterator l, size_type n) :
+        rep(n, hasher(), key_equal()) { rep.insert_unique(f, l); }
+
+    template <class InputIterator>
+    flat_hash_map(InputIterator f, InputIterator l, size_type n, const hasher& hf) :
+        rep(n, hf, key_equal()) { rep.insert_unique(f, l); }
+
+    template <class InputIterator>
+    flat_hash_map(InputIterator f, InputIterator l, size_type n,
+                  const hasher& hf, const key_equal& eql) :
+        rep(n, hf, eql) { rep.insert_unique(f, l); }
+public:
+    size_type size() const { return rep.size(); }
+    size_type max_size() const { return rep.max_size(); }
+    bool empty() const { return rep.empty(); }
+    void swap(flat_hash_map& hs) { rep.swap(hs.rep); }
+    friend bool operator== __STL_NULL_TMPL_ARGS (const flat_hash_map&, const flat_hash_map&);
+
+    iterator begin() { return rep.begin(); }
+    iterator end() { return rep.end(); }
+    const_iterator begin() const { return rep.begin(); }
+    const_iterator end() const { return rep.end(); }
+public:
+    pair<iterator, bool> insert(const value_type& obj) { return rep.insert_unique(obj); }
+
+    template <class InputIterator>
+    void insert(InputIterator f, InputIterator l) { rep.insert_unique(f, l); }
+
+    iterator find(const key_type& key) { return rep.find(key); }
+    const_iterator find(const key_type& key) const { return rep.find(key); }
+
+    T& operator[](const key_type& key) {
+        return rep.find_or_insert(value_type(key, T())).second;
+    }
+
+    size_type count(const key_type& key) const { return rep.count(key); }
+    pair<iterator, iterator> equal_range(const key_type& key) { return rep.equal_range(key); }
+    //异质查找: HashFcn与EqualKey皆透明时开放,见hashtable
+    template <class K>
+    typename __enable_if_transparent2<HashFcn, EqualKey, K, iterator>::type
+    find(const K& key) { return rep.find(key); }
+    template <class K>
+    typename __enable_if_transparent2<HashFcn, EqualKey, K, const_iterator>::type
+    find(const K& key) const { return rep.find(key); }
+    template <class K>
+    typename __enable_if_transparent2<HashFcn, EqualKey, K, size_type>::type
+    count(const K& key) const { return rep.count(key); }
+
+    size_type erase(const key_type& key) { return rep.erase(key); }
+    void erase(iterator i) { rep.erase(i); }
+    void erase(iterator f, iterator l) { rep.erase(f, l); }
+    void clear() { rep.clear(); }
+public:
+    void resize(size_type hint) { rep.reserve(hint); }
+    void reserve(size_type n) { rep.reserve(n); }
+    size_type bucket_count() const { return rep.bucket_count(); }
+};
+
+template <class Key, class T, class HashFcn, class EqualKey, class Alloc>
+inline bool operator==(const flat_hash_map<Key, T, HashFcn, EqualKey, Alloc>& hm1,
+                       const flat_hash_map<Key, T, HashFcn, EqualKey, Alloc>& hm2)
+{
+    return hm1.rep == hm2.rep;
+}
+
+#endif // SGI_STL_FLAT_HASH_MAP_H
+
+
+/*
+ * ========= BENCHMARK DEMO ============
+ * 以查找为主的负载: 比较hash_map(separate chaining)与flat_hash_map
+
+#include <hash_map>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+int main()
+{
+    const size_t n = 4000000, lookups = 40000000;
+    vector<unsigned long> keys;
+    for (size_t i = 0; i < n; ++i)
+        keys.push_back(((unsigned long)rand() << 31) ^ rand());
+
+    hash_map<unsigned long, unsigned long> hm;
+    flat_hash_map<unsigned long, unsigned long> fm;
+    for (size_t i = 0; i < n; ++i) {
+        hm[keys[i]] = i;
+        fm[keys[i]] = i;
+    }
+
+    unsigned long sum = 0;
+    clock_t t0 = clock();
+    for (size_t i = 0; i < lookups; ++i)
+        sum += hm.find(keys[(i * 7919) % n])->second;
+    clock_t t1 = clock();
+    for (size_t i = 0; i < lookups; ++i)
+        sum += fm.find(keys[(i * 7919) % n])->second;
+    clock_t t2 = clock();
+
+    printf("hash_map      %6.2f Mlookups/s\n", lookups / (double(t1 - t0) / CLOCKS_PER_SEC) / 1e6);
+    printf("flat_hash_map %6.2f Mlookups/s\n", lookups / (double(t2 - t1) / CLOCKS_PER_SEC) / 1e6);
+    printf("(%lu)\n", sum);
+
+    //记忆体: hash_map每个元素 = 节点(next + pair,8字节对齐) + 约一个bucket指针;
+    //flat_hash_map每个元素 = pair + 1个控制字节,再除以负载(7/8~7/16)
+    printf("hash_map      ~%zu bytes/elem\n",
+           sizeof(void*) + sizeof(pair<const unsigned long, unsigned long>) + sizeof(void*));
+    printf("flat_hash_map ~%zu bytes/elem\n",
+           size_t((sizeof(pair<const unsigned long, unsigned long>) + 1) * fm.bucket_count() / n));
+}
+
+ */
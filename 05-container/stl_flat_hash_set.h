@@ -0,0 +1,123 @@
+#ifndef SGI_STL_FLAT_HASH_SET_H
+#define SGI_STL_FLAT_HASH_SET_H
+
+#include "02-allocator/stl_alloc.h"
+#include "05-container/stl_hash_fun.h"
+#include "05-container/stl_flat_hashtable.h"
+
+//flat_hash_set的接口与hash_set相同,只是底层改为开放定址的flat_hashtable.
+//元素直接存放在连续的槽中,没有节点,适合以查找为主的场合.
+//与hash_set唯一的语意差异: insert可能引发重建而搬移元素,使既有迭代器失效
+
+template <class Value,
+          class HashFcn = hash<Value>,
+          class EqualKey = equal_to<Value>,
+          class Alloc = alloc>
+class flat_hash_set;
+
+template <class Value, class HashFcn, class EqualKey, class Alloc>
+inline bool operator==(const flat_hash_set<Value, HashFcn, EqualKey, Alloc>& hs1,
+                       const flat_hash_set<Value, HashFcn, EqualKey, Alloc>& hs2);
+
+template <class Value, class HashFcn, class EqualKey, class Alloc>
+class flat_hash_set {
+private:
+    typedef flat_hashtable<Value, Value, HashFcn, identity<Value>, EqualKey, Alloc> ht;
+    ht rep; //底层机制以flat hash table完成
+public:
+    typedef typename ht::key_type key_type;
+    typedef typename ht::value_type value_type;
+    typedef typename ht::hasher hasher;
+    typedef typename ht::key_equal key_equal;
+
+    typedef typename ht::size_type size_type;
+    typedef typename ht::difference_type difference_type;
+    typedef typename ht::const_pointer pointer;
+    typedef typename ht::const_pointer const_pointer;
+    typedef typename ht::const_reference reference;
+    typedef typename ht::const_reference const_reference;
+    typedef typename ht::const_iterator iterator;
+    typedef typename ht::const_iterator const_iterator;
+
+    hasher hash_funct() const { return rep.hash_funct(); }
+    key_equal key_eq() const { return rep.key_eq(); }
+public:
+    //开放定址的表格不必预先配置,n只是预计的元素个数
+    flat_hash_set() : rep(0, hasher(), key_equal()) {}
+    explicit flat_hash_set(size_type n) : rep(n, hasher(), key_equal()) {}
+    flat_hash_set(size_type n, const hasher& hf) : rep(n, hf, key_equal()) {}
+    flat_hash_set(size_type n, const hasher& hf, const key_equal& eql) : rep(n, hf, eql) {}
+
+    template <class InputIterator>
+    flat_hash_set(InputIterator f, InputIterator l) :
+        rep(0, hasher(), key_equal()) { rep.insert_unique(f, l); }
+
+    template <class InputIterator>
+    flat_hash_set(InputIterator f, InputIterator l, size_type n) :
+        rep(n, hasher(), key_equal()) { rep.insert_unique(f, l); }
+
+    template <class InputIterator>
+    flat_hash_set(InputIterator f, InputIterator l, size_type n, const hasher& hf) :
+        rep(n, hf, key_equal()) { rep.insert_unique(f, l); }
+
+    template <class InputIterator>
+    flat_hash_set(InputIterator f, InputIterator l, size_type n,
+                  const hasher& hf, const key_equal& eql) :
+        rep(n, hf, eql) { rep.insert_unique(f, l); }
+public:
+    size_type size() const { return rep.size(); }
+    size_type max_size() const { return rep.max_size(); }
+    bool empty() const { return rep.empty(); }
+    void swap(flat_hash_set& hs) { rep.swap(hs.rep); }
+    friend bool operator== __STL_NULL_TMPL_ARGS (const flat_hash_set&, const flat_hash_set&);
+
+    iterator begin() const { return rep.begin(); }
+    iterator end() const { return rep.end(); }
+public:
+    pair<iterator, bool> insert(const value_type& obj)
+    {
+        pair<typename ht::iterator, bool> p = rep.insert_unique(obj);
+        return pair<iterator, bool>(p.first, p.second);
+    }
+
+    template <class InputIterator>
+    void insert(InputIterator f, InputIterator l) { rep.insert_unique(f, l); }
+
+    iterator find(const key_type& key) const { return rep.find(key); }
+    size_type count(const key_type& key) const { return rep.count(key); }
+    pair<iterator, iterator> equal_range(const key_type& key) const
+    {
+        iterator first = find(key);
+        iterator last = first;
+        if (first != end())
+            ++last;
+        return pair<iterator, iterator>(first, last);
+    }
+    //异质查找: HashFcn与EqualKey皆透明时开放,见hashtable
+    template <class K>
+    typename __enable_if_transparent2<HashFcn, EqualKey, K, iterator>::type
+    find(const K& key) const { return rep.find(key); }
+    template <class K>
+    typename __enable_if_transparent2<HashFcn, EqualKey, K, size_type>::type
+    count(const K& key) const { return rep.count(key); }
+    size_type erase(const key_type& key) { return rep.erase(key); }
+    void erase(iterator i)
+    {
+        typedef typename ht::iterator rep_iterator;
+        rep.erase(rep_iterator(const_cast<__flat_ctrl_t*>(i.ctrl), const_cast<Value*>(i.slot)));
+    }
+    void clear() { rep.clear(); }
+public:
+    void resize(size_type hint) { rep.reserve(hint); }
+    void reserve(size_type n) { rep.reserve(n); }
+    size_type bucket_count() const { return rep.bucket_count(); }
+};
+
+template <class Value, class HashFcn, class EqualKey, class Alloc>
+inline bool operator==(const flat_hash_set<Value, HashFcn, EqualKey, Alloc>& hs1,
+                       const flat_hash_set<Value, HashFcn, EqualKey, Alloc>& hs2)
+{
+    return hs1.rep == hs2.rep;
+}
+
+#endif // SGI_STL_FLAT_HASH_SET_H
@@ -0,0 +1,530 @@
+#ifndef SGI_STL_FLAT_HASHTABLE_H
+#define SGI_STL_FLAT_HASHTABLE_H
+
+#include <stddef.h>
+#include <string.h> // memcpy, memset
+#include "01-config/stl_config.h"
+#include "02-allocator/stl_alloc.h"
+#include "02-allocator/stl_construct.h"
+#include "03-iterator/stl_iterator.h"
+#include "05-container/stl_pair.h"
+#include "05-container/stl_hash_fun.h" // __stl_hash_mix
+#include "03-iterator/type_traits.h" // __enable_if_transparent2
+#include "06-algorithms/stl_algobase.h"
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+/*
+ * flat_hashtable: 开放定址(open addressing)的hash table,与<stl_hashtable.h>并存
+ *
+ * hashtable采用separate chaining: 每个元素一个节点(node_allocator::allocate()),
+ * buckets是vector<node*>,所以每次find至少追两个指针(bucket -> node -> ...).
+ * flat_hashtable仿照Swiss table的设计:
+ *
+ *   slots: 一块连续空间,元素直接(inline)存放其中,没有节点,没有next指针
+ *   ctrl:  与slots一一对应的控制字节(control byte):
+ *            0x80 (empty)    空槽
+ *            0xFE (deleted)  已删除(tombstone)
+ *            0xFF (sentinel) 只出现在ctrl[capacity],供迭代器判断结尾
+ *            0x00~0x7F       满槽,值为该元素hash值的低7位(H2)
+ *
+ *   hash值拆成两段: H1 = hash >> 7 决定从哪一组(group)开始探测,H2 = hash & 0x7F 存入ctrl.
+ *   每组__flat_group_width个控制字节,探测时一次比较一整组:
+ *     SSE2: 16字节,以_mm_cmpeq_epi8/_mm_movemask_epi8一次得到16个比较结果
+ *     其他: 8字节,以64位整数做SWAR(SIMD within a register)比较
+ *   只有H2相符的槽才需要真正调用equals比较键值,所以失败的查找几乎不碰元素本身.
+ *   一组之中只要出现empty,探测即可停止(插入时不会越过含有empty的组).
+ *   组与组之间以三角数序列(+1,+2,+3,...)跳跃,组数为2的幂,保证走遍所有组.
+ *
+ * 负载上限为7/8;删除时若所在组内另有empty就直接标为empty,否则标为deleted.
+ * deleted过多时原地重建(容量不变),否则容量加倍.
+ *
+ * 与hashtable的差异: 重建时元素会被搬移,所以insert可能使所有迭代器与元素指针失效.
+ */
+
+typedef signed char __flat_ctrl_t;
+const __flat_ctrl_t __flat_ctrl_empty = -128;   //0x80
+const __flat_ctrl_t __flat_ctrl_deleted = -2;   //0xFE
+const __flat_ctrl_t __flat_ctrl_sentinel = -1;  //0xFF
+
+//一组控制字节的比较结果: 每个命中的槽对应一个位元,以next()逐一取出组内序号
+#if defined(__SSE2__)
+
+enum { __flat_group_width = 16 };
+
+struct __flat_bitmask {
+    unsigned int mask;
+    explicit __flat_bitmask(unsigned int m) : mask(m) {}
+    operator bool() const { return mask != 0; }
+    size_t lowest() const { return __builtin_ctz(mask); }
+    size_t next() { size_t i = lowest(); mask &= mask - 1; return i; }
+};
+
+struct __flat_group {
+    __m128i ctrl;
+    explicit __flat_group(const __flat_ctrl_t* p)
+        : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) {}
+    //控制字节等于h2的槽
+    __flat_bitmask match(__flat_ctrl_t h2) const
+    {
+        return __flat_bitmask(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl)));
+    }
+    __flat_bitmask match_empty() const
+    {
+        return __flat_bitmask(_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_set1_epi8(__flat_ctrl_empty), ctrl)));
+    }
+    //empty与deleted的最高位皆为1,满槽为0
+    __flat_bitmask match_empty_or_deleted() const
+    {
+        return __flat_bitmask(_mm_movemask_epi8(ctrl));
+    }
+};
+
+#else // 可携版本: 64位整数一次处理8个控制字节(假设little-endian)
+
+enum { __flat_group_width = 8 };
+
+struct __flat_bitmask {
+    unsigned long long mask; //每个命中字节的最高位为1
+    explicit __flat_bitmask(unsigned long long m) : mask(m) {}
+    operator bool() const { return mask != 0; }
+    size_t lowest() const
+    {
+        size_t n = 0;
+        for (unsigned long long m = mask; !(m & 0x80); m >>= 8)
+            ++n;
+        return n;
+    }
+    size_t next() { size_t i = lowest(); mask &= mask - 1; return i; }
+};
+
+struct __flat_group {
+    unsigned long long ctrl;
+    static unsigned long long lsbs() { return 0x0101010101010101ULL; }
+    static unsigned long long msbs() { return 0x8080808080808080ULL; }
+    explicit __flat_group(const __flat_ctrl_t* p) { memcpy(&ctrl, p, sizeof(ctrl)); }
+    //经典的"找出等于某值的字节"技巧,可能有伪命中(false positive),但之后还会比较键值
+    __flat_bitmask match(__flat_ctrl_t h2) const
+    {
+        unsigned long long x = ctrl ^ (lsbs() * (unsigned char)h2);
+        return __flat_bitmask((x - lsbs()) & ~x & msbs());
+    }
+    //empty(0x80)是唯一"最高位为1且第1位为0"的值
+    __flat_bitmask match_empty() const { return __flat_bitmask(ctrl & ~(ctrl << 6) & msbs()); }
+    __flat_bitmask match_empty_or_deleted() const
+    {
+        return __flat_bitmask(ctrl & ~(ctrl << 7) & msbs());
+    }
+};
+
+#endif // __SSE2__
+
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc>
+class flat_hashtable;
+
+template <class Value, class Ref, class Ptr>
+struct __flat_hashtable_iterator {
+    typedef __flat_hashtable_iterator<Value, Value&, Value*> iterator;
+    typedef __flat_hashtable_iterator<Value, const Value&, const Value*> const_iterator;
+    typedef __flat_hashtable_iterator<Value, Ref, Ptr> self;
+
+    typedef forward_iterator_tag iterator_category;
+    typedef Value value_type;
+    typedef ptrdiff_t difference_type;
+    typedef size_t size_type;
+    typedef Ref reference;
+    typedef Ptr pointer;
+
+    const __flat_ctrl_t* ctrl; //目前所指槽的控制字节
+    Value* slot;               //目前所指的槽
+
+    __flat_hashtable_iterator() {}
+    __flat_hashtable_iterator(const __flat_ctrl_t* c, Value* s) : ctrl(c), slot(s) {}
+    __flat_hashtable_iterator(const iterator& it) : ctrl(it.ctrl), slot(it.slot) {}
+
+    reference operator*() const { return *slot; }
+    pointer operator->() const { return &(operator*()); }
+    self& operator++()
+    {
+        ++ctrl;
+        ++slot;
+        skip_empty_slots();
+        return *this;
+    }
+    self operator++(int) { self tmp = *this; ++*this; return tmp; }
+    bool operator==(const self& x) const { return ctrl == x.ctrl; }
+    bool operator!=(const self& x) const { return ctrl != x.ctrl; }
+
+    //跳过empty与deleted,停在下一个满槽或ctrl[capacity]的sentinel上
+    void skip_empty_slots()
+    {
+        while (*ctrl < 0 && *ctrl != __flat_ctrl_sentinel) {
+            ++ctrl;
+            ++slot;
+        }
+    }
+};
+
+//Value, Key, HashFcn, ExtractKey, EqualKey, Alloc的意义与hashtable完全相同
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc = alloc>
+class flat_hashtable {
+public:
+    typedef Key key_type;
+    typedef Value value_type;
+    typedef HashFcn hasher;
+    typedef EqualKey key_equal;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+
+    typedef __flat_hashtable_iterator<Value, Value&, Value*> iterator;
+    typedef __flat_hashtable_iterator<Value, const Value&, const Value*> const_iterator;
+private:
+    typedef simple_alloc<value_type, Alloc> slot_allocator;
+    typedef simple_alloc<__flat_ctrl_t, Alloc> ctrl_allocator;
+
+    hasher hash;
+    key_equal equals;
+    ExtractKey get_key;
+
+    __flat_ctrl_t* ctrl;    //capacity+1个控制字节,最后一个是sentinel
+    value_type* slots;      //capacity个槽,只有满槽才构造了元素
+    size_type capacity;     //槽数: 0或__flat_group_width乘以2的幂
+    size_type num_elements;
+    size_type growth_left;  //在必须重建之前还能再占用几个empty槽
+public:
+    flat_hashtable(size_type n, const HashFcn& hf, const EqualKey& eql)
+        : hash(hf), equals(eql), get_key(ExtractKey()),
+          ctrl(empty_ctrl()), slots(0), capacity(0), num_elements(0), growth_left(0)
+    {
+        reserve(n);
+    }
+    flat_hashtable(const flat_hashtable& ht)
+        : hash(ht.hash), equals(ht.equals), get_key(ht.get_key),
+          ctrl(empty_ctrl()), slots(0), capacity(0), num_elements(0), growth_left(0)
+    {
+        copy_from(ht);
+    }
+    flat_hashtable& operator=(const flat_hashtable& ht)
+    {
+        if (&ht != this) {
+            clear();
+            hash = ht.hash;
+            equals = ht.equals;
+            get_key = ht.get_key;
+            copy_from(ht);
+        }
+        return *this;
+    }
+    ~flat_hashtable() { clear(); deallocate_arrays(); }
+
+    size_type size() const { return num_elements; }
+    size_type max_size() const { return size_type(-1) / sizeof(value_type); }
+    bool empty() const { return size() == 0; }
+    //对开放定址而言,"bucket"就是槽
+    size_type bucket_count() const { return capacity; }
+    hasher hash_funct() const { return hash; }
+    key_equal key_eq() const { return equals; }
+
+    void swap(flat_hashtable& ht)
+    {
+        __STD::swap(hash, ht.hash);
+        __STD::swap(equals, ht.equals);
+        __STD::swap(get_key, ht.get_key);
+        __STD::swap(ctrl, ht.ctrl);
+        __STD::swap(slots, ht.slots);
+        __STD::swap(capacity, ht.capacity);
+        __STD::swap(num_elements, ht.num_elements);
+        __STD::swap(growth_left, ht.growth_left);
+    }
+
+    iterator begin()
+    {
+        iterator it(ctrl, slots);
+        it.skip_empty_slots();
+        return it;
+    }
+    iterator end() { return iterator(ctrl + capacity, slots + capacity); }
+    const_iterator begin() const { return const_cast<flat_hashtable*>(this)->begin(); }
+    const_iterator end() const { return const_cast<flat_hashtable*>(this)->end(); }
+
+    iterator find(const key_type& key)
+    {
+        size_type i = find_index(key, hash_of(key));
+        return i == capacity ? end() : iterator(ctrl + i, slots + i);
+    }
+    const_iterator find(const key_type& key) const
+    {
+        return const_cast<flat_hashtable*>(this)->find(key);
+    }
+    size_type count(const key_type& key) const
+    {
+        return find_index(key, hash_of(key)) == capacity ? 0 : 1;
+    }
+    pair<iterator, iterator> equal_range(const key_type& key)
+    {
+        iterator first = find(key);
+        iterator last = first;
+        if (first != end())
+            ++last;
+        return pair<iterator, iterator>(first, last);
+    }
+
+    //异质查找: HashFcn与EqualKey皆透明时开放,用户须保证hash(k)与hash(Key(k))相等
+    template <class K>
+    typename __enable_if_transparent2<HashFcn, EqualKey, K, iterator>::type
+    find(const K& key)
+    {
+        size_type i = find_index(key, hash_of(key));
+        return i == capacity ? end() : iterator(ctrl + i, slots + i);
+    }
+    template <class K>
+    typename __enable_if_transparent2<HashFcn, EqualKey, K, const_iterator>::type
+    find(const K& key) const
+    {
+        return const_cast<flat_hashtable*>(this)->find(key);
+    }
+    template <class K>
+    typename __enable_if_transparent2<HashFcn, EqualKey, K, size_type>::type
+    count(const K& key) const
+    {
+        return find_index(key, hash_of(key)) == capacity ? 0 : 1;
+    }
+
+    //插入元素,不允许重复
+    pair<iterator, bool> insert_unique(const value_type& obj)
+    {
+        const key_type& k = get_key(obj);
+        const size_t h = hash_of(k);
+        size_type i = find_index(k, h);
+        if (i != capacity)
+            return pair<iterator, bool>(iterator(ctrl + i, slots + i), false);
+        i = prepare_insert(h);
+        construct(slots + i, obj);
+        set_ctrl(i, h2(h));
+        ++num_elements;
+        return pair<iterator, bool>(iterator(ctrl + i, slots + i), true);
+    }
+
+    template <class InputIterator>
+    void insert_unique(InputIterator f, InputIterator l)
+    {
+        for (; f != l; ++f)
+            insert_unique(*f);
+    }
+
+    //若键值不存在就插入obj,返回元素的reference(供hash_map::operator[]使用)
+    reference find_or_insert(const value_type& obj) { return *insert_unique(obj).first; }
+
+    size_type erase(const key_type& key)
+    {
+        size_type i = find_index(key, hash_of(key));
+        if (i == capacity)
+            return 0;
+        erase_index(i);
+        return 1;
+    }
+    void erase(const iterator& it) { erase_index(size_type(it.slot - slots)); }
+    void erase(iterator first, iterator last)
+    {
+        while (first != last)
+            erase(first++); //删除只改控制字节,不搬移其他元素,所以first++仍然有效
+    }
+
+    void clear()
+    {
+        for (size_type i = 0; i < capacity; ++i)
+            if (is_full(ctrl[i]))
+                destory(slots + i);
+        if (capacity) {
+            memset(ctrl, __flat_ctrl_empty, capacity);
+            ctrl[capacity] = __flat_ctrl_sentinel;
+        }
+        num_elements = 0;
+        growth_left = max_load(capacity);
+    }
+
+    //确保容纳n个元素之前不必重建
+    void reserve(size_type n)
+    {
+        if (n > num_elements + growth_left)
+            rehash(capacity_for(n));
+    }
+private:
+    static bool is_full(__flat_ctrl_t c) { return c >= 0; }
+    static __flat_ctrl_t h2(size_t h) { return __flat_ctrl_t(h & 0x7F); }
+    static size_t h1(size_t h) { return h >> 7; }
+    template <class K>
+    size_t hash_of(const K& k) const { return __stl_hash_mix(hash(k)); }
+
+    //容量为capacity时最多可容纳的元素个数(7/8负载)
+    static size_type max_load(size_type cap) { return cap - cap / 8; }
+    //容纳n个元素所需的最小容量: __flat_group_width乘以2的幂
+    static size_type capacity_for(size_type n)
+    {
+        size_type cap = __flat_group_width;
+        while (max_load(cap) < n)
+            cap *= 2;
+        return cap;
+    }
+
+    //容量为0时ctrl指向一个只含sentinel的静态字节,使begin()==end()且不必特判
+    static __flat_ctrl_t* empty_ctrl()
+    {
+        static __flat_ctrl_t sentinel = __flat_ctrl_sentinel;
+        return &sentinel;
+    }
+
+    //找出键值为key的槽,找不到则返回capacity
+    template <class K>
+    size_type find_index(const K& key, size_t h) const
+    {
+        if (capacity == 0)
+            return capacity;
+        const size_type group_mask = capacity / __flat_group_width - 1;
+        size_type g = h1(h) & group_mask;
+        for (size_type step = 1; ; ++step) {
+            const __flat_ctrl_t* gc = ctrl + g * __flat_group_width;
+            __flat_group group(gc);
+            for (__flat_bitmask m = group.match(h2(h)); m; ) {
+                size_type i = g * __flat_group_width + m.next();
+                if (equals(get_key(slots[i]), key))
+                    return i;
+            }
+            if (group.match_empty()) //组内有empty: 键值不可能在更后面
+                return capacity;
+            if (step > group_mask) //已走遍所有组(表中没有empty时才会发生)
+                return capacity;
+            g = (g + step) & group_mask;
+        }
+    }
+
+    //沿着h的探测序列找出第一个empty或deleted的槽
+    size_type find_first_non_full(size_t h) const
+    {
+        const size_type group_mask = capacity / __flat_group_width - 1;
+        size_type g = h1(h) & group_mask;
+        for (size_type step = 1; ; ++step) {
+            __flat_group group(ctrl + g * __flat_group_width);
+            __flat_bitmask m = group.match_empty_or_deleted();
+            if (m)
+                return g * __flat_group_width + m.lowest();
+            g = (g + step) & group_mask;
+        }
+    }
+
+    //为一个新元素找好槽位(必要时先重建),返回其索引
+    size_type prepare_insert(size_t h)
+    {
+        if (capacity == 0) {
+            rehash(capacity_for(1));
+        }
+        size_type i = find_first_non_full(h);
+        if (growth_left == 0 && ctrl[i] != __flat_ctrl_deleted) {
+            //deleted占了超过一半的余量: 原地重建即可回收;否则容量加倍
+            if (num_elements <= max_load(capacity) / 2)
+                rehash(capacity);
+            else
+                rehash(capacity * 2);
+            i = find_first_non_full(h);
+        }
+        if (ctrl[i] == __flat_ctrl_empty)
+            --growth_left; //重复利用deleted不消耗余量
+        return i;
+    }
+
+    void set_ctrl(size_type i, __flat_ctrl_t c) { ctrl[i] = c; }
+
+    void erase_index(size_type i)
+    {
+        destory(slots + i);
+        --num_elements;
+        //若i所在的组内还有empty,就没有任何探测序列会越过这一组,可以直接标为empty
+        const size_type g = i / __flat_group_width;
+        if (__flat_group(ctrl + g * __flat_group_width).match_empty()) {
+            set_ctrl(i, __flat_ctrl_empty);
+            ++growth_left;
+        } else {
+            set_ctrl(i, __flat_ctrl_deleted);
+        }
+    }
+
+    //以new_cap个槽重建表格,将所有元素搬到新位置(同时清除所有deleted)
+    void rehash(size_type new_cap)
+    {
+        __flat_ctrl_t* new_ctrl = ctrl_allocator::allocate(new_cap + 1);
+        value_type* new_slots = 0;
+        __STL_TRY {
+            new_slots = slot_allocator::allocate(new_cap);
+        }
+        __STL_UNWIND(ctrl_allocator::deallocate(new_ctrl, new_cap + 1));
+        memset(new_ctrl, __flat_ctrl_empty, new_cap);
+        new_ctrl[new_cap] = __flat_ctrl_sentinel;
+
+        __flat_ctrl_t* old_ctrl = ctrl;
+        value_type* old_slots = slots;
+        const size_type old_cap = capacity;
+        ctrl = new_ctrl;
+        slots = new_slots;
+        capacity = new_cap;
+        growth_left = max_load(new_cap) - num_elements;
+        //以下将旧表的每个元素放入新表. 新表中不可能有重复键值,所以不必比较
+        for (size_type i = 0; i < old_cap; ++i) {
+            if (is_full(old_ctrl[i])) {
+                const size_t h = hash_of(get_key(old_slots[i]));
+                const size_type j = find_first_non_full(h);
+                construct(slots + j, old_slots[i]);
+                destory(old_slots + i);
+                set_ctrl(j, h2(h));
+            }
+        }
+        if (old_cap) {
+            ctrl_allocator::deallocate(old_ctrl, old_cap + 1);
+            slot_allocator::deallocate(old_slots, old_cap);
+        }
+    }
+
+    void deallocate_arrays()
+    {
+        if (capacity) {
+            ctrl_allocator::deallocate(ctrl, capacity + 1);
+            slot_allocator::deallocate(slots, capacity);
+        }
+        ctrl = empty_ctrl();
+        slots = 0;
+        capacity = 0;
+        growth_left = 0;
+    }
+
+    //调用前本表必须为空
+    void copy_from(const flat_hashtable& ht)
+    {
+        reserve(ht.num_elements);
+        for (size_type i = 0; i < ht.capacity; ++i)
+            if (is_full(ht.ctrl[i]))
+                insert_unique(ht.slots[i]);
+    }
+};
+
+template <class V, class K, class HF, class Ex, class Eq, class A>
+bool operator==(const flat_hashtable<V, K, HF, Ex, Eq, A>& ht1,
+                const flat_hashtable<V, K, HF, Ex, Eq, A>& ht2)
+{
+    if (ht1.size() != ht2.size())
+        return false;
+    typename flat_hashtable<V, K, HF, Ex, Eq, A>::const_iterator it = ht1.begin();
+    for (; it != ht1.end(); ++it) {
+        typename flat_hashtable<V, K, HF, Ex, Eq, A>::const_iterator j = ht2.find(Ex()(*it));
+        if (j == ht2.end() || !(*j == *it))
+            return false;
+    }
+    return true;
+}
+
+#endif // SGI_STL_FLAT_HASHTABLE_H
@@ -0,0 +1,461 @@
+#ifndef SGI_STL_FLAT_MAP_H
+#define SGI_STL_FLAT_MAP_H
+
+#include <stddef.h>
+#include "01-config/stl_config.h"
+#include "02-allocator/stl_alloc.h"
+#include "03-iterator/stl_iterator.h"
+#include "03-iterator/type_traits.h" // __enable_if_transparent
+#include "04-container/stl_vector.h"
+#include "05-container/stl_pair.h"
+#include "05-container/stl_flat_sort.h"
+#include "06-algorithms/stl_algo.h"
+#include "07-functional/stl_function.h"
+
+/*
+ * flat_map: 以有序vector表现的map
+ *
+ * map的每个元素是一个红黑树节点: color + parent/left/right三个指针 + pair,
+ * 查找时一路追指针,每层都可能是一次cache miss.
+ * flat_map把键值与实值分别存放在两个有序的vector中(struct of arrays):
+ *
+ *   keys: k0 < k1 < k2 < ... (依Compare排序,不重复)
+ *   vals: v0   v1   v2   ...  (vals[i]是keys[i]的实值)
+ *
+ * 查找是对keys做二分查找(lower_bound),只读取键值,一条cache line可比对多个键值,
+ * 找到位置i之后才读vals[i]. 每个元素没有任何额外的指针开销.
+ *
+ * 代价是单个元素的insert/erase要搬移其后的所有元素,为O(n). 所以flat_map适用于
+ * "建立一次,查询无数次"的表格: 以批量insert(first, last)建立——
+ * 新元素先追加在尾端,只对追加的部分排序,再与原有的有序区间合并,总共O(n + m log m).
+ *
+ * 与map的语意差异:
+ *   1. 元素并非真的以pair<const Key, T>存放,*it返回的是代理对象(proxy),
+ *      其first/second分别是键值与实值的reference. it->first, it->second的用法不变.
+ *   2. insert/erase会搬移元素,使既有迭代器与元素reference失效.
+ */
+
+//*it的型别: 分别指向键值与实值的reference
+template <class Key, class TRef>
+struct __flat_map_reference {
+    const Key& first;
+    TRef second;
+
+    __flat_map_reference(const Key& k, TRef v) : first(k), second(v) {}
+};
+
+//it->的型别: 保存一个代理对象,再把operator->转给它
+template <class Ref>
+struct __flat_map_pointer {
+    Ref ref;
+
+    __flat_map_pointer(const Ref& r) : ref(r) {}
+    Ref* operator->() { return &ref; }
+};
+
+//flat_map的迭代器: 同时指向keys与vals中的同一个位置,两者一起前进
+template <class Key, class T, class TRef, class TPtr>
+struct __flat_map_iterator {
+    typedef __flat_map_iterator<Key, T, T&, T*> iterator;
+    typedef __flat_map_iterator<Key, T, const T&, const T*> const_iterator;
+    typedef __flat_map_iterator<Key, T, TRef, TPtr> self;
+
+    typedef random_access_iterator_tag iterator_category;
+    typedef pair<const Key, T> value_type;
+    typedef ptrdiff_t difference_type;
+    typedef __flat_map_reference<Key, TRef> reference;
+    typedef __flat_map_pointer<reference> pointer;
+
+    const Key* key_ptr;
+    TPtr val_ptr;
+
+    __flat_map_iterator() {}
+    __flat_map_iterator(const Key* k, TPtr v) : key_ptr(k), val_ptr(v) {}
+    __flat_map_iterator(const iterator& it) : key_ptr(it.key_ptr), val_ptr(it.val_ptr) {}
+
+    reference operator*() const { return reference(*key_ptr, *val_ptr); }
+    pointer operator->() const { return pointer(operator*()); }
+    reference operator[](difference_type n) const { return reference(key_ptr[n], val_ptr[n]); }
+
+    self& operator++() { ++key_ptr; ++val_ptr; return *this; }
+    self& operator--() { --key_ptr; --val_ptr; return *this; }
+    self operator++(int) { self tmp = *this; ++*this; return tmp; }
+    self operator--(int) { self tmp = *this; --*this; return tmp; }
+    self& operator+=(difference_type n) { key_ptr += n; val_ptr += n; return *this; }
+    self& operator-=(difference_type n) { key_ptr -= n; val_ptr -= n; return *this; }
+    self operator+(difference_type n) const { self tmp = *this; return tmp += n; }
+    self operator-(difference_type n) const { self tmp = *this; return tmp -= n; }
+    difference_type operator-(const self& x) const { return key_ptr - x.key_ptr; }
+
+    bool operator==(const self& x) const { return key_ptr == x.key_ptr; }
+    bool operator!=(const self& x) const { return key_ptr != x.key_ptr; }
+    bool operator<(const self& x) const { return key_ptr < x.key_ptr; }
+    bool operator>(const self& x) const { return x < *this; }
+    bool operator<=(const self& x) const { return !(x < *this); }
+    bool operator>=(const self& x) const { return !(*this < x); }
+};
+
+template <class Key, class T, class Compare = less<Key>, class Alloc = alloc>
+class flat_map;
+
+template <class Key, class T, class Compare, class Alloc>
+inline bool operator==(const flat_map<Key, T, Compare, Alloc>& x,
+                       const flat_map<Key, T, Compare, Alloc>& y);
+template <class Key, class T, class Compare, class Alloc>
+inline bool operator<(const flat_map<Key, T, Compare, Alloc>& x,
+                      const flat_map<Key, T, Compare, Alloc>& y);
+
+template <class Key, class T, class Compare, class Alloc>
+class flat_map {
+public:
+    typedef Key key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef pair<const Key, T> value_type;
+    typedef Compare key_compare;
+
+    class value_compare : public binary_function<value_type, value_type, bool> {
+    friend class flat_map<Key, T, Compare, Alloc>;
+    protected:
+        Compare comp;
+        value_compare(Compare c) : comp(c) {}
+    public:
+        bool operator()(const value_type& x, const value_type& y) const
+        {
+            return comp(x.first, y.first);
+        }
+    };
+
+    typedef __flat_map_iterator<Key, T, T&, T*> iterator;
+    typedef __flat_map_iterator<Key, T, const T&, const T*> const_iterator;
+    typedef typename iterator::reference reference;
+    typedef typename const_iterator::reference const_reference;
+    typedef typename iterator::pointer pointer;
+    typedef typename const_iterator::pointer const_pointer;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+protected:
+    typedef vector<Key, Alloc> key_container;
+    typedef vector<T, Alloc> mapped_container;
+
+    key_container keys;     //有序且不重复的键值
+    mapped_container vals;  //vals[i]是keys[i]的实值
+    Compare comp;
+public:
+    flat_map() : comp(Compare()) {}
+    explicit flat_map(const Compare& c) : comp(c) {}
+    template <class InputIterator>
+    flat_map(InputIterator first, InputIterator last) :
+        comp(Compare()) { insert(first, last); }
+    template <class InputIterator>
+    flat_map(InputIterator first, InputIterator last, const Compare& c) :
+        comp(c) { insert(first, last); }
+
+    //accessors
+    key_compare key_comp() const { return comp; }
+    value_compare value_comp() const { return value_compare(comp); }
+    iterator begin() { return iterator_at(0); }
+    iterator end() { return iterator_at(size()); }
+    const_iterator begin() const { return iterator_at(0); }
+    const_iterator end() const { return iterator_at(size()); }
+    bool empty() const { return keys.empty(); }
+    size_type size() const { return keys.size(); }
+    size_type max_size() const { return size_type(-1); }
+    size_type capacity() const { return keys.capacity(); }
+    void reserve(size_type n)
+    {
+        keys.reserve(n);
+        vals.reserve(n);
+    }
+    T& operator[](const key_type& k)
+    {
+        size_type i = lower_index(k);
+        if (i == size() || comp(k, key_at(i)))
+            insert_at(i, k, T());
+        return val_at(i);
+    }
+    void swap(flat_map& x)
+    {
+        keys.swap(x.keys);
+        vals.swap(x.vals);
+        __STD::swap(comp, x.comp);
+    }
+
+    //insert/erase
+    pair<iterator, bool> insert(const value_type& x)
+    {
+        size_type i = lower_index(x.first);
+        if (i < size() && !comp(x.first, key_at(i)))
+            return pair<iterator, bool>(iterator_at(i), false);
+        insert_at(i, x.first, x.second);
+        return pair<iterator, bool>(iterator_at(i), true);
+    }
+    //position恰为插入点时免去二分查找: 依序append时为O(1)
+    iterator insert(iterator position, const value_type& x)
+    {
+        size_type i = position - begin();
+        if ((i == size() || comp(x.first, key_at(i))) &&
+            (i == 0 || comp(key_at(i - 1), x.first))) {
+            insert_at(i, x.first, x.second);
+            return iterator_at(i);
+        }
+        return insert(x).first;
+    }
+    //批量插入: 追加在尾端,排序追加的部分,再与原有序区间合并
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        const size_type n = size();
+        __STL_TRY {
+            for (; first != last; ++first) {
+                keys.push_back((*first).first);
+                vals.push_back((*first).second);
+            }
+        }
+        __STL_UNWIND(truncate(n));
+        merge_tail(n);
+    }
+
+    //与map不同,返回被删元素的下一个位置: 删除会搬移元素,调用者无法自行保留它
+    iterator erase(iterator position)
+    {
+        size_type i = position - begin();
+        keys.erase(keys.begin() + i);
+        vals.erase(vals.begin() + i);
+        return iterator_at(i);
+    }
+    size_type erase(const key_type& x)
+    {
+        size_type i = lower_index(x);
+        if (i == size() || comp(x, key_at(i)))
+            return 0;
+        erase(iterator_at(i));
+        return 1;
+    }
+    void erase(iterator first, iterator last)
+    {
+        size_type i = first - begin(), j = last - begin();
+        keys.erase(keys.begin() + i, keys.begin() + j);
+        vals.erase(vals.begin() + i, vals.begin() + j);
+    }
+    void clear()
+    {
+        keys.clear();
+        vals.clear();
+    }
+
+    //map operations
+    iterator find(const key_type& x) { return iterator_at(find_index(x)); }
+    const_iterator find(const key_type& x) const { return iterator_at(find_index(x)); }
+    size_type count(const key_type& x) const { return find_index(x) == size() ? 0 : 1; }
+    iterator lower_bound(const key_type& x) { return iterator_at(lower_index(x)); }
+    const_iterator lower_bound(const key_type& x) const { return iterator_at(lower_index(x)); }
+    iterator upper_bound(const key_type& x) { return iterator_at(upper_index(x)); }
+    const_iterator upper_bound(const key_type& x) const { return iterator_at(upper_index(x)); }
+    pair<iterator, iterator> equal_range(const key_type& x)
+    {
+        return pair<iterator, iterator>(lower_bound(x), upper_bound(x));
+    }
+    pair<const_iterator, const_iterator> equal_range(const key_type& x) const
+    {
+        return pair<const_iterator, const_iterator>(lower_bound(x), upper_bound(x));
+    }
+    //异质查找: 仅当Compare透明(如less<void>)时开放,见rb_tree
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    find(const K& x) { return iterator_at(find_index(x)); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, const_iterator>::type
+    find(const K& x) const { return iterator_at(find_index(x)); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, size_type>::type
+    count(const K& x) const { return find_index(x) == size() ? 0 : 1; }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    lower_bound(const K& x) { return iterator_at(lower_index(x)); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    upper_bound(const K& x) { return iterator_at(upper_index(x)); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, pair<iterator, iterator> >::type
+    equal_range(const K& x)
+    {
+        return pair<iterator, iterator>(iterator_at(lower_index(x)), iterator_at(upper_index(x)));
+    }
+
+    friend bool operator== __STL_NULL_TMPL_ARGS (const flat_map&, const flat_map&);
+    friend bool operator< __STL_NULL_TMPL_ARGS (const flat_map&, const flat_map&);
+protected:
+    const Key& key_at(size_type i) const { return keys.begin()[i]; }
+    T& val_at(size_type i) { return vals.begin()[i]; }
+    iterator iterator_at(size_type i) { return iterator(keys.begin() + i, vals.begin() + i); }
+    const_iterator iterator_at(size_type i) const
+    {
+        return const_iterator(keys.begin() + i, vals.begin() + i);
+    }
+
+    //查找只在keys上进行
+    template <class K>
+    size_type lower_index(const K& x) const
+    {
+        return __STD::lower_bound(keys.begin(), keys.end(), x, comp) - keys.begin();
+    }
+    template <class K>
+    size_type upper_index(const K& x) const
+    {
+        return __STD::upper_bound(keys.begin(), keys.end(), x, comp) - keys.begin();
+    }
+    //找不到时返回size()
+    template <class K>
+    size_type find_index(const K& x) const
+    {
+        size_type i = lower_index(x);
+        return (i == size() || comp(x, key_at(i))) ? size() : i;
+    }
+
+    void insert_at(size_type i, const Key& k, const T& v)
+    {
+        keys.insert(keys.begin() + i, 1, k);
+        __STL_TRY {
+            vals.insert(vals.begin() + i, 1, v);
+        }
+        __STL_UNWIND(keys.erase(keys.begin() + i));
+    }
+    //丢弃n之后的元素(批量插入失败时复原)
+    void truncate(size_type n)
+    {
+        keys.erase(keys.begin() + n, keys.end());
+        vals.erase(vals.begin() + n, vals.end());
+    }
+    //[0, n)有序,[n, size())是刚追加的元素: 使全体恢复有序且不重复
+    void merge_tail(size_type n);
+};
+
+template <class Key, class T, class Compare, class Alloc>
+void flat_map<Key, T, Compare, Alloc>::merge_tail(size_type n)
+{
+    //比较或复制抛出异常时去掉追加的部分,原有元素不受影响
+    __STL_TRY {
+        const size_type total = size();
+        const Key* k = keys.begin();
+        //常见情形: 追加的部分本来就严格递增,且都大于原有的最大者(例如以有序数据建表),原地即告完成
+        size_type j = n;
+        while (j < total && (j == 0 || comp(k[j - 1], k[j])))
+            ++j;
+        if (j == total)
+            return;
+
+        //对追加部分的下标排序(稳定,重复键值中先出现者在前)
+        const size_type m = total - n;
+        vector<size_t, Alloc> order, buf;
+        order.reserve(m);
+        buf.reserve(m);
+        for (size_type i = n; i < total; ++i) {
+            order.push_back(i);
+            buf.push_back(i);
+        }
+        __flat_sort_index(order.begin(), m, buf.begin(), k, comp);
+
+        //合并到新的vector: 键值相同时原有的元素优先,其余重复者丢弃
+        key_container new_keys;
+        mapped_container new_vals;
+        new_keys.reserve(total);
+        new_vals.reserve(total);
+        const size_t* o = order.begin();
+        size_type i = 0, r = 0;
+        while (i < n || r < m) {
+            size_type src;
+            if (r == m || (i < n && !comp(k[o[r]], k[i])))
+                src = i++;
+            else
+                src = o[r++];
+            if (!new_keys.empty() && !comp(new_keys.back(), k[src]))
+                continue; //与刚放入者相同
+            new_keys.push_back(k[src]);
+            new_vals.push_back(vals.begin()[src]);
+        }
+        keys.swap(new_keys);
+        vals.swap(new_vals);
+    }
+    __STL_UNWIND(truncate(n));
+}
+
+template <class Key, class T, class Compare, class Alloc>
+inline bool operator==(const flat_map<Key, T, Compare, Alloc>& x,
+                       const flat_map<Key, T, Compare, Alloc>& y)
+{
+    return x.size() == y.size() &&
+           equal(x.keys.begin(), x.keys.end(), y.keys.begin()) &&
+           equal(x.vals.begin(), x.vals.end(), y.vals.begin());
+}
+
+//依(键值, 实值)的字典顺序比较,与map相同
+template <class Key, class T, class Compare, class Alloc>
+inline bool operator<(const flat_map<Key, T, Compare, Alloc>& x,
+                      const flat_map<Key, T, Compare, Alloc>& y)
+{
+    typedef typename flat_map<Key, T, Compare, Alloc>::size_type size_type;
+    const size_type n = x.size() < y.size() ? x.size() : y.size();
+    for (size_type i = 0; i < n; ++i) {
+        const Key& a = x.keys.begin()[i];
+        const Key& b = y.keys.begin()[i];
+        if (a < b)
+            return true;
+        if (b < a)
+            return false;
+        if (x.vals.begin()[i] < y.vals.begin()[i])
+            return true;
+        if (y.vals.begin()[i] < x.vals.begin()[i])
+            return false;
+    }
+    return x.size() < y.size();
+}
+
+#endif // SGI_STL_FLAT_MAP_H
+
+
+/*
+ * ========= BENCHMARK DEMO ============
+ * "建立一次,查询无数次"的设定表: 比较map与flat_map的建立、查找与记忆体用量
+
+#include <map>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+typedef unsigned long key;
+
+int main()
+{
+    const size_t n = 1000000, lookups = 20000000;
+    vector<pair<key, key> > src;
+    for (size_t i = 0; i < n; ++i)
+        src.push_back(pair<key, key>(((key)rand() << 31) ^ rand(), i));
+
+    clock_t t0 = clock();
+    map<key, key> m(src.begin(), src.end());
+    clock_t t1 = clock();
+    flat_map<key, key> fm(src.begin(), src.end()); //追加 + 排序 + 合并
+    clock_t t2 = clock();
+    printf("build  map %6.2f ms  flat_map %6.2f ms\n",
+           (t1 - t0) * 1000.0 / CLOCKS_PER_SEC, (t2 - t1) * 1000.0 / CLOCKS_PER_SEC);
+
+    key sum = 0;
+    t0 = clock();
+    for (size_t i = 0; i < lookups; ++i)
+        sum += m.find(src[(i * 7919) % n].first)->second;
+    t1 = clock();
+    for (size_t i = 0; i < lookups; ++i)
+        sum += fm.find(src[(i * 7919) % n].first)->second;
+    t2 = clock();
+    printf("find   map %6.2f  flat_map %6.2f Mops/s  (%lu)\n",
+           lookups / (double(t1 - t0) / CLOCKS_PER_SEC) / 1e6,
+           lookups / (double(t2 - t1) / CLOCKS_PER_SEC) / 1e6, sum);
+
+    //记忆体: map每个元素一个节点(color + 三个指针 + pair);flat_map只有键值与实值本身
+    printf("map      ~%zu bytes/elem\n", 4 * sizeof(void*) + sizeof(pair<const key, key>));
+    printf("flat_map ~%zu bytes/elem\n", sizeof(key) + sizeof(key));
+}
+
+ */
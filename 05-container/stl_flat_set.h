@@ -0,0 +1,230 @@
+#ifndef SGI_STL_FLAT_SET_H
+#define SGI_STL_FLAT_SET_H
+
+#include <stddef.h>
+#include "01-config/stl_config.h"
+#include "02-allocator/stl_alloc.h"
+#include "03-iterator/type_traits.h" // __enable_if_transparent
+#include "04-container/stl_vector.h"
+#include "05-container/stl_pair.h"
+#include "05-container/stl_flat_sort.h"
+#include "06-algorithms/stl_algo.h"
+#include "07-functional/stl_function.h"
+
+/*
+ * flat_set: 以有序vector表现的set,原理见<stl_flat_map.h>
+ *
+ * 元素依Compare排序、不重复,连续存放在一个vector中,迭代器就是const Key*.
+ * 查找以lower_bound二分查找;批量insert(first, last)追加、排序、合并.
+ * 与set的语意差异: insert/erase会搬移元素,使既有迭代器与元素reference失效.
+ */
+
+template <class Key, class Compare = less<Key>, class Alloc = alloc>
+class flat_set;
+
+template <class Key, class Compare, class Alloc>
+inline bool operator==(const flat_set<Key, Compare, Alloc>& x,
+                       const flat_set<Key, Compare, Alloc>& y);
+template <class Key, class Compare, class Alloc>
+inline bool operator<(const flat_set<Key, Compare, Alloc>& x,
+                      const flat_set<Key, Compare, Alloc>& y);
+
+template <class Key, class Compare, class Alloc>
+class flat_set {
+public:
+    typedef Key key_type;
+    typedef Key value_type;
+    typedef Compare key_compare;
+    typedef Compare value_compare;
+
+    typedef const Key* pointer;
+    typedef const Key* const_pointer;
+    typedef const Key& reference;
+    typedef const Key& const_reference;
+    //与set相同,迭代器不允许写入元素
+    typedef const Key* iterator;
+    typedef const Key* const_iterator;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+protected:
+    typedef vector<Key, Alloc> key_container;
+
+    key_container keys; //有序且不重复
+    Compare comp;
+public:
+    flat_set() : comp(Compare()) {}
+    explicit flat_set(const Compare& c) : comp(c) {}
+    template <class InputIterator>
+    flat_set(InputIterator first, InputIterator last) :
+        comp(Compare()) { insert(first, last); }
+    template <class InputIterator>
+    flat_set(InputIterator first, InputIterator last, const Compare& c) :
+        comp(c) { insert(first, last); }
+
+    //accessors
+    key_compare key_comp() const { return comp; }
+    value_compare value_comp() const { return comp; }
+    iterator begin() const { return keys.begin(); }
+    iterator end() const { return keys.end(); }
+    bool empty() const { return keys.empty(); }
+    size_type size() const { return keys.size(); }
+    size_type max_size() const { return size_type(-1); }
+    size_type capacity() const { return keys.capacity(); }
+    void reserve(size_type n) { keys.reserve(n); }
+    void swap(flat_set& x)
+    {
+        keys.swap(x.keys);
+        __STD::swap(comp, x.comp);
+    }
+
+    //insert/erase
+    pair<iterator, bool> insert(const value_type& x)
+    {
+        iterator i = lower_bound(x);
+        if (i != end() && !comp(x, *i))
+            return pair<iterator, bool>(i, false);
+        return pair<iterator, bool>(insert_at(i, x), true);
+    }
+    //position恰为插入点时免去二分查找: 依序append时为O(1)
+    iterator insert(iterator position, const value_type& x)
+    {
+        if ((position == end() || comp(x, *position)) &&
+            (position == begin() || comp(*(position - 1), x)))
+            return insert_at(position, x);
+        return insert(x).first;
+    }
+    //批量插入: 追加在尾端,排序追加的部分,再与原有序区间合并
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        const size_type n = size();
+        __STL_TRY {
+            for (; first != last; ++first)
+                keys.push_back(*first);
+        }
+        __STL_UNWIND(keys.erase(keys.begin() + n, keys.end()));
+        merge_tail(n);
+    }
+
+    //与set不同,返回被删元素的下一个位置: 删除会搬移元素,调用者无法自行保留它
+    iterator erase(iterator position)
+    {
+        size_type i = position - begin();
+        keys.erase(keys.begin() + i);
+        return begin() + i;
+    }
+    size_type erase(const key_type& x)
+    {
+        iterator i = find(x);
+        if (i == end())
+            return 0;
+        erase(i);
+        return 1;
+    }
+    void erase(iterator first, iterator last)
+    {
+        size_type i = first - begin(), j = last - begin();
+        keys.erase(keys.begin() + i, keys.begin() + j);
+    }
+    void clear() { keys.clear(); }
+
+    //set operations
+    iterator find(const key_type& x) const { return __find(x); }
+    size_type count(const key_type& x) const { return __find(x) == end() ? 0 : 1; }
+    iterator lower_bound(const key_type& x) const
+    {
+        return __STD::lower_bound(begin(), end(), x, comp);
+    }
+    iterator upper_bound(const key_type& x) const
+    {
+        return __STD::upper_bound(begin(), end(), x, comp);
+    }
+    pair<iterator, iterator> equal_range(const key_type& x) const
+    {
+        return pair<iterator, iterator>(lower_bound(x), upper_bound(x));
+    }
+    //异质查找: 仅当Compare透明(如less<void>)时开放,见rb_tree
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    find(const K& x) const { return __find(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, size_type>::type
+    count(const K& x) const { return __find(x) == end() ? 0 : 1; }
+
+    friend bool operator== __STL_NULL_TMPL_ARGS (const flat_set&, const flat_set&);
+    friend bool operator< __STL_NULL_TMPL_ARGS (const flat_set&, const flat_set&);
+protected:
+    template <class K>
+    iterator __find(const K& x) const
+    {
+        iterator i = __STD::lower_bound(begin(), end(), x, comp);
+        return (i == end() || comp(x, *i)) ? end() : i;
+    }
+    iterator insert_at(iterator position, const value_type& x)
+    {
+        size_type i = position - begin();
+        keys.insert(keys.begin() + i, 1, x);
+        return begin() + i;
+    }
+    //[0, n)有序,[n, size())是刚追加的元素: 使全体恢复有序且不重复
+    void merge_tail(size_type n);
+};
+
+template <class Key, class Compare, class Alloc>
+void flat_set<Key, Compare, Alloc>::merge_tail(size_type n)
+{
+    //比较或复制抛出异常时去掉追加的部分,原有元素不受影响
+    __STL_TRY {
+        const size_type total = size();
+        const Key* k = keys.begin();
+        //追加的部分本来就严格递增且大于原有的最大者,原地即告完成
+        size_type j = n;
+        while (j < total && (j == 0 || comp(k[j - 1], k[j])))
+            ++j;
+        if (j == total)
+            return;
+
+        const size_type m = total - n;
+        vector<size_t, Alloc> order, buf;
+        order.reserve(m);
+        buf.reserve(m);
+        for (size_type i = n; i < total; ++i) {
+            order.push_back(i);
+            buf.push_back(i);
+        }
+        __flat_sort_index(order.begin(), m, buf.begin(), k, comp);
+
+        //合并到新的vector,重复者只留第一个
+        key_container merged;
+        merged.reserve(total);
+        const size_t* o = order.begin();
+        size_type i = 0, r = 0;
+        while (i < n || r < m) {
+            size_type src;
+            if (r == m || (i < n && !comp(k[o[r]], k[i])))
+                src = i++;
+            else
+                src = o[r++];
+            if (merged.empty() || comp(merged.back(), k[src]))
+                merged.push_back(k[src]);
+        }
+        keys.swap(merged);
+    }
+    __STL_UNWIND(keys.erase(keys.begin() + n, keys.end()));
+}
+
+template <class Key, class Compare, class Alloc>
+inline bool operator==(const flat_set<Key, Compare, Alloc>& x,
+                       const flat_set<Key, Compare, Alloc>& y)
+{
+    return x.size() == y.size() && equal(x.begin(), x.end(), y.begin());
+}
+
+template <class Key, class Compare, class Alloc>
+inline bool operator<(const flat_set<Key, Compare, Alloc>& x,
+                      const flat_set<Key, Compare, Alloc>& y)
+{
+    return lexicographical_compare(x.begin(), x.end(), y.begin(), y.end());
+}
+
+#endif // SGI_STL_FLAT_SET_H
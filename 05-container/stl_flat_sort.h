@@ -0,0 +1,75 @@
+#ifndef SGI_STL_FLAT_SORT_H
+#define SGI_STL_FLAT_SORT_H
+
+#include <stddef.h>
+#include "01-config/stl_config.h"
+
+/*
+ * flat_map/flat_set批量插入所用的排序
+ *
+ * 新元素先追加在有序区间之后,再对追加的部分排序,最后与原有序区间合并.
+ * flat_map把键值与实值分放两个vector,无法直接排序pair,所以这里排序的是"下标":
+ * 依keys[idx]的次序重排idx[0, n),键值相同者保持原来的先后(稳定),
+ * 这样重复的键值中最先出现的那一个排在最前,与map逐一insert_unique()的结果一致.
+ *
+ * 作法是自底向上的merge sort: 先以insertion sort排好每16个一段,再两两合并,
+ * 在idx与buf之间来回搬动. buf必须能容纳n个下标.
+ */
+
+template <class Key, class Compare>
+void __flat_insertion_sort_index(size_t* first, size_t* last, const Key* keys, const Compare& comp)
+{
+    if (first == last)
+        return;
+    for (size_t* i = first + 1; i != last; ++i) {
+        size_t v = *i;
+        size_t* j = i;
+        //严格小于才往前移,相同者保持原次序
+        for (; j != first && comp(keys[v], keys[*(j - 1)]); --j)
+            *j = *(j - 1);
+        *j = v;
+    }
+}
+
+//把有序的[first1, last1)与[first2, last2)合并到result,相同者取第一段的在前
+template <class Key, class Compare>
+size_t* __flat_merge_index(size_t* first1, size_t* last1, size_t* first2, size_t* last2,
+                           size_t* result, const Key* keys, const Compare& comp)
+{
+    while (first1 != last1 && first2 != last2) {
+        if (comp(keys[*first2], keys[*first1]))
+            *result++ = *first2++;
+        else
+            *result++ = *first1++;
+    }
+    while (first1 != last1)
+        *result++ = *first1++;
+    while (first2 != last2)
+        *result++ = *first2++;
+    return result;
+}
+
+template <class Key, class Compare>
+void __flat_sort_index(size_t* idx, size_t n, size_t* buf, const Key* keys, const Compare& comp)
+{
+    const size_t run = 16;
+    for (size_t i = 0; i < n; i += run)
+        __flat_insertion_sort_index(idx + i, idx + (n - i < run ? n : i + run), keys, comp);
+    size_t* src = idx;
+    size_t* dst = buf;
+    for (size_t width = run; width < n; width *= 2) {
+        for (size_t i = 0; i < n; i += 2 * width) {
+            size_t mid = n - i < width ? n : i + width;
+            size_t hi = n - i < 2 * width ? n : i + 2 * width;
+            __flat_merge_index(src + i, src + mid, src + mid, src + hi, dst + i, keys, comp);
+        }
+        size_t* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    if (src != idx) //最后一趟落在buf中
+        for (size_t i = 0; i < n; ++i)
+            idx[i] = src[i];
+}
+
+#endif // SGI_STL_FLAT_SORT_H
@@ -2,17 +2,192 @@
 #define SGI_STL_HASH_FUN_H
 
 #include "01-config/stl_config.h"
+#include "03-iterator/type_traits.h" // __true_type, __false_type
+#include "05-container/stl_pair.h"
 #include <stddef.h>
+#include <string.h> // memcpy, strlen
+#ifdef __STL_HASH_RANDOM_SEED
+    #include <time.h>
+#endif
 
 template <class Key> 
 struct hash { };
 
-inline size_t __stl_hash_string(const char* s)
+/* 字节串的hash: __stl_hash_bytes()
+ *
+ * 原本的__stl_hash_string()是 h = 5*h + c, 一次处理一个字节,
+ * 长字符串很慢;只有最后几个字符能影响低位,分布不佳;
+ * 而且很容易构造大量碰撞的键值(hash flooding),使hashtable退化为链表.
+ *
+ * 这里采用wyhash的算法: 一次读入8字节(以memcpy读取,不要求对齐),
+ * 以64x64->128位乘法把两个字混合为一个(mum: multiply then xor high/low),
+ * 超过48字节时以三条互不相依的乘法链并行处理,让CPU的多个乘法单元同时工作.
+ * 长度也参与混合,所以"ab"与"ab\0"的hash不同.
+ *
+ * 若定义__STL_HASH_RANDOM_SEED,则每个进程启动时取一个随机种子,
+ * 相同字符串在不同进程中的hash值不同,攻击者无法预先构造碰撞.
+ * 缺省不开启,hash值在每次执行时都相同(便于重现问题).
+ */
+
+typedef unsigned long long __stl_hash_word;
+
+static const __stl_hash_word __stl_hash_secret[4] = {
+    0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+    0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+};
+
+//64x64->128位乘法,*a取低64位,*b取高64位
+inline void __stl_hash_mum(__stl_hash_word* a, __stl_hash_word* b)
+{
+#if defined(__GNUC__) && defined(__SIZEOF_INT128__)
+    unsigned __int128 r = *a;
+    r *= *b;
+    *a = (__stl_hash_word)r;
+    *b = (__stl_hash_word)(r >> 64);
+#else
+    //没有128位整数: 拆成四个32x32->64位乘积
+    const __stl_hash_word ha = *a >> 32, la = (unsigned)*a;
+    const __stl_hash_word hb = *b >> 32, lb = (unsigned)*b;
+    const __stl_hash_word rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    const __stl_hash_word t = rl + (rm0 << 32);
+    __stl_hash_word c = t < rl;
+    const __stl_hash_word lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+inline __stl_hash_word __stl_hash_mum_mix(__stl_hash_word a, __stl_hash_word b)
+{
+    __stl_hash_mum(&a, &b);
+    return a ^ b;
+}
+
+//读取p处的8/4字节(本机字节序),以及1~3字节的短尾巴
+inline __stl_hash_word __stl_hash_read8(const unsigned char* p)
+{
+    __stl_hash_word v;
+    memcpy(&v, p, 8);
+    return v;
+}
+inline __stl_hash_word __stl_hash_read4(const unsigned char* p)
+{
+    unsigned int v;
+    memcpy(&v, p, 4);
+    return v;
+}
+inline __stl_hash_word __stl_hash_read3(const unsigned char* p, size_t k)
+{
+    return (__stl_hash_word(p[0]) << 16) | (__stl_hash_word(p[k >> 1]) << 8) | p[k - 1];
+}
+
+#ifdef __STL_HASH_RANDOM_SEED
+//以时间、时钟与(受ASLR影响的)地址混合出每个进程不同的种子
+inline __stl_hash_word __stl_hash_make_seed()
+{
+    static int anchor;
+    __stl_hash_word x = (__stl_hash_word)time(0);
+    x = __stl_hash_mum_mix(x ^ __stl_hash_secret[0], (__stl_hash_word)(size_t)&anchor ^ __stl_hash_secret[1]);
+    x = __stl_hash_mum_mix(x ^ (__stl_hash_word)clock(), __stl_hash_secret[2]);
+    return x;
+}
+#endif
+
+inline __stl_hash_word __stl_hash_seed()
+{
+#ifdef __STL_HASH_RANDOM_SEED
+    static const __stl_hash_word seed = __stl_hash_make_seed();
+    return seed;
+#else
+    return 0;
+#endif
+}
+
+inline size_t __stl_hash_bytes(const void* key, size_t len, __stl_hash_word seed)
+{
+    const __stl_hash_word* secret = __stl_hash_secret;
+    const unsigned char* p = (const unsigned char*)key;
+    __stl_hash_word a, b;
+    seed ^= __stl_hash_mum_mix(seed ^ secret[0], secret[1]);
+    if (len <= 16) {
+        if (len >= 4) { //两段可能重叠的4字节,涵盖4~16字节
+            const size_t off = (len >> 3) << 2;
+            a = (__stl_hash_read4(p) << 32) | __stl_hash_read4(p + off);
+            b = (__stl_hash_read4(p + len - 4) << 32) | __stl_hash_read4(p + len - 4 - off);
+        }
+        else if (len > 0) {
+            a = __stl_hash_read3(p, len);
+            b = 0;
+        }
+        else
+            a = b = 0;
+    }
+    else {
+        size_t i = len;
+        if (i > 48) { //三条独立的乘法链
+            __stl_hash_word see1 = seed, see2 = seed;
+            do {
+                seed = __stl_hash_mum_mix(__stl_hash_read8(p) ^ secret[1], __stl_hash_read8(p + 8) ^ seed);
+                see1 = __stl_hash_mum_mix(__stl_hash_read8(p + 16) ^ secret[2], __stl_hash_read8(p + 24) ^ see1);
+                see2 = __stl_hash_mum_mix(__stl_hash_read8(p + 32) ^ secret[3], __stl_hash_read8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = __stl_hash_mum_mix(__stl_hash_read8(p) ^ secret[1], __stl_hash_read8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        //最后16字节(可能与前面重叠)
+        a = __stl_hash_read8(p + i - 16);
+        b = __stl_hash_read8(p + i - 8);
+    }
+    a ^= secret[1];
+    b ^= seed;
+    __stl_hash_mum(&a, &b);
+    return size_t(__stl_hash_mum_mix(a ^ secret[0] ^ len, b ^ secret[1]));
+}
+
+inline size_t __stl_hash_bytes(const void* key, size_t len)
 {
-    unsigned long h = 0;
-    for (; *s; ++s)
-        h = 5 * h + *s;
-    return size_t(h);
+    return __stl_hash_bytes(key, len, __stl_hash_seed());
+}
+
+//字符串的hash: 长度已知时直接使用,否则先以strlen()(libc以整个字组或SIMD扫描)取得长度
+inline size_t __stl_hash_string(const char* s, size_t len) { return __stl_hash_bytes(s, len); }
+inline size_t __stl_hash_string(const char* s) { return __stl_hash_bytes(s, strlen(s)); }
+
+//把两个hash值合而为一(用于pair等复合键值),次序不同结果不同
+inline size_t __stl_hash_combine(size_t seed, size_t h)
+{
+    return seed ^ (h + size_t(0x9e3779b97f4a7c15ULL) + (seed << 6) + (seed >> 2));
+}
+
+//整数hash的终结器(finalizer,取自MurmurHash3的fmix): 让输入的每一位都影响输出的每一位.
+//上述hash<int>等都是identity,只有以质数取模时才能把键值打散;
+//若bucket个数是2的幂(以位元遮罩取低位),或需要取用hash值的高位(如flat_hashtable),
+//必须先经过这一步,否则连续整数与对齐过的指针会成群挤在少数几个bucket里
+inline size_t __stl_hash_mix(size_t h)
+{
+    if (sizeof(size_t) >= 8) {
+        unsigned long long x = h;
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return size_t(x);
+    } else {
+        h ^= h >> 16;
+        h *= 0x85ebca6bUL;
+        h ^= h >> 13;
+        h *= 0xc2b2ae35UL;
+        h ^= h >> 16;
+        return h;
+    }
 }
 
 __STL_TEMPLATE_NULL struct hash<char*>
@@ -71,6 +246,84 @@ __STL_TEMPLATE_NULL struct hash<unsigned long>
 }
 
 //由此观之: SGI hashtable无法处理上述所列各型别以外的元素如: string, double, float.
-//欲处理这些型别,用户必须自行为他们定义hash function
+//以下补上浮点数、指针、pair与字符串类别的hash function
+
+//浮点数: 以其位元表示做hash. +0.0与-0.0相等,必须得到相同的hash值
+__STL_TEMPLATE_NULL struct hash<float>
+{
+    size_t operator()(float x) const
+    {
+        if (x == 0.0f)
+            return 0;
+        unsigned int bits;
+        memcpy(&bits, &x, sizeof(bits));
+        return __stl_hash_mix(bits);
+    }
+};
+
+__STL_TEMPLATE_NULL struct hash<double>
+{
+    size_t operator()(double x) const
+    {
+        if (x == 0.0)
+            return 0;
+        unsigned long long bits;
+        memcpy(&bits, &x, sizeof(bits));
+        return __stl_hash_mix(size_t(bits ^ (bits >> 32)));
+    }
+};
+
+//指针: 以地址为hash值,与整数相同;对齐造成的低位全0由bucket policy的取模或搅拌处理.
+//char*与const char*另有全特化版本,视为字符串
+template <class T>
+struct hash<T*>
+{
+    size_t operator()(T* p) const { return size_t(p); }
+};
+
+template <class T1, class T2>
+struct hash<pair<T1, T2> >
+{
+    size_t operator()(const pair<T1, T2>& p) const
+    {
+        return __stl_hash_combine(hash<T1>()(p.first), hash<T2>()(p.second));
+    }
+};
+
+//字符串类别的hash function: 适用于任何提供data()与size()的字符串类别(例如std::string),
+//例如 hash_map<string, int, string_hash<string> >.
+//同时接受const char*且两者结果相同,所以是透明的,可配合异质查找(以const char*查找而不构造string)
+template <class String>
+struct string_hash
+{
+    typedef void is_transparent;
+    size_t operator()(const String& s) const { return __stl_hash_string(s.data(), s.size()); }
+    size_t operator()(const char* s) const { return __stl_hash_string(s); }
+};
+
+//hashtable是否在节点中快取元素的hash值. 计算代价高的hash(字符串)设为__true_type:
+//每个节点多一个size_t,换得重建与迭代时不必重新计算hash,且查找时可先比较hash值再调用equals.
+//整数的identity hash不值得快取,所以缺省为__false_type.
+//用户自定义的hash function可以特化此模板以开启快取
+template <class HashFcn>
+struct __hash_code_traits {
+    typedef __false_type cache_hash_code;
+};
+
+__STL_TEMPLATE_NULL struct __hash_code_traits<hash<char*> >
+{
+    typedef __true_type cache_hash_code;
+};
+
+__STL_TEMPLATE_NULL struct __hash_code_traits<hash<const char*> >
+{
+    typedef __true_type cache_hash_code;
+};
+
+template <class String>
+struct __hash_code_traits<string_hash<String> >
+{
+    typedef __true_type cache_hash_code;
+};
 
 #endif // SGI_STL_HASH_FUN_H
\ No newline at end of file
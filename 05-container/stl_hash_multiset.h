@@ -12,10 +12,11 @@
 template <class Value,
           class HashFcn = hash<Value>,
           class EqualKey = equal_to<Value>,
-          class Alloc = alloc>
+          class Alloc = alloc,
+          class BucketPolicy = __hashtable_prime_policy>
 class hash_multiset {
 private:
-    typedef hashtable<Value, Value, HashFcn, identity<Value>, EqualKey, Alloc> ht;
+    typedef hashtable<Value, Value, HashFcn, identity<Value>, EqualKey, Alloc, BucketPolicy> ht;
     ht rep;
 public:
     typedef typename ht::key_type key_type;
@@ -33,6 +34,8 @@ public:
     typedef typename ht::const_pointer const_pointer;
     typedef typename ht::const_iterator const_iterator;
     typedef typename ht::const_reference const_reference;
+    //节点把手,见hashtable::node_type
+    typedef typename ht::node_type node_type;
 
     hasher hash_funct() const { return rep.hash_funct(); }
     key_equal key_eq() const { return rep.key_eq(); }
@@ -79,21 +82,63 @@ public:
 
     pair<iterator, iterator> equal_range(cosnt key_type& key) const
     { return rep.equal_range(key); }
+    //异质查找: HashFcn与EqualKey皆透明时开放,见hashtable
+    template <class K>
+    typename __enable_if_transparent2<HashFcn, EqualKey, K, iterator>::type
+    find(const K& key) const { return rep.find(key); }
+    template <class K>
+    typename __enable_if_transparent2<HashFcn, EqualKey, K, size_type>::type
+    count(const K& key) const { return rep.count(key); }
+    template <class K>
+    typename __enable_if_transparent2<HashFcn, EqualKey, K, pair<iterator, iterator> >::type
+    equal_range(const K& key) const { return rep.equal_range(key); }
+
+    //批次操作: 先预取整批键值所在的buckets与串行头节点,再逐一完成,见hashtable::find_batch().
+    //find_batch对每个键值写出一个迭代器(找不到者为end()),count_batch写出count(key)
+    template <class ForwardIterator, class OutputIterator>
+    OutputIterator find_batch(ForwardIterator f, ForwardIterator l, OutputIterator out) const
+        { return rep.find_batch(f, l, out); }
+    template <class ForwardIterator, class OutputIterator>
+    OutputIterator count_batch(ForwardIterator f, ForwardIterator l, OutputIterator out) const
+        { return rep.count_batch(f, l, out); }
+    template <class ForwardIterator>
+    void insert_batch(ForwardIterator f, ForwardIterator l) { rep.insert_equal_batch(f, l); }
 
     size_type erase(const key_type& key) { return rep.erase(key); }
     void erase(iterator i) { rep.erase(i); }
     void erase(iterator f, iterator l) { rep.erase(f, l); }
     void clear() { rep.clear(); }
+    //节点的摘下与插回: 不配置记忆体、不复制元素
+    node_type extract(iterator i) { return rep.extract(i); }
+    node_type extract(const key_type& key) { return rep.extract(key); }
+    iterator insert(node_type& nh) { return rep.insert_equal(nh); }
+    void merge(hash_multiset& x) { rep.merge_equal(x.rep); }
+    //大型表格的平行版本(需要__STL_PTHREADS),threads为0表示使用全部硬件线程,见hashtable
+    template <class RandomAccessIterator>
+    void insert_parallel(RandomAccessIterator f, RandomAccessIterator l, size_type threads = 0)
+        { rep.insert_equal_parallel(f, l, threads); }
+    void clear_parallel(size_type threads = 0) { rep.clear_parallel(threads); }
+    void copy_from_parallel(const hash_multiset& x, size_type threads = 0) { rep.copy_from_parallel(x.rep, threads); }
 public:
     void resize(size_type hint) { rep.resize(hint); }
+    //开启后表格成长不再一次搬移全部元素,而是分摊到之后的插入中
+    void set_incremental_rehash(bool on) { rep.set_incremental_rehash(on); }
+    float load_factor() const { return rep.load_factor(); }
+    float max_load_factor() const { return rep.max_load_factor(); }
+    void max_load_factor(float z) { rep.max_load_factor(z); }
+    //删除后负载低于z即缩小表格(会使迭代器失效),缺省0表示永不缩小
+    float shrink_load_factor() const { return rep.shrink_load_factor(); }
+    void shrink_load_factor(float z) { rep.shrink_load_factor(z); }
+    void reserve(size_type n) { rep.reserve(n); }
+    void rehash(size_type n) { rep.rehash(n); }
     size_type bucket_count() const { return rep.bucket_count(); }
     size_type max_bucket_count() const { return rep.max_bucket_count(); }
     size_type elems_in_bucket(size_type n) const { return rep.elems_in_bucket(n); }
 };
 
-template <class Val, class HashFcn, class EqualKey, class Alloc>
-inline bool operator ==(const hash_multiset<Val, HashFcn, EqualKey, Alloc>hms1,
-const hash_multiset<Val, HashFcn, EqualKey, Alloc>hms2) { return hms1.rep == hms2.rep; }
+template <class Val, class HashFcn, class EqualKey, class Alloc, class BucketPolicy>
+inline bool operator ==(const hash_multiset<Val, HashFcn, EqualKey, Alloc, BucketPolicy>hms1,
+const hash_multiset<Val, HashFcn, EqualKey, Alloc, BucketPolicy>hms2) { return hms1.rep == hms2.rep; }
 
 #endif // SGI_STL_HASH_MULTI_SET_H
 
@@ -12,11 +12,12 @@
 template <class Value,
           class HashFcn = hash<Value>,
           class EqualKey = equal_to<Value>,
-          class Alloc = alloc>
+          class Alloc = alloc,
+          class BucketPolicy = __hashtable_prime_policy>
 class hash_set {
 private:
     //以下使用的identity<>定义于<stl_function.h>中
-    typedef hashtable<Value, Value, HashFcn, identity<Value>, EqualKey, Alloc> ht;
+    typedef hashtable<Value, Value, HashFcn, identity<Value>, EqualKey, Alloc, BucketPolicy> ht;
     ht rep; //底层机制以hash table完成
 public:
     typedef typename ht::key_type key_type;
@@ -31,6 +32,8 @@ public:
     typedef typename ht::const_reference reference;
     typedef typename ht::const_iterator iterator;
     typedef typename ht::const_reference const_reference;
+    //节点把手,见hashtable::node_type
+    typedef typename ht::node_type node_type;
     typedef typename ht::const_iterator const_iterator;
 
     hasher hash_funct() const { return rep.hash_funct(); }
@@ -88,20 +91,63 @@ public:
     iterator find(const key_type& key) const { return rep.find(key); }
     size_type count(const key_type& key) const { return rep.count(key); }
     pair<iterator, iterator> equal_range(const key_type& key) { return rep.equal_range(key); }
+    //异质查找: HashFcn与EqualKey皆透明时开放,见hashtable
+    template <class K>
+    typename __enable_if_transparent2<HashFcn, EqualKey, K, iterator>::type
+    find(const K& key) const { return rep.find(key); }
+    template <class K>
+    typename __enable_if_transparent2<HashFcn, EqualKey, K, size_type>::type
+    count(const K& key) const { return rep.count(key); }
+    template <class K>
+    typename __enable_if_transparent2<HashFcn, EqualKey, K, pair<iterator, iterator> >::type
+    equal_range(const K& key) const { return rep.equal_range(key); }
+
+    //批次操作: 先预取整批键值所在的buckets与串行头节点,再逐一完成,见hashtable::find_batch().
+    //find_batch对每个键值写出一个迭代器(找不到者为end()),count_batch写出count(key)
+    template <class ForwardIterator, class OutputIterator>
+    OutputIterator find_batch(ForwardIterator f, ForwardIterator l, OutputIterator out) const
+        { return rep.find_batch(f, l, out); }
+    template <class ForwardIterator, class OutputIterator>
+    OutputIterator count_batch(ForwardIterator f, ForwardIterator l, OutputIterator out) const
+        { return rep.count_batch(f, l, out); }
+    template <class ForwardIterator>
+    void insert_batch(ForwardIterator f, ForwardIterator l) { rep.insert_unique_batch(f, l); }
     size_type erase(const key_type& key) { rep.erase(key); }
     void erase(iterator i) { rep.erase(i); }
     void erase(iterator f, iterator l) { rep.erase(f, l); }
     void clear() { rep.clear(); }
+    //节点的摘下与插回: 不配置记忆体、不复制元素;键值重复时不插入,节点仍留在nh中
+    node_type extract(iterator i) { return rep.extract(i); }
+    node_type extract(const key_type& key) { return rep.extract(key); }
+    pair<iterator, bool> insert(node_type& nh) { return rep.insert_unique(nh); }
+    //把x的节点逐一改串过来,键值重复者留在x中
+    void merge(hash_set& x) { rep.merge_unique(x.rep); }
+    //大型表格的平行版本(需要__STL_PTHREADS),threads为0表示使用全部硬件线程,见hashtable
+    template <class RandomAccessIterator>
+    void insert_parallel(RandomAccessIterator f, RandomAccessIterator l, size_type threads = 0)
+        { rep.insert_unique_parallel(f, l, threads); }
+    void clear_parallel(size_type threads = 0) { rep.clear_parallel(threads); }
+    void copy_from_parallel(const hash_set& x, size_type threads = 0) { rep.copy_from_parallel(x.rep, threads); }
 public:
     void resize(size_type hint) { rep.resize(hint); }
+    //开启后表格成长不再一次搬移全部元素,而是分摊到之后的插入中
+    void set_incremental_rehash(bool on) { rep.set_incremental_rehash(on); }
+    float load_factor() const { return rep.load_factor(); }
+    float max_load_factor() const { return rep.max_load_factor(); }
+    void max_load_factor(float z) { rep.max_load_factor(z); }
+    //删除后负载低于z即缩小表格(会使迭代器失效),缺省0表示永不缩小
+    float shrink_load_factor() const { return rep.shrink_load_factor(); }
+    void shrink_load_factor(float z) { rep.shrink_load_factor(z); }
+    void reserve(size_type n) { rep.reserve(n); }
+    void rehash(size_type n) { rep.rehash(n); }
     size_type bucket_count() const { return rep.bucket_count(); }
     size_type max_bucket_count() const { return rep.max_buckets_count(); }
     size_type elems_in_bucket(size_type n) const { return rep.elems_in_bucket(n); }
 };
 
-template <class Value, class HashFcn, class EqualKey, class Alloc>
-inline bool operator ==(const hash_set<Value, HashFcn, EqualKey, Alloc>& hs1, 
-const hash_set<Value, HashFcn, EqualKey, Alloc>& hs2)
+template <class Value, class HashFcn, class EqualKey, class Alloc, class BucketPolicy>
+inline bool operator ==(const hash_set<Value, HashFcn, EqualKey, Alloc, BucketPolicy>& hs1, 
+const hash_set<Value, HashFcn, EqualKey, Alloc, BucketPolicy>& hs2)
 {
     return hs1.rep == hs2.rep;
 }
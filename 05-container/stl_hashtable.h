@@ -7,6 +7,9 @@
 #include "02-allocator/stl_alloc.h"
 #include "04-container/stl_vector.h"
 #include "05-container/stl_pair.h"
+#include "05-container/stl_hash_fun.h" // __stl_hash_mix
+#include "03-iterator/type_traits.h" // __enable_if_transparent2
+#include "01-config/stl_threads.h" // __stl_parallel_run
 
 /* inner global functions
  */
@@ -22,33 +25,137 @@ static const unsigned long __stl_prime_list[__stl_num_primes] = {
     1610612741, 3221225473ul, 4294967291ul
 };
 
+//渐进式重建时,每次插入顺便搬移的旧bucket个数(空的也算).
+//表格每次成长约为两倍,在下一次成长之前必有足够的插入次数把旧buckets搬完
+static const int __stl_rehash_step = 4;
+
+//批次查找/插入时每一轮处理的键值个数: 这么多个互不相关的cache miss同时在途,
+//足以填满CPU的line fill buffer,又不至于让先预取的cache line在使用前就被挤出
+static const int __stl_batch_size = 16;
+
+//平行版本的建构/清除/复制中,每个线程至少分到这么多个元素才值得多开一个线程
+static const size_t __stl_parallel_grain = 32768;
+
 inline unsigned long __stl_next_prime(unsigned long n)
 {
     const unsigned long* first = __stl_prime_list;
     const unsigned long* last = __stl_prime_list + __stl_num_primes;
     const unsigned long* pos = lower_bound(first, last, n);
     //lower_bound()泛型算法<第六章>
-    return pos = last ? *(last - 1) : *pos;
+    return pos == last ? *(last - 1) : *pos;
 }
 
-template <class Value>
+/* bucket policy: 决定bucket个数如何成长,以及hash值如何对应到bucket
+ *
+ * 原本的bkt_num_key()是hash(key) % n,n为执行期才知道的质数,
+ * 每次find/insert/重建的每个节点都要付出一次整数除法(数十个时钟周期).
+ * 两种策略皆以hashtable的最后一个模板参数选用:
+ *
+ *   __hashtable_prime_policy(缺省): 仍然采用__stl_prime_list,但每个质数各有一个
+ *     以编译期常数取模的函数(编译器会把除法换成乘法与移位),
+ *     执行期只是经由函数指针调用,不再有除法指令.
+ *   __hashtable_power2_policy: bucket个数为2的幂,以位元遮罩取索引.
+ *     hash<int>等是identity,取低位会让规律的键值(连续整数、对齐的指针)挤在一起,
+ *     所以先以__stl_hash_mix()搅拌.
+ *
+ * 策略物件内含"目前bucket个数"所需的状态,重建时另造一个,成功后才换入.
+ */
+
+//以编译期常数P取模
+template <unsigned long P>
+inline size_t __stl_mod_prime(size_t h) { return h % P; }
+
+typedef size_t (*__stl_mod_function)(size_t);
+
+//与__stl_prime_list一一对应
+static const __stl_mod_function __stl_prime_mod_list[__stl_num_primes] = {
+    &__stl_mod_prime<53ul>,         &__stl_mod_prime<97ul>,
+    &__stl_mod_prime<193ul>,        &__stl_mod_prime<389ul>,
+    &__stl_mod_prime<769ul>,        &__stl_mod_prime<1543ul>,
+    &__stl_mod_prime<3079ul>,       &__stl_mod_prime<6151ul>,
+    &__stl_mod_prime<12289ul>,      &__stl_mod_prime<24593ul>,
+    &__stl_mod_prime<49157ul>,      &__stl_mod_prime<98317ul>,
+    &__stl_mod_prime<196613ul>,     &__stl_mod_prime<393241ul>,
+    &__stl_mod_prime<786433ul>,     &__stl_mod_prime<1572869ul>,
+    &__stl_mod_prime<3145739ul>,    &__stl_mod_prime<6291469ul>,
+    &__stl_mod_prime<12582917ul>,   &__stl_mod_prime<25165843ul>,
+    &__stl_mod_prime<50331653ul>,   &__stl_mod_prime<100663319ul>,
+    &__stl_mod_prime<201326611ul>,  &__stl_mod_prime<402653189ul>,
+    &__stl_mod_prime<805306457ul>,  &__stl_mod_prime<1610612741ul>,
+    &__stl_mod_prime<3221225473ul>, &__stl_mod_prime<4294967291ul>
+};
+
+struct __hashtable_prime_policy {
+    __stl_mod_function mod; //目前bucket个数所对应的取模函数
+    size_t n;               //目前bucket个数
+
+    __hashtable_prime_policy() : mod(0), n(1) {}
+
+    static size_t next_size(size_t hint) { return __stl_next_prime(hint); }
+    static size_t max_size() { return __stl_prime_list[__stl_num_primes - 1]; }
+
+    void set_bucket_count(size_t count)
+    {
+        const unsigned long* first = __stl_prime_list;
+        const unsigned long* last = __stl_prime_list + __stl_num_primes;
+        const unsigned long* pos = lower_bound(first, last, (unsigned long)count);
+        //不在质数表中的个数(理论上不会发生)退回一般的取模
+        mod = (pos != last && *pos == count) ? __stl_prime_mod_list[pos - first] : 0;
+        n = count;
+    }
+    size_t index(size_t h) const { return mod ? mod(h) : h % n; }
+};
+
+struct __hashtable_power2_policy {
+    size_t mask; //bucket个数减1
+
+    __hashtable_power2_policy() : mask(0) {}
+
+    static size_t next_size(size_t hint)
+    {
+        size_t n = 16; //最小的表格
+        while (n < hint && n < max_size())
+            n <<= 1;
+        return n;
+    }
+    static size_t max_size() { return size_t(1) << (sizeof(size_t) * 8 - 1); }
+
+    void set_bucket_count(size_t count) { mask = count - 1; }
+    size_t index(size_t h) const { return __stl_hash_mix(h) & mask; }
+};
+
+typedef __hashtable_prime_policy prime_bucket_policy;
+typedef __hashtable_power2_policy power2_bucket_policy;
+
+//CacheHash为__true_type时,节点另外记录元素的完整hash值(见<stl_hash_fun.h>的__hash_code_traits):
+//重建与迭代器前进时不必重新计算hash,查找时hash值不同者也不必调用equals比较
+template <class Value, class CacheHash = __false_type>
 struct __hashtable_node
 {
     __hashtable_node* next;
     Value val;
 };
 
+template <class Value>
+struct __hashtable_node<Value, __true_type>
+{
+    __hashtable_node* next;
+    size_t hash_code; //hash(get_key(val))
+    Value val;
+};
+
 //declearation
-template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc=alloc>
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc=alloc,
+          class BucketPolicy=__hashtable_prime_policy>
 class hashtable;
 
-template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc>
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc, class BucketPolicy>
 struct __hashtable_iterator {
-    typedef hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc> hashtable;
-    typedef __hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc> iterator;
-    typedef __hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc> const_iterator;
+    typedef hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy> hashtable;
+    typedef __hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy> iterator;
+    typedef __hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy> const_iterator;
 
-    typedef __hashtable_node<Value> node;
+    typedef __hashtable_node<Value, typename __hash_code_traits<HashFcn>::cache_hash_code> node;
 
     typedef forward_iterator_tag iterator_category;
     typedef Value value_type;
@@ -71,23 +178,33 @@ struct __hashtable_iterator {
     bool operator !=(const iterator& it) const { return cur != it->cur; }
 };
 
-template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc>
-__hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>& 
-__hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::operator ++()
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc, class BucketPolicy>
+__hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>& 
+__hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::operator ++()
 {
     const node* old = cur;
     cur = cur->next;
     if (!cur) {
-        size_type bucket = ht->bkt_num(old->val);
-        while (!cur && ++bucket < ht->bucket.size()) //注意: operator++
-            cur = ht->buckets[bucket];
+        //先走新buckets,渐进式重建期间再接着走旧buckets中尚未搬移的部分
+        size_type bucket;
+        if (ht->rehashing() && (bucket = ht->bkt_num(old, ht->old_policy)) >= ht->migrate_pos) {
+            //节点位于尚未搬移的旧bucket
+            while (!cur && ++bucket < ht->old_buckets.size())
+                cur = ht->old_buckets[bucket];
+        } else {
+            bucket = ht->bkt_num(old);
+            while (!cur && ++bucket < ht->buckets.size()) //注意: operator++
+                cur = ht->buckets[bucket];
+            for (bucket = ht->migrate_pos; !cur && bucket < ht->old_buckets.size(); ++bucket)
+                cur = ht->old_buckets[bucket];
+        }
     }
     return *this;
 }
 
-template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc>
-__hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>
-__hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::operator ++(int)
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc, class BucketPolicy>
+__hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>
+__hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::operator ++(int)
 {
     iterator tmp = *this;
     ++*this; //调用operator++()
@@ -99,56 +216,328 @@ __hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::operator
 //ExtractKey:从节点中取出键值的方法(函数或者仿函数)
 //EqualKey:判断键值相同与否的方案(函数或者仿函数)
 //Alloc:空间配置器,缺省使用std::alloc
-template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc>
+//BucketPolicy:bucket个数的成长与索引方式,缺省为质数取模(__hashtable_prime_policy)
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc, class BucketPolicy>
 class hashtable {
 public:
     typedef HashFcn hasher;     //为模版类型参数重新定义一个名称
     typedef EqualKey key_equal; //为模版类型参数重新定义一个名称
     typedef size_t size_type;
+    //与__hashtable_iterator相同: const_iterator与iterator同型别
+    typedef __hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy> iterator;
+    typedef __hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy> const_iterator;
 
     //以下三者都是function object. <stl_hash_fun.h>中定义数个标准型别(如int,c_str等)的hasher
     hasher hash;
     key_equal equals;
     ExtractKey get_key;
 
-    typedef __hashtable_node<Value> node;
+    typedef __hashtable_node<Value, typename __hash_code_traits<HashFcn>::cache_hash_code> node;
     typedef simple_alloc<node, Alloc> node_allocator;
 
     vector<node*, Alloc> buckets; //以vector完成
     size_type num_elements;
+    BucketPolicy bucket_policy;   //与buckets.size()同步
+
+    //渐进式重建(incremental rehash)的状态. 一般的resize()一次把所有节点搬进新buckets,
+    //元素上亿时,恰好越过门槛的那次插入会停顿数秒.开启渐进式重建后,成长时只配置新buckets,
+    //旧buckets留在old_buckets中,之后每次插入顺便搬移__stl_rehash_step个旧bucket.
+    //搬移期间,键值落在旧bucket[i]且i >= migrate_pos者仍归属旧bucket(新插入的也一样),
+    //其余归属新buckets,所以每次查找仍只需走一条串行
+    vector<node*, Alloc> old_buckets; //非空即表示正在重建
+    BucketPolicy old_policy;          //与old_buckets.size()同步
+    size_type migrate_pos;            //old_buckets[0, migrate_pos)已搬移完毕
+    bool incremental;                 //是否采用渐进式重建,缺省为否
+
+    float max_load;     //负载超过此值即成长
+    float shrink_load;  //删除后负载低于此值即缩小,0表示永不缩小
 public:
     // bucket个数即bucket vector的大小
     size_type bucket_count() const { return buckets.size(); }
-    size_type max_buckets_count() const { return __stl_prime_list[__stl_num_primes-1]; }
+    size_type max_buckets_count() const { return BucketPolicy::max_size(); }
+    size_type size() const { return num_elements; }
+    size_type max_size() const { return size_type(-1); }
+    bool empty() const { return size() == 0; }
     // ...
 
     hashtable(size_type n, const HashFcn& hf, const EqualKey& eql) :
-        hash(hf), equals(eql), get_key(ExtractKey()), num_elements(0) { initialize_buckets(n); }
+        hash(hf), equals(eql), get_key(ExtractKey()), num_elements(0),
+        migrate_pos(0), incremental(false), max_load(1.0f), shrink_load(0.0f)
+        { initialize_buckets(n); }
+
+    //负载因子 = 元素个数 / bucket个数. 插入使负载超过max_load_factor()时表格成长,
+    //缺省1.0,即原本"元素个数大于bucket个数就重建"的规则.
+    //调低则串行较短而buckets较多,调高则反之
+    float load_factor() const { return float(num_elements) / float(buckets.size()); }
+    float max_load_factor() const { return max_load; }
+    void max_load_factor(float z)
+    {
+        if (!(z > 0)) //非正数(及NaN)会使buckets_for()除以0或得到巨大的bucket个数: 不予接受,维持原值
+            return;
+        max_load = z;
+        resize(num_elements); //调低之后可能需要立刻成长
+    }
+
+    //删除元素之后负载低于z就缩小表格,缩至负载约为max_load_factor()的一半,
+    //避免随后的插入又立刻成长. 缺省为0(永不缩小).
+    //注意: 缩小即重建,删除会因而使其他迭代器失效,所以必须明确开启
+    float shrink_load_factor() const { return shrink_load; }
+    void shrink_load_factor(float z) { shrink_load = z > 0 ? z : 0.0f; } //非正数(及NaN)都视为0
+
+    //预留足以容纳n个元素的buckets(只增不减),之后插入n个元素都不会再重建.
+    //即使开启了渐进式重建,这里也是立刻一次完成
+    void reserve(size_type n)
+    {
+        const size_type want = next_size(buckets_for(n));
+        if (want > buckets.size()) {
+            finish_rehash();
+            rehash_to(want);
+        }
+    }
+    //令bucket个数至少为n,且足以在max_load_factor()之内容纳现有元素;可增可减
+    void rehash(size_type n)
+    {
+        finish_rehash();
+        const size_type min_n = buckets_for(num_elements);
+        const size_type want = next_size(n > min_n ? n : min_n);
+        if (want != buckets.size())
+            rehash_to(want);
+    }
+
+    //开启或关闭渐进式重建;关闭时若正在重建,立刻一次搬完
+    void set_incremental_rehash(bool on)
+    {
+        incremental = on;
+        if (!on)
+            finish_rehash();
+    }
+    bool incremental_rehash() const { return incremental; }
+    bool rehashing() const { return !old_buckets.empty(); }
 
     void clear();
     void copy_from(const hashtable& ht);
-    iterator find(const key_type& key)
+    iterator find(const key_type& key) { return iterator(find_node(key), this); }
+    //const_iterator与iterator同型别,迭代器记着的是非const的表格指针,只能以const_cast取得
+    const_iterator find(const key_type& key) const
     {
-        size_type n = bkt_num_key(key); //首先寻找落在哪一个bucket内
-        node* first;
-        //从bucket list的头开始,一一比对每个元素的键值.比对成功就跳出
-        for (first=buckets[n]; first && !equals(get_key(first->val), key); 
-             first = first->next) {
+        return const_iterator(find_node(key), const_cast<hashtable*>(this));
+    }
+
+    iterator begin()
+    {
+        for (size_type n = 0; n < buckets.size(); ++n)
+            if (buckets[n])
+                return iterator(buckets[n], this);
+        for (size_type n = migrate_pos; n < old_buckets.size(); ++n)
+            if (old_buckets[n])
+                return iterator(old_buckets[n], this);
+        return end();
+    }
+    iterator end() { return iterator(0, this); }
+    iterator begin() const { return const_cast<hashtable*>(this)->begin(); }
+    iterator end() const { return const_cast<hashtable*>(this)->end(); }
+
+    //删除键值为key的所有元素,返回删除的个数
+    size_type erase(const key_type& key);
+    //删除it所指元素,其余元素的位置不变(除非因此缩小了表格)
+    void erase(const iterator& it)
+    {
+        if (node* p = it.cur) {
+            erase_node(p);
+            shrink_if_needed();
+        }
+    }
+    void erase(iterator first, iterator last)
+    {
+        while (first != last) {
+            node* p = first.cur;
+            ++first; //先前进,再删除p
+            erase_node(p);
+        }
+        shrink_if_needed();
+    }
+
+    //节点把手(node handle): 拥有一个由extract()摘下、仍含着元素的节点,与rb_tree::node_type相同.
+    //插回同型别的表格只是重新串上,不配置记忆体、不复制元素;复制即转移所有权
+    class node_type {
+        friend class hashtable;
+    private:
+        mutable node* ptr;
+        explicit node_type(node* p) : ptr(p) {}
+    public:
+        node_type() : ptr(0) {}
+        node_type(const node_type& x) : ptr(x.ptr) { x.ptr = 0; }
+        node_type& operator=(const node_type& x)
+        {
+            if (this != &x) {
+                release();
+                ptr = x.ptr;
+                x.ptr = 0;
+            }
+            return *this;
+        }
+        ~node_type() { release(); }
+
+        bool empty() const { return ptr == 0; }
+        value_type& value() const { return ptr->val; }
+        //节点不在表格中,可以修改键值后再插回;快取的hash值在插回时重新计算
+        key_type& key() const { return const_cast<key_type&>(ExtractKey()(ptr->val)); }
+        void swap(node_type& x) { __STD::swap(ptr, x.ptr); }
+    private:
+        void release()
+        {
+            if (ptr) {
+                destory(&ptr->val);
+                node_allocator::deallocate(ptr);
+                ptr = 0;
+            }
+        }
+    };
+
+    //摘下it所指节点,其余元素的位置不变(除非因此缩小了表格)
+    node_type extract(const iterator& it)
+    {
+        node* p = it.cur;
+        if (p) {
+            unlink_node(p);
+            --num_elements;
+            shrink_if_needed();
         }
-        return iterator(first, this);
+        return node_type(p);
     }
+    //摘下键值为key的(第一个)节点,没有则返回空把手
+    node_type extract(const key_type& key) { return extract(find(key)); }
+    //插回nh所拥有的节点: 成功则nh成为空把手;键值重复时不插入,节点仍留在nh中,
+    //返回的迭代器指向表格中键值相同的元素. nh为空时返回(end(), false)
+    pair<iterator, bool> insert_unique(node_type& nh);
+    iterator insert_equal(node_type& nh);
+    //把source的节点逐一改串到*this(键值重复者留在source中),不配置记忆体.
+    //搬过来的元素的迭代器会失效(迭代器记着所属的表格),reference与指针仍然有效
+    void merge_unique(hashtable& source) { merge_from(source, true); }
+    void merge_equal(hashtable& source) { merge_from(source, false); }
 
-    size_type count(const key_type& key) const
+    size_type count(const key_type& key) const { return count_nodes(key); }
+    pair<iterator, iterator> equal_range(const key_type& key) { return equal_nodes(key); }
+    pair<const_iterator, const_iterator> equal_range(const key_type& key) const
     {
-        const size_type n = bkt_num_key(key); //首先寻找在哪一个bucket内
-        size_type result = 0;
-        //以下从bucket list的头开始,一一比对每个元素的键值.比对成功就累加1.
-        for (const node* cur=buckets[n]; cur; cur=cur->next)
-            if (equals(get_key(cur->val), key))
-                ++result;
-        return result;
+        return const_cast<hashtable*>(this)->equal_nodes(key);
+    }
+
+    //异质查找: HashFcn与EqualKey皆透明(定义了is_transparent)时,可以用键值以外的型别查找,
+    //例如以const char*查找string键值而不必构造临时string.
+    //用户须保证hash(k)与hash(Key(k))相等
+    template <class K>
+    typename __enable_if_transparent2<HashFcn, EqualKey, K, iterator>::type
+    find(const K& key) { return iterator(find_node(key), this); }
+    template <class K>
+    typename __enable_if_transparent2<HashFcn, EqualKey, K, size_type>::type
+    count(const K& key) const { return count_nodes(key); }
+    template <class K>
+    typename __enable_if_transparent2<HashFcn, EqualKey, K, pair<iterator, iterator> >::type
+    equal_range(const K& key) { return equal_nodes(key); }
+    //const版本供hash_set/hash_multiset的const成员使用
+    template <class K>
+    typename __enable_if_transparent2<HashFcn, EqualKey, K, const_iterator>::type
+    find(const K& key) const { return const_iterator(find_node(key), const_cast<hashtable*>(this)); }
+    template <class K>
+    typename __enable_if_transparent2<HashFcn, EqualKey, K, pair<const_iterator, const_iterator> >::type
+    equal_range(const K& key) const { return const_cast<hashtable*>(this)->equal_nodes(key); }
+
+    //批次查找: 依序对[first, last)中的每个键值写出一个迭代器到out(找不到者为end()),返回out的终点.
+    //逐一find()时每次查找都要先等buckets[n]的cache miss,再等串行第一个节点的cache miss.
+    //这里每__stl_batch_size个键值为一轮: 先算出全部的hash值与bucket位址并预取,
+    //再预取各串行的头节点,最后才逐一比对,使一轮之中的cache miss得以重叠
+    template <class ForwardIterator, class OutputIterator>
+    OutputIterator find_batch(ForwardIterator first, ForwardIterator last, OutputIterator out)
+    {
+        size_t h[__stl_batch_size];
+        node** head[__stl_batch_size];
+        while (first != last) {
+            ForwardIterator cur = first;
+            const int k = prefetch_batch(first, last, h, head);
+            for (int i = 0; i < k; ++i, ++cur, ++out)
+                *out = iterator(find_in_chain(*head[i], *cur, h[i]), this);
+        }
+        return out;
+    }
+    template <class ForwardIterator, class OutputIterator>
+    OutputIterator find_batch(ForwardIterator first, ForwardIterator last, OutputIterator out) const
+    {
+        return const_cast<hashtable*>(this)->find_batch(first, last, out);
+    }
+    //批次计数: 对每个键值写出count(key)
+    template <class ForwardIterator, class OutputIterator>
+    OutputIterator count_batch(ForwardIterator first, ForwardIterator last, OutputIterator out) const
+    {
+        size_t h[__stl_batch_size];
+        node** head[__stl_batch_size];
+        hashtable* self = const_cast<hashtable*>(this); //prefetch_batch()不会修改表格
+        while (first != last) {
+            ForwardIterator cur = first;
+            const int k = self->prefetch_batch(first, last, h, head);
+            for (int i = 0; i < k; ++i, ++cur, ++out) {
+                size_type result = 0;
+                for (const node* n = *head[i]; n; n = n->next)
+                    if (node_matches(n, *cur, h[i]))
+                        ++result;
+                *out = result;
+            }
+        }
+        return out;
+    }
+    //批次插入: 与逐一insert_unique()/insert_equal()的结果相同.
+    //每一轮先预留这一轮所需的空间(之后这一轮之中不会重建,预先算出的bucket位址才会一直有效)
+    template <class ForwardIterator>
+    void insert_unique_batch(ForwardIterator first, ForwardIterator last)
+    {
+        size_t h[__stl_batch_size];
+        node** head[__stl_batch_size];
+        while (first != last) {
+            ForwardIterator cur = first;
+            resize(num_elements + batch_length(first, last));
+            const int k = prefetch_batch(first, last, h, head);
+            for (int i = 0; i < k; ++i, ++cur)
+                insert_unique_at(head[i], *cur, h[i]);
+        }
+    }
+    template <class ForwardIterator>
+    void insert_equal_batch(ForwardIterator first, ForwardIterator last)
+    {
+        size_t h[__stl_batch_size];
+        node** head[__stl_batch_size];
+        while (first != last) {
+            ForwardIterator cur = first;
+            resize(num_elements + batch_length(first, last));
+            const int k = prefetch_batch(first, last, h, head);
+            for (int i = 0; i < k; ++i, ++cur)
+                insert_equal_at(head[i], *cur, h[i]);
+        }
     }
 
+    //以下为大型表格(数千万个元素)的平行版本,结果与对应的单线程版本完全相同.
+    //threads为0表示使用全部硬件线程;元素太少、或没有定义__STL_PTHREADS时退化为单线程.
+    //平行执行期间HashFcn与EqualKey会被多个线程同时调用,它们不可抛出异常.
+    //
+    //平行建构: 先一次预留足够的buckets,然后依bucket编号把buckets切成threads段,每段归一个线程.
+    //各线程算出自己那份输入的hash值与所属的段;节点由调用者线程依序配置(alloc并未加锁),
+    //同时依所属的段排好;最后每个线程只把属于自己那一段的节点串进buckets,彼此不会碰到同一条串行.
+    //同一段中节点的处理次序与输入次序相同,所以重复键值的取舍与排列都与逐一插入相同
+    template <class RandomAccessIterator>
+    void insert_unique_parallel(RandomAccessIterator first, RandomAccessIterator last, size_type threads = 0)
+        { insert_parallel(first, last, threads, true); }
+    template <class RandomAccessIterator>
+    void insert_equal_parallel(RandomAccessIterator first, RandomAccessIterator last, size_type threads = 0)
+        { insert_parallel(first, last, threads, false); }
+    //平行清除: 每个线程负责一段buckets. 配置器不能同时被多个线程使用时(见__alloc_thread_safe),
+    //只有元素的解构是平行的,节点仍由调用者线程逐一归还;
+    //此时若元素的解构并非trivial(可能经由同一个配置器释放内存),就改以clear()逐一清除
+    void clear_parallel(size_type threads = 0);
+    //平行复制: 每个线程复制ht的一段buckets. 配置器不能同时被多个线程使用时,
+    //所有节点先由调用者线程一次配置好,各线程只做元素的复制建构与串接;
+    //此时若元素的复制并非trivial,就改以copy_from()逐一复制.
+    //若有元素的复制抛出异常,清除已复制的部分后改以copy_from()重做,异常于是在调用者线程中抛出
+    void copy_from_parallel(const hashtable& ht, size_type threads = 0);
+
     hasher funct() const { return hash; }
     key_equal key_eq() const { return equals; }
 private:
@@ -173,11 +562,362 @@ private:
         const size_type n_buckets = next_size(n);
         buckets.reserve(n_buckets);
         buckets.insert(buckets.end(), n_buckets, (node*)0);
+        bucket_policy.set_bucket_count(n_buckets);
         num_elements = 0;
-        //next_size()返回最接近n并大于n的质数
+        //next_size()返回不小于n的合法bucket个数(缺省策略下为质数)
     }
 
-    size_type next_size(size_type n) const { return __stl_next_prime(n); }
+    size_type next_size(size_type n) const { return BucketPolicy::next_size(n); }
+
+    //hash值为h的键值所归属的串行(bucket list)头部,渐进式重建期间可能位于旧buckets
+    node** bucket_head(size_t h)
+    {
+        if (rehashing()) {
+            const size_type n = old_policy.index(h);
+            if (n >= migrate_pos)
+                return &old_buckets[n];
+        }
+        return &buckets[bucket_policy.index(h)];
+    }
+    node* const* bucket_head(size_t h) const
+    {
+        return const_cast<hashtable*>(this)->bucket_head(h);
+    }
+
+    //快取hash值(cached hash code)的相关操作,以__true_type/__false_type在编译期选择
+    typedef typename __hash_code_traits<HashFcn>::cache_hash_code cache_hash_code;
+
+    size_t node_hash(const node* n) const { return node_hash(n, cache_hash_code()); }
+    size_t node_hash(const node* n, __true_type) const { return n->hash_code; }
+    size_t node_hash(const node* n, __false_type) const { return hash(get_key(n->val)); }
+
+    void store_hash(node* n, size_t h) { store_hash(n, h, cache_hash_code()); }
+    void store_hash(node* n, size_t h, __true_type) { n->hash_code = h; }
+    void store_hash(node*, size_t, __false_type) {}
+
+    node* clone_node(const node* n)
+    {
+        node* tmp = new_node(n->val);
+        copy_hash(tmp, n, cache_hash_code());
+        return tmp;
+    }
+    void copy_hash(node* to, const node* from, __true_type) { to->hash_code = from->hash_code; }
+    void copy_hash(node*, const node*, __false_type) {}
+
+    //节点n的键值是否为key(h为hash(key)): 快取hash值时先比较hash值,不同者必不相等
+    template <class K>
+    bool node_matches(const node* n, const K& key, size_t h) const
+    {
+        return node_matches(n, key, h, cache_hash_code());
+    }
+    template <class K>
+    bool node_matches(const node* n, const K& key, size_t h, __true_type) const
+    {
+        return n->hash_code == h && equals(get_key(n->val), key);
+    }
+    template <class K>
+    bool node_matches(const node* n, const K& key, size_t, __false_type) const
+    {
+        return equals(get_key(n->val), key);
+    }
+
+    //以下查找函数以模板实现,供一般版本与异质版本共用
+    template <class K>
+    node* find_node(const K& key) const
+    {
+        const size_t h = hash(key);
+        node* first;
+        //首先寻找落在哪一个bucket内,然后从bucket list的头开始,一一比对每个元素的键值.比对成功就跳出
+        for (first=*bucket_head(h); first && !node_matches(first, key, h);
+             first = first->next) {
+        }
+        return first;
+    }
+    template <class K>
+    size_type count_nodes(const K& key) const
+    {
+        const size_t h = hash(key);
+        size_type result = 0;
+        //首先寻找在哪一个bucket内,以下从bucket list的头开始,一一比对每个元素的键值.比对成功就累加1.
+        for (const node* cur=*bucket_head(h); cur; cur=cur->next)
+            if (node_matches(cur, key, h))
+                ++result;
+        return result;
+    }
+    //键值相同的节点在串行中必然相邻(insert_equal()插在相同者之后),所以只需找出这一段
+    template <class K>
+    pair<iterator, iterator> equal_nodes(const K& key)
+    {
+        node* first = find_node(key);
+        if (!first)
+            return pair<iterator, iterator>(end(), end());
+        node* cur = first->next;
+        while (cur && equals(get_key(cur->val), key))
+            cur = cur->next;
+        iterator last(cur, this);
+        if (!cur) { //这一段位于串行尾端: 以前进的方式跳到下一个非空bucket
+            last = iterator(first, this);
+            while (last.cur && equals(get_key(last.cur->val), key))
+                ++last;
+        }
+        return pair<iterator, iterator>(iterator(first, this), last);
+    }
+
+    //批次操作的第一阶段: 从first起取至多__stl_batch_size个元素,算出hash值与所属串行的头部,
+    //同时预取buckets中的槽位与各串行的头节点. first前进到这一轮的终点,返回这一轮的个数.
+    //元素可以是键值(查找)或实值(插入),以get_batch_key()区分
+    template <class ForwardIterator>
+    int prefetch_batch(ForwardIterator& first, ForwardIterator last, size_t* h, node*** head)
+    {
+        int k = 0;
+        for (; k < __stl_batch_size && first != last; ++k, ++first) {
+            h[k] = hash(get_batch_key(*first));
+            head[k] = bucket_head(h[k]);
+            __STL_PREFETCH(head[k]);
+        }
+        //槽位的内容可能还没到,但读取它只会等待这一个位址,其余预取仍在途中
+        for (int i = 0; i < k; ++i)
+            __STL_PREFETCH(*head[i]);
+        return k;
+    }
+    //从first起的这一轮的元素个数(不超过__stl_batch_size)
+    template <class ForwardIterator>
+    static size_type batch_length(ForwardIterator first, ForwardIterator last)
+    {
+        size_type n = 0;
+        for (; n < size_type(__stl_batch_size) && first != last; ++first)
+            ++n;
+        return n;
+    }
+    //查找时元素即键值,插入时则从实值中取出键值
+    template <class K>
+    const K& get_batch_key(const K& key) const { return key; }
+    const key_type& get_batch_key(const value_type& obj) const { return get_key(obj); }
+
+    template <class K>
+    node* find_in_chain(node* first, const K& key, size_t h) const
+    {
+        for (; first && !node_matches(first, key, h); first = first->next) {
+        }
+        return first;
+    }
+    //hash值与串行头部都已算好的插入,供insert_*_noresize()与批次插入共用
+    pair<iterator, bool> insert_unique_at(node** head, const value_type& obj, size_t h);
+    iterator insert_equal_at(node** head, const value_type& obj, size_t h);
+
+    //平行算法实际使用的线程数
+    static size_type parallel_threads(size_type threads, size_type n)
+    {
+        if (threads == 0)
+            threads = __stl_hardware_concurrency();
+        if (threads > __stl_max_parallel_threads)
+            threads = __stl_max_parallel_threads;
+        if (threads > n / __stl_parallel_grain)
+            threads = n / __stl_parallel_grain;
+        return threads ? threads : 1;
+    }
+    //元素的解构/复制能否交给其他线程: trivial者不碰配置器,否则须配置器可以平行使用
+    static bool parallel_elements(__true_type) { return true; }
+    static bool parallel_elements(__false_type) { return __alloc_thread_safe<Alloc>::value; }
+    //bucket n属于threads段中的哪一段
+    size_type bucket_owner(size_type n, size_type threads) const
+    {
+        return n * threads / buckets.size();
+    }
+    //第t段的第一个bucket,恰为bucket_owner()的反函数的下界
+    size_type owner_first_bucket(size_type t, size_type threads) const
+    {
+        return (buckets.size() * t + threads - 1) / threads;
+    }
+
+    template <class RandomAccessIterator>
+    void insert_parallel(RandomAccessIterator first, RandomAccessIterator last,
+                         size_type threads, bool unique);
+
+    //平行建构第一步: 第t个线程算出第t份输入中每个元素所属的段,并统计各段的个数
+    template <class RandomAccessIterator>
+    struct parallel_partition_task {
+        hashtable* ht;
+        RandomAccessIterator first;
+        size_type n, threads;
+        unsigned char* owner;  //owner[i]: 第i个元素所属的段
+        size_type* counts;     //counts[t * threads + o]: 第t份输入中属于第o段的个数
+
+        void operator()(size_t t)
+        {
+            size_type* cnt = counts + t * threads;
+            const size_type last = (t + 1) * n / threads;
+            for (size_type i = t * n / threads; i < last; ++i) {
+                const size_type b = ht->bucket_policy.index(ht->hash(ht->get_key(first[i])));
+                owner[i] = (unsigned char)ht->bucket_owner(b, threads);
+                ++cnt[owner[i]];
+            }
+        }
+    };
+    //平行建构最后一步: 第o个线程把sorted[bounds[o], bounds[o + 1])串进第o段buckets.
+    //串入者从sorted中清除(剩下的是重复而未插入的节点),linked[o]记录串入的个数
+    struct parallel_link_task {
+        hashtable* ht;
+        node** sorted;
+        const size_type* bounds;
+        size_type* linked;
+        bool unique;
+
+        void operator()(size_t o)
+        {
+            size_type count = 0;
+            for (size_type i = bounds[o]; i < bounds[o + 1]; ++i) {
+                node* p = sorted[i];
+                const size_t h = ht->hash(ht->get_key(p->val));
+                ht->store_hash(p, h);
+                if (ht->link_node(&ht->buckets[ht->bucket_policy.index(h)], p, h, unique)) {
+                    sorted[i] = 0;
+                    ++count;
+                }
+            }
+            linked[o] = count;
+        }
+    };
+    //把已配置好的节点p串进head所指串行,规则与insert_unique_at()/insert_equal_at()相同.
+    //unique且已有相同键值时不串入,返回false
+    bool link_node(node** head, node* p, size_t h, bool unique)
+    {
+        for (node* cur = *head; cur; cur = cur->next)
+            if (node_matches(cur, get_key(p->val), h)) {
+                if (unique)
+                    return false;
+                p->next = cur->next;
+                cur->next = p;
+                return true;
+            }
+        p->next = *head;
+        *head = p;
+        return true;
+    }
+
+    //第t个线程清除第t段buckets. release为false时只解构元素,节点留给调用者线程归还
+    struct parallel_clear_task {
+        hashtable* ht;
+        size_type threads;
+        bool release;
+
+        void operator()(size_t t)
+        {
+            const size_type last = ht->owner_first_bucket(t + 1, threads);
+            for (size_type i = ht->owner_first_bucket(t, threads); i < last; ++i)
+                for (node* cur = ht->buckets[i]; cur; cur = cur->next)
+                    destory(&cur->val);
+            if (!release)
+                return;
+            for (size_type i = ht->owner_first_bucket(t, threads); i < last; ++i) {
+                node* cur = ht->buckets[i];
+                while (cur) {
+                    node* next = cur->next;
+                    node_allocator::deallocate(cur);
+                    cur = next;
+                }
+                ht->buckets[i] = 0;
+            }
+        }
+    };
+
+    //第t个线程复制ht的第t段buckets(两者的buckets个数相同,节点落在同一个bucket).
+    //配置器可以平行使用时各线程自行配置节点,否则从pool中以原子操作一次领取一批
+    struct parallel_copy_task {
+        hashtable* ht;
+        const hashtable* src;
+        node** pool;              //预先配置好、尚未建构的节点;领取并建构完成者清为0
+        volatile size_type next;  //pool中下一批的起点
+        size_type threads;
+        volatile int failed;      //有元素的复制抛出了异常
+
+        enum { batch = 256 };
+
+        void operator()(size_t t)
+        {
+            size_type first = 0, last = 0; //目前领到的这一批pool[first, last)
+            const size_type end = ht->owner_first_bucket(t + 1, threads);
+            for (size_type i = ht->owner_first_bucket(t, threads); i < end; ++i) {
+                node** tail = &ht->buckets[i];
+                for (const node* cur = src->buckets[i]; cur; cur = cur->next) {
+                    if (__stl_atomic_load(&failed))
+                        return;
+                    node* p;
+                    size_type k = 0;
+                    if (pool) {
+                        if (first == last) {
+                            first = __stl_atomic_add(&next, size_type(batch)) - batch;
+                            last = first + batch;
+                        }
+                        k = first++;
+                        p = pool[k];
+                    } else {
+                        p = node_allocator::allocate();
+                    }
+                    __STL_TRY {
+                        construct(&p->val, cur->val);
+                    }
+                    __STL_CATCH_ALL {
+                        if (!pool)
+                            node_allocator::deallocate(p);
+                        __stl_atomic_store(&failed, 1);
+                        return;
+                    }
+                    if (pool)
+                        pool[k] = 0;
+                    ht->copy_hash(p, cur, cache_hash_code());
+                    p->next = 0;
+                    *tail = p; //依原来的次序串接
+                    tail = &p->next;
+                }
+            }
+        }
+    };
+
+    //以n个新buckets展开一轮渐进式重建
+    void start_rehash(size_type n);
+    //搬移至多k个旧bucket,全部搬完即结束这一轮重建
+    void rehash_step(size_type k);
+    void finish_rehash() { if (rehashing()) rehash_step(old_buckets.size()); }
+    //一次把所有节点搬进n个新buckets(调用者须保证不在渐进式重建中)
+    void rehash_to(size_type n);
+
+    //在max_load_factor()之内容纳n个元素所需的bucket个数
+    size_type buckets_for(size_type n) const
+    {
+        size_type b = size_type(float(n) / max_load);
+        if (float(b) * max_load < float(n))
+            ++b;
+        return b;
+    }
+    //从所属串行中摘下p(不释放,也不调整num_elements)
+    void unlink_node(node* p)
+    {
+        node** link = bucket_head(node_hash(p));
+        while (*link != p)
+            link = &(*link)->next;
+        *link = p->next;
+    }
+    //从所属串行中摘下p并释放
+    void erase_node(node* p)
+    {
+        unlink_node(p);
+        delete_node(p);
+        --num_elements;
+    }
+    void merge_from(hashtable& source, bool unique);
+    void shrink_if_needed()
+    {
+        if (shrink_load <= 0 || load_factor() >= shrink_load)
+            return;
+        const size_type n = next_size(buckets_for(2 * num_elements));
+        if (n >= buckets.size())
+            return; //已是最小表格
+        if (incremental)
+            start_rehash(n);
+        else
+            rehash_to(n);
+    }
 
     //插入元素,不允许重复
     pair<iterator, bool> insert_unique(const value_type& obj)
@@ -199,20 +939,24 @@ private:
     //不需要重建的情况下插入新节点,键值允许重复
     iterator insert_equal_noresize(const value_type& obj);
 
-    //version 1: 接受实值(values)和buckets的个数
-    size_type bkt_num(const value_type& obj, size_t n) const { return bkt_num_key(get_key(obj), n); }
+    //version 1: 接受实值(values)和另一组buckets的策略(重建时使用)
+    size_type bkt_num(const value_type& obj, const BucketPolicy& p) const { return bkt_num_key(get_key(obj), p); }
     //version 2: 接受实值(value)
     size_type bkt_num(const value_type& obj) const { return bkt_num_key(get_key(obj)); }
+    //以下两个版本接受节点,快取hash值时不必重新计算hash
+    size_type bkt_num(const node* n) const { return bucket_policy.index(node_hash(n)); }
+    size_type bkt_num(const node* n, const BucketPolicy& p) const { return p.index(node_hash(n)); }
     //version 3: 接受键值
-    size_type bkt_num_key(const key_type& key) const { return bkt_num_key(key, buckets.size()); }
-    //version 4: 接受键值和buckets的个数
-    size_type bkt_num_key(const key_type& key, size_t n) const { return hash(key) % n; } 
+    size_type bkt_num_key(const key_type& key) const { return bkt_num_key(key, bucket_policy); }
+    //version 4: 接受键值和buckets的策略. 不再是hash(key) % n,见本文件开头的bucket policy
+    size_type bkt_num_key(const key_type& key, const BucketPolicy& p) const { return p.index(hash(key)); }
     //hash: SGI的所有内建的hash列于5.7.7节
 };
 
-template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc>
-inline void hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::clear()
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc, class BucketPolicy>
+inline void hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::clear()
 {
+    finish_rehash(); //先让所有节点回到同一组buckets
     //针对每一个bucket
     for (size_type i=0; i<buckets.size(); ++i) {
         node* cur = buckets[i];
@@ -228,8 +972,8 @@ inline void hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::clear()
     //注意buckets vector并未释放掉空间,仍保留原来大小
 }
 
-template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc>
-inline void hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::copy_from(const hashtable &ht)
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc, class BucketPolicy>
+inline void hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::copy_from(const hashtable &ht)
 {
     //先清除己方的buckets vector.这个操作是调用vector::clear().造成所有元素为0
     buckets.clear();
@@ -239,94 +983,291 @@ inline void hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::copy_fr
     //从己方的buckets vector尾端开始,插入n个元素,其值为null指针
     //注意此时buckets vector为空,所以所谓尾端就是起始处
     buckets.insert(buckets.end(), ht.buckets.size(), (node*)0);
+    bucket_policy = ht.bucket_policy;
     __STL_TRY {
         //针对buckets vector
         for (size_type i=0; i<ht.buckets.size(); ++i) {
             //复制vector的每一个元素(是指针,指向hashtable节点)
             if (const node* cur = ht.buckets[i]) {
-                node* copy = new_node(cur->val);
+                node* copy = clone_node(cur);
                 buckets[i] = copy;
                 //针对同一个bucket list,复制每一个节点
                 for (node* next=cur->next; next; cur=next, next=cur->next) {
-                    copy->next = new_node(next->val);
+                    copy->next = clone_node(next);
                     copy = copy->next;
                 }
             }
         }
+        //对方正在渐进式重建: 其尚未搬移的旧bucket也要复制,直接放进己方的buckets
+        for (size_type i=ht.migrate_pos; i<ht.old_buckets.size(); ++i)
+            for (const node* cur=ht.old_buckets[i]; cur; cur=cur->next) {
+                node* copy = clone_node(cur);
+                const size_type n = bkt_num(copy);
+                copy->next = buckets[n];
+                buckets[n] = copy;
+            }
         num_elements = ht.num_elements; //重新登记节点个数(hashtable的大小)
     }
     __STL_UNWIND(clear());
 }
 
-template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc>
-inline void hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc, class BucketPolicy>
+template <class RandomAccessIterator>
+void hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::
+insert_parallel(RandomAccessIterator first, RandomAccessIterator last, size_type threads, bool unique)
+{
+    const size_type n = size_type(last - first);
+    finish_rehash();
+    reserve(num_elements + n); //之后不会再重建,各段的buckets固定
+    threads = parallel_threads(threads, n);
+    if (threads <= 1) {
+        for (; first != last; ++first)
+            if (unique)
+                insert_unique_noresize(*first);
+            else
+                insert_equal_noresize(*first);
+        return;
+    }
+
+    //第一步(平行): 每个元素所属的段,以及每份输入中各段的个数
+    vector<unsigned char, Alloc> owner(n, (unsigned char)0);
+    vector<size_type, Alloc> counts(threads * threads, size_type(0));
+    parallel_partition_task<RandomAccessIterator> partition = {
+        this, first, n, threads, &owner[0], &counts[0] };
+    __stl_parallel_run(threads, partition);
+
+    //第二步: 由个数算出第t份输入中属于第o段者在sorted中的起点offsets[t][o];
+    //bounds[o]为第o段在sorted中的起点
+    vector<size_type, Alloc> offsets(threads * threads, size_type(0));
+    vector<size_type, Alloc> bounds(threads + 1, size_type(0));
+    size_type pos = 0;
+    for (size_type o = 0; o < threads; ++o) {
+        bounds[o] = pos;
+        for (size_type t = 0; t < threads; ++t) {
+            offsets[t * threads + o] = pos;
+            pos += counts[t * threads + o];
+        }
+    }
+    bounds[threads] = pos;
+
+    //第三步: 在调用者线程中依序配置节点,放进所属段的位置
+    vector<node*, Alloc> sorted(n, (node*)0);
+    __STL_TRY {
+        for (size_type t = 0; t < threads; ++t) {
+            size_type* off = &offsets[t * threads];
+            const size_type end = (t + 1) * n / threads;
+            for (size_type i = t * n / threads; i < end; ++i)
+                sorted[off[owner[i]]++] = new_node(first[i]);
+        }
+    }
+    __STL_UNWIND(for (size_type i = 0; i < n; ++i) if (sorted[i]) delete_node(sorted[i]));
+
+    //第四步(平行): 各线程把自己那一段的节点串进buckets
+    vector<size_type, Alloc> linked(threads, size_type(0));
+    parallel_link_task link = { this, &sorted[0], &bounds[0], &linked[0], unique };
+    __stl_parallel_run(threads, link);
+    for (size_type o = 0; o < threads; ++o)
+        num_elements += linked[o];
+    if (unique) //释放因键值重复而未插入的节点
+        for (size_type i = 0; i < n; ++i)
+            if (sorted[i])
+                delete_node(sorted[i]);
+}
+
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc, class BucketPolicy>
+void hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::clear_parallel(size_type threads)
+{
+    finish_rehash();
+    threads = parallel_threads(threads, num_elements);
+    if (threads <= 1 ||
+        !parallel_elements(typename __type_traits<value_type>::has_trivial_destructor())) {
+        clear();
+        return;
+    }
+    const bool release = __alloc_thread_safe<Alloc>::value;
+    parallel_clear_task task = { this, threads, release };
+    __stl_parallel_run(threads, task);
+    if (!release) //元素都已解构,只剩下节点的归还
+        for (size_type i = 0; i < buckets.size(); ++i) {
+            node* cur = buckets[i];
+            while (cur) {
+                node* next = cur->next;
+                node_allocator::deallocate(cur);
+                cur = next;
+            }
+            buckets[i] = 0;
+        }
+    num_elements = 0;
+}
+
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc, class BucketPolicy>
+void hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::copy_from_parallel(const hashtable& ht, size_type threads)
+{
+    if (&ht == this)
+        return;
+    threads = parallel_threads(threads, ht.num_elements);
+    if (threads <= 1 || ht.rehashing() || //对方正在渐进式重建时,节点不在同一组buckets中
+        !parallel_elements(typename __type_traits<value_type>::has_trivial_copy_constructor())) {
+        copy_from(ht);
+        return;
+    }
+    clear_parallel(threads);
+    buckets.clear();
+    buckets.insert(buckets.end(), ht.buckets.size(), (node*)0);
+    bucket_policy = ht.bucket_policy;
+
+    //各线程一次领取一批节点,最后一批未必用完,所以每个线程多预留一批
+    vector<node*, Alloc> pool;
+    if (!__alloc_thread_safe<Alloc>::value) {
+        const size_type pool_size = ht.num_elements + threads * parallel_copy_task::batch;
+        pool.reserve(pool_size);
+        __STL_TRY {
+            for (size_type i = 0; i < pool_size; ++i)
+                pool.push_back(node_allocator::allocate());
+        }
+        __STL_UNWIND(for (size_type i = 0; i < pool.size(); ++i) node_allocator::deallocate(pool[i]));
+    }
+    parallel_copy_task task = { this, &ht, pool.empty() ? (node**)0 : &pool[0],
+                                size_type(0), threads, 0 };
+    __stl_parallel_run(threads, task);
+    num_elements = ht.num_elements;
+    //归还没有用到的节点
+    for (size_type i = 0; i < pool.size(); ++i)
+        if (pool[i])
+            node_allocator::deallocate(pool[i]);
+    if (task.failed) {
+        clear();
+        copy_from(ht);
+    }
+}
+
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc, class BucketPolicy>
+inline void hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::
     resize(size_type num_elements_hint)
 {
     //以下表格重建的规则较为奇特: 拿元素个数(新增元素计入后)和buckets vector的大小比较,如果大于后者就重建
     //因此可判断每个bucket(list)的最大容量和buckets vector的大小相同.
+    //(以上是max_load_factor()为缺省值1.0时的情形,一般而言是比较元素个数与bucket个数*max_load)
+    if (rehashing())
+        rehash_step(__stl_rehash_step); //顺便推进进行中的渐进式重建
     const size_type old_n = buckets.size();
-    if (num_elements_hint > old_n) {
-        const size_type n = next_size(num_elements_hint);
+    if (num_elements_hint > size_type(float(old_n) * max_load)) {
+        const size_type n = next_size(buckets_for(num_elements_hint));
         if (n > old_n) {
-            vector<node*, Alloc> tmp(n, (node*)0); //建立新的buckets
-            __STL_TRY {
-                //以下处理每一个旧的bucket
-                for (size_type bucket=0; bucket < old_n; ++bucket) {
-                    node* first = buckets[bucket]; //指向节点所对应之串行的起始节点
-                    //以下处理每一个旧的bucket所含(串行)的每一个节点
-                    while (first) {
-                        //找出节点落在哪个新的bucket内
-                        size_type new_bucket = bkt_num(first->val, n);
-                        //以下四个操作颇为微妙
-                        //[1] 令旧bucket指向其所对应之串行的下一个节点(以便迭代处理)
-                        buckets[bucket] = first->next;
-                        //[2][3] 将当前节点插入到新bucket内,成为对应串行的第一个节点
-                        first->next = tmp[new_bucket];
-                        tmp[new_bucket] = first;
-                        //[4] 回到旧bucket所指的待处理串行,准备处理下一个节点
-                        first = buckets[bucket]; 
-                    }
-                }
-                buckets.swap(tmp); //vector::swap(): 新旧两个buckets对调
-                //离开时释放local var tmp的内存
-            }
+            if (incremental)
+                start_rehash(n); //只配置新buckets,节点留待之后逐步搬移
+            else
+                rehash_to(n);
+        }
+    }
+}
+
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc, class BucketPolicy>
+inline void hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::
+    rehash_to(size_type n)
+{
+    const size_type old_n = buckets.size();
+    vector<node*, Alloc> tmp(n, (node*)0); //建立新的buckets
+    BucketPolicy new_policy;
+    new_policy.set_bucket_count(n);
+    //以下处理每一个旧的bucket
+    for (size_type bucket=0; bucket < old_n; ++bucket) {
+        node* first = buckets[bucket]; //指向节点所对应之串行的起始节点
+        //以下处理每一个旧的bucket所含(串行)的每一个节点
+        while (first) {
+            //找出节点落在哪个新的bucket内
+            size_type new_bucket = bkt_num(first, new_policy);
+            //以下四个操作颇为微妙
+            //[1] 令旧bucket指向其所对应之串行的下一个节点(以便迭代处理)
+            buckets[bucket] = first->next;
+            //[2][3] 将当前节点插入到新bucket内,成为对应串行的第一个节点
+            first->next = tmp[new_bucket];
+            tmp[new_bucket] = first;
+            //[4] 回到旧bucket所指的待处理串行,准备处理下一个节点
+            first = buckets[bucket];
+        }
+    }
+    buckets.swap(tmp); //vector::swap(): 新旧两个buckets对调
+    bucket_policy = new_policy;
+    //离开时释放local var tmp的内存
+}
+
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc, class BucketPolicy>
+inline typename hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::size_type
+hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::erase(const key_type& key)
+{
+    if (rehashing())
+        rehash_step(__stl_rehash_step); //顺便推进进行中的渐进式重建
+    const size_t h = hash(key);
+    node** link = bucket_head(h);
+    size_type erased = 0;
+    //走过串行,把键值相同的节点逐一摘下
+    while (node* cur = *link) {
+        if (node_matches(cur, key, h)) {
+            *link = cur->next;
+            delete_node(cur);
+            ++erased;
         }
+        else
+            link = &cur->next;
     }
+    num_elements -= erased;
+    if (erased)
+        shrink_if_needed();
+    return erased;
 }
 
-template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc>
-inline pair<typename hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::iterator, bool> 
-hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc, class BucketPolicy>
+inline pair<typename hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::iterator, bool> 
+hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::
 insert_unique_noresize(const value_type &obj)
 {
-    const size_type n = bkt_num(obj); //决定obj应该位于的bucket
-    node* first = buckets[n]; //令first指向buckets对应串行头部
+    const size_t h = hash(get_key(obj));
+    return insert_unique_at(bucket_head(h), obj, h); //决定obj应该位于的bucket
+}
+
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc, class BucketPolicy>
+inline pair<typename hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::iterator, bool>
+hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::
+insert_unique_at(node** head, const value_type &obj, size_t h)
+{
+    node* first = *head; //令first指向buckets对应串行头部
     //如果buckets[n]被占用,此时first将不为0,于是进入以下循环
     //走过bucket所对应的整个链表
     for (node* cur=first; cur; cur=cur->next)
-        if (equals(get_key(cur->val), get_key(obj))) //如果发现与链表中某键值相同,就不插入,立即返回
+        if (node_matches(cur, get_key(obj), h)) //如果发现与链表中某键值相同,就不插入,立即返回
             return pair<iterator, bool>(iterator(cur, this), false);
     //离开以上循环(或根本进入循环)时,first指向bucket所指链表的头部节点
     node* tmp = new_node(obj);
+    store_hash(tmp, h);
     tmp->next = first;
-    buckets[n] = tmp; //令新节点成为链表的第一个节点
+    *head = tmp; //令新节点成为链表的第一个节点
     ++num_elements;
     return pair<iterator, bool>(iterator(tmp, this), true);
 }
 
-template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc>
-inline typename hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::iterator
-hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc, class BucketPolicy>
+inline typename hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::iterator
+hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::
 insert_equal_noresize(const value_type &obj)
 {
-    const size_type n = bkt_num(obj); //决定obj应位于#n bucket
-    node* first = buckets[n]; //令first指向bucket对应之链表头部
+    const size_t h = hash(get_key(obj));
+    return insert_equal_at(bucket_head(h), obj, h); //决定obj应位于哪个bucket
+}
+
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc, class BucketPolicy>
+inline typename hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::iterator
+hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::
+insert_equal_at(node** head, const value_type &obj, size_t h)
+{
+    node* first = *head; //令first指向bucket对应之链表头部
     //如果buckets[n]已被占用,此时first将不为0,于是进入以下循环
     //走过bucket所对应的整个链表
     for (node* cur=first; cur; cur=cur->next)
-        if (equals(get_key(cur->val), get_key(obj))) {
+        if (node_matches(cur, get_key(obj), h)) {
             //如果发现与链表中的某键相同,就马上插入,然后返回
             node* tmp = new_node(obj); //产生新的节点
+            store_hash(tmp, h);
             tmp->next = cur->next; //将新节点插入于目前位置
             cur->next = tmp;
             ++num_elements;
@@ -334,12 +1275,117 @@ insert_equal_noresize(const value_type &obj)
         }
     //进行至此,表示没有发现重复的键值
     node* tmp = new_node(obj);
+    store_hash(tmp, h);
     tmp->next = first;
-    buckets[n] = tmp;
-    ++num_elemments;
+    *head = tmp;
+    ++num_elements;
     return iterator(tmp, this); //返回迭代器指向新增节点
 }
 
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc, class BucketPolicy>
+pair<typename hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::iterator, bool>
+hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::insert_unique(node_type& nh)
+{
+    if (nh.empty())
+        return pair<iterator, bool>(end(), false);
+    node* p = nh.ptr;
+    resize(num_elements + 1);
+    //键值可能在摘下之后被修改过,hash值一律重新计算
+    const size_t h = hash(get_key(p->val));
+    node** head = bucket_head(h);
+    if (node* cur = find_in_chain(*head, get_key(p->val), h))
+        return pair<iterator, bool>(iterator(cur, this), false);
+    store_hash(p, h);
+    p->next = *head;
+    *head = p;
+    ++num_elements;
+    nh.ptr = 0;
+    return pair<iterator, bool>(iterator(p, this), true);
+}
+
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc, class BucketPolicy>
+typename hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::iterator
+hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::insert_equal(node_type& nh)
+{
+    if (nh.empty())
+        return end();
+    node* p = nh.ptr;
+    resize(num_elements + 1);
+    const size_t h = hash(get_key(p->val));
+    store_hash(p, h);
+    link_node(bucket_head(h), p, h, false); //与insert_equal_at()相同,排在相同键值之后
+    ++num_elements;
+    nh.ptr = 0;
+    return iterator(p, this);
+}
+
+//走过source的每一条串行,把节点原地改串到*this: 先在*this中找好位置,可以串入才从source摘下,
+//所以键值重复的节点原封不动留在source中. 两者的HashFcn同型别,快取的hash值直接沿用
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc, class BucketPolicy>
+void hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::
+    merge_from(hashtable& source, bool unique)
+{
+    if (&source == this)
+        return;
+    source.finish_rehash(); //使source的节点都位于同一组buckets
+    for (size_type i = 0; i < source.buckets.size(); ++i) {
+        node** link = &source.buckets[i];
+        while (node* p = *link) {
+            node* next = p->next;
+            resize(num_elements + 1);
+            const size_t h = node_hash(p);
+            if (link_node(bucket_head(h), p, h, unique)) {
+                *link = next;
+                --source.num_elements;
+                ++num_elements;
+            }
+            else
+                link = &p->next;
+        }
+    }
+    source.shrink_if_needed();
+}
+
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc, class BucketPolicy>
+inline void hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::
+    start_rehash(size_type n)
+{
+    //表格成长得太快,上一轮还没搬完: 只好先一次搬完(调用resize()预留空间即可避免)
+    finish_rehash();
+    vector<node*, Alloc> tmp(n, (node*)0); //建立新的buckets
+    BucketPolicy new_policy;
+    new_policy.set_bucket_count(n);
+    old_buckets.swap(buckets); //目前的buckets成为旧buckets
+    buckets.swap(tmp);
+    old_policy = bucket_policy;
+    bucket_policy = new_policy;
+    migrate_pos = 0;
+}
+
+template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc, class BucketPolicy>
+inline void hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc, BucketPolicy>::
+    rehash_step(size_type k)
+{
+    const size_type old_n = old_buckets.size();
+    const size_type last = k < old_n - migrate_pos ? migrate_pos + k : old_n;
+    for (; migrate_pos < last; ++migrate_pos) {
+        //与resize()相同: 把旧bucket的节点逐一摘下,插入新bucket串行的头部
+        node* first = old_buckets[migrate_pos];
+        while (first) {
+            size_type new_bucket = bkt_num(first);
+            old_buckets[migrate_pos] = first->next;
+            first->next = buckets[new_bucket];
+            buckets[new_bucket] = first;
+            first = old_buckets[migrate_pos];
+        }
+    }
+    if (migrate_pos == old_n) { //这一轮结束,释放旧buckets
+        vector<node*, Alloc> tmp;
+        old_buckets.swap(tmp);
+        migrate_pos = 0;
+    }
+}
+
 #endif // SGI_STL_HASH_TABLE_H
 
 
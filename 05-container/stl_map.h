@@ -56,6 +56,8 @@ public:
     typedef typename rep_type::const_reverse_iterator const_reverse_iterator;
     typedef typename rep_type::size_type size_type;
     typedef typename rep_type::difference_type difference_type;
+    //节点把手,见rb_tree::node_type
+    typedef typename rep_type::node_type node_type;
 
     //allocation/deallocation
     /* 
@@ -115,12 +117,40 @@ public:
     iterator insert(iterator position, cosnt value_type& x) { return t.insert_unique(position, x); }
     template <class InputIterator>
     void insert(InputIterattor first, InputIterator last) { t.insert_unique(first, last); }
+    //快照还原等场合: map为空且[first, last)已依键值严格递增时,O(N)建树而不做任何比较.
+    //(区间插入会自行检查是否有序,此处连检查的N - 1次比较也省去)
+    template <class ForwardIterator>
+    void from_sorted(ForwardIterator first, ForwardIterator last) { t.from_sorted(first, last); }
 
     void erase(iterator position) { t.erase(position); }
     size_type erase(const key_type& x) { return t.erase(x); }
     void erase(iterator first, iterator last) { t.erase(first, last); }
+    //删除键值落在[a, b)的元素(如依时间排序的逾期项目),O(log N + k),见rb_tree::erase_range()
+    size_type erase_range(const key_type& a, const key_type& b) { return t.erase_range(a, b); }
+    //删除pred(元素)为真的全部元素,连续一段要删除者一次切下,见rb_tree::erase_if()
+    template <class Predicate>
+    size_type erase_if(Predicate pred) { return t.erase_if(pred); }
     void clear() { t.clear(); }
 
+    //节点的摘下与插回: 不配置记忆体、不复制元素.
+    //可以把元素在两个map之间搬移,或摘下后修改键值(nh.key())再插回
+    node_type extract(iterator position) { return t.extract(position); }
+    node_type extract(const key_type& x) { return t.extract(x); }
+    //键值重复时不插入,节点仍留在nh中
+    pair<iterator, bool> insert(node_type& nh) { return t.insert_unique(nh); }
+    //把x的节点逐一搬入,键值重复者留在x中
+    void merge(map<Key, T, Compare, Alloc>& x) { t.merge_unique(x.t); }
+
+    //整体集合运算: x的节点直接搬入或释放(不配置、不复制),结束后x为空.
+    //O(m log(n/m + 1)),threads不为1时平行执行(0为全部硬件线程),见rb_tree::union_with()
+    void union_with(map<Key, T, Compare, Alloc>& x, size_type threads = 1) { t.union_with(x.t, threads); }
+    void intersect_with(map<Key, T, Compare, Alloc>& x, size_type threads = 1) { t.intersect_with(x.t, threads); }
+    void difference_with(map<Key, T, Compare, Alloc>& x, size_type threads = 1) { t.difference_with(x.t, threads); }
+    //键值不小于k的元素移到空的right中,O(log N + min(|l|, |r|)),较小一侧须逐一计数;
+    //把键值都较大的right整个接到后面,O(log N)
+    void split(const key_type& k, map<Key, T, Compare, Alloc>& right) { t.split(k, right.t); }
+    void join(map<Key, T, Compare, Alloc>& right) { t.join(right.t); }
+
     //map operations
     iterator find(cosnt key_type& x) { return t.find(x); }
     const_iterator find(cosnt key_type& x) const { return t.find(x); }
@@ -131,6 +161,35 @@ public:
     const_iterator upper_bound(const key_type& x) const { return t.upper_bound(x); }
     pair<iterator, iterator> equal_range(const key_type& x) { return t.equal_range(x); } 
     pair<iterator, iterator> equal_range(const key_type& x) const { return t.equal_range(x); }
+    //异质查找: 仅当Compare透明(如less<void>)时开放,
+    //例如map<string, int, less<void> >可用const char*直接查找,不必构造临时string
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    find(const K& x) { return t.find(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, const_iterator>::type
+    find(const K& x) const { return t.find(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, size_type>::type
+    count(const K& x) const { return t.count(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    lower_bound(const K& x) { return t.lower_bound(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, const_iterator>::type
+    lower_bound(const K& x) const { return t.lower_bound(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    upper_bound(const K& x) { return t.upper_bound(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, const_iterator>::type
+    upper_bound(const K& x) const { return t.upper_bound(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, pair<iterator, iterator> >::type
+    equal_range(const K& x) { return t.equal_range(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, pair<const_iterator, const_iterator> >::type
+    equal_range(const K& x) const { return t.equal_range(x); }
 
     friend bool operator== <> (const map&, const map&);
     friend bool operator<  <> (const map&, const map&);
@@ -36,6 +36,9 @@ public:
     }
     template <class InputIterator>
     void insert(InputIterator first, InputIterator last) { t.insert_equal(first, last); }
+    // 节点把手一定插入成功. extract()与set相同
+    iterator insert(node_type& nh) { return t.insert_equal(nh); }
+    void merge(multiset<Key, Compare, Alloc>& x) { t.merge_equal(x.t); }
     // ...其他与set相同
 };
 
@@ -0,0 +1,258 @@
+#ifndef SGI_STL_OS_MAP_H
+#define SGI_STL_OS_MAP_H
+
+#include "02-allocator/stl_alloc.h"
+#include "07-functional/stl_function.h"
+#include "05-container/stl_tree.h"
+
+//os_map(order statistic map): 接口与map相同,另外提供O(log N)的select/rank/distance/count_range,
+//原理见<stl_os_set.h>与rb_tree的__rb_tree_size_augment
+
+template <class Key, class T, class Compare = less<Key>, class Alloc = alloc>
+class os_map;
+
+template <class Key, class T, class Compare, class Alloc>
+inline bool operator==(const os_map<Key, T, Compare, Alloc>& x,
+                       const os_map<Key, T, Compare, Alloc>& y);
+
+template <class Key, class T, class Compare, class Alloc>
+class os_map {
+public:
+    typedef Key key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef pair<const Key, T> value_type;
+    typedef Compare key_compare;
+
+    class value_compare : public binary_function<value_type, value_type, bool> {
+    friend class os_map<Key, T, Compare, Alloc>;
+    protected:
+        Compare comp;
+        value_compare(Compare c) : comp(c) {}
+    public:
+        bool operator()(const value_type& x, const value_type& y) const
+        {
+            return comp(x.first, y.first);
+        }
+    };
+private:
+    typedef rb_tree<key_type, value_type, select1st<value_type>, key_compare, Alloc,
+                    __rb_tree_size_augment> rep_type;
+    rep_type t;
+public:
+    typedef typename rep_type::pointer pointer;
+    typedef typename rep_type::const_pointer const_pointer;
+    typedef typename rep_type::reference reference;
+    typedef typename rep_type::const_reference const_reference;
+    typedef typename rep_type::iterator iterator;
+    typedef typename rep_type::const_iterator const_iterator;
+    typedef typename rep_type::size_type size_type;
+    typedef typename rep_type::difference_type difference_type;
+
+    os_map() : t(Compare()) {}
+    explicit os_map(const Compare& comp) : t(comp) {}
+    template <class InputIterator>
+    os_map(InputIterator first, InputIterator last) :
+        t(Compare()) { t.insert_unique(first, last); }
+    template <class InputIterator>
+    os_map(InputIterator first, InputIterator last, const Compare& comp) :
+        t(comp) { t.insert_unique(first, last); }
+
+    //accessors
+    key_compare key_comp() const { return t.key_comp(); }
+    value_compare value_comp() const { return value_compare(t.key_comp()); }
+    iterator begin() { return t.begin(); }
+    const_iterator begin() const { return t.begin(); }
+    iterator end() { return t.end(); }
+    const_iterator end() const { return t.end(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    size_type max_size() const { return t.max_size(); }
+    T& operator[](const key_type& k) {
+        return (*((insert(value_type(k, T()))).first)).second;
+    }
+
+    //insert/erase
+    pair<iterator, bool> insert(const value_type& x) { return t.insert_unique(x); }
+    iterator insert(iterator position, const value_type& x) { return t.insert_unique(position, x); }
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last) { t.insert_unique(first, last); }
+    void erase(iterator position) { t.erase(position); }
+    size_type erase(const key_type& x) { return t.erase(x); }
+    void erase(iterator first, iterator last) { t.erase(first, last); }
+    //删除键值落在[a, b)的元素(如依时间排序的逾期项目),O(log N + k),见rb_tree::erase_range()
+    size_type erase_range(const key_type& a, const key_type& b) { return t.erase_range(a, b); }
+    //删除pred(元素)为真的全部元素,连续一段要删除者一次切下,见rb_tree::erase_if()
+    template <class Predicate>
+    size_type erase_if(Predicate pred) { return t.erase_if(pred); }
+    void clear() { t.clear(); }
+
+    //map operations
+    iterator find(const key_type& x) { return t.find(x); }
+    const_iterator find(const key_type& x) const { return t.find(x); }
+    size_type count(const key_type& x) const { return t.count(x); }
+    iterator lower_bound(const key_type& x) { return t.lower_bound(x); }
+    const_iterator lower_bound(const key_type& x) const { return t.lower_bound(x); }
+    iterator upper_bound(const key_type& x) { return t.upper_bound(x); }
+    const_iterator upper_bound(const key_type& x) const { return t.upper_bound(x); }
+    pair<iterator, iterator> equal_range(const key_type& x) { return t.equal_range(x); }
+    pair<const_iterator, const_iterator> equal_range(const key_type& x) const { return t.equal_range(x); }
+
+    //order statistics, 皆为O(log N)
+    //键值第k小(由0起算)的元素;k >= size()时返回end()
+    iterator select(size_type k) { return t.select(k); }
+    const_iterator select(size_type k) const { return t.select(k); }
+    //键值小于x的元素个数
+    size_type rank(const key_type& x) const { return t.rank(x); }
+    //position之前的元素个数
+    size_type index(const_iterator position) const { return t.index(position); }
+    //等同于distance(first, last),但不必逐一走过
+    difference_type distance(const_iterator first, const_iterator last) const
+    {
+        return t.distance(first, last);
+    }
+    //键值落在[a, b)的元素个数
+    size_type count_range(const key_type& a, const key_type& b) const { return t.count_range(a, b); }
+
+    friend bool operator== __STL_NULL_TMPL_ARGS (const os_map&, const os_map&);
+};
+
+template <class Key, class T, class Compare, class Alloc>
+inline bool operator==(const os_map<Key, T, Compare, Alloc>& x,
+                       const os_map<Key, T, Compare, Alloc>& y)
+{
+    return x.size() == y.size() && equal(x.begin(), x.end(), y.begin());
+}
+
+#endif // SGI_STL_OS_MAP_H
+
+
+/*
+ * ========= BENCHMARK DEMO ============
+ * 排行榜: 键值为(-score, id),查询"某玩家的名次"与"第k名是谁".
+ * map只能由begin()逐一走过去,os_map由根往下O(log N)
+
+#include <map>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+typedef pair<long, long> entry; //(-score, id)
+
+int main()
+{
+    const long n = 1000000, queries = 2000;
+    map<entry, long> m;
+    os_map<entry, long> om;
+    vector<entry> keys;
+    for (long i = 0; i < n; ++i) {
+        entry e(-(rand() % 100000000), i);
+        keys.push_back(e);
+        m[e] = i;
+        om[e] = i;
+    }
+
+    long sum = 0;
+    clock_t t0 = clock();
+    for (long q = 0; q < queries; ++q) { //名次
+        const entry& e = keys[(q * 7919) % n];
+        long r = 0;
+        for (map<entry, long>::iterator it = m.begin(); it->first < e; ++it)
+            ++r;
+        sum += r;
+    }
+    clock_t t1 = clock();
+    for (long q = 0; q < queries; ++q)
+        sum -= om.rank(keys[(q * 7919) % n]);
+    clock_t t2 = clock();
+    printf("rank    map %10.2f us/op  os_map %6.3f us/op\n",
+           1e6 * double(t1 - t0) / CLOCKS_PER_SEC / queries,
+           1e6 * double(t2 - t1) / CLOCKS_PER_SEC / queries);
+
+    t0 = clock();
+    for (long q = 0; q < queries; ++q) { //第k名
+        map<entry, long>::iterator it = m.begin();
+        for (long k = (q * 7919) % n; k > 0; --k)
+            ++it;
+        sum += it->second;
+    }
+    t1 = clock();
+    for (long q = 0; q < queries; ++q)
+        sum -= om.select((q * 7919) % n)->second;
+    t2 = clock();
+    printf("select  map %10.2f us/op  os_map %6.3f us/op\n",
+           1e6 * double(t1 - t0) / CLOCKS_PER_SEC / queries,
+           1e6 * double(t2 - t1) / CLOCKS_PER_SEC / queries);
+
+    //维护子树大小的代价: 插入/删除各多一趟O(log N)的路径走访
+    t0 = clock();
+    for (long i = 0; i < n; ++i)
+        m.erase(keys[i]);
+    t1 = clock();
+    for (long i = 0; i < n; ++i)
+        om.erase(keys[i]);
+    t2 = clock();
+    printf("erase   map %10.2f Mops/s os_map %6.2f Mops/s\n",
+           n / (double(t1 - t0) / CLOCKS_PER_SEC) / 1e6, n / (double(t2 - t1) / CLOCKS_PER_SEC) / 1e6);
+    printf("(%ld)\n", sum); //两种做法结果相同,应为0
+}
+
+ */
+
+
+/*
+ * ========= BENCHMARK DEMO ============
+ * 逾期清除(TTL): 键值为到期时间,每个tick删除所有已到期者,并统计某段时间内将到期的个数.
+ * 逐一erase时每删一个都要rebalance并沿路径修正子树大小;erase_range以两次split切下整段
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+typedef os_map<unsigned long, int> ttl_map;
+
+static double ms(clock_t t0, clock_t t1) { return 1e3 * double(t1 - t0) / CLOCKS_PER_SEC; }
+
+int main()
+{
+    const unsigned long n = 1000000, ticks = 100, step = n * 16 / ticks;
+    ttl_map a, b;
+    for (unsigned long i = 0; i < n; ++i) {
+        unsigned long expire = i * 16 + rand() % 16;
+        a[expire] = 0;
+        b[expire] = 0;
+    }
+
+    clock_t t0 = clock();
+    for (unsigned long now = step; now <= n * 8; now += step) { //逐一删除
+        ttl_map::iterator last = a.lower_bound(now);
+        while (a.begin() != last)
+            a.erase(a.begin());
+    }
+    clock_t t1 = clock();
+    for (unsigned long now = step; now <= n * 8; now += step)
+        b.erase_range(0, now);
+    clock_t t2 = clock();
+    printf("sweep   erase %8.2f ms/tick  erase_range %8.2f ms/tick\n",
+           ms(t0, t1) / (ticks / 2), ms(t1, t2) / (ticks / 2));
+
+    const int queries = 200;
+    long sum = 0;
+    t0 = clock();
+    for (int q = 0; q < queries; ++q) { //[now, now + window)内将到期的个数
+        unsigned long now = n * 8 + q * 7919, window = n * 2;
+        for (ttl_map::iterator i = a.lower_bound(now); i != a.end() && i->first < now + window; ++i)
+            ++sum;
+    }
+    t1 = clock();
+    for (int q = 0; q < queries; ++q) {
+        unsigned long now = n * 8 + q * 7919, window = n * 2;
+        sum -= b.count_range(now, now + window);
+    }
+    t2 = clock();
+    printf("count   walk  %8.2f us/op    count_range %8.3f us/op\n",
+           1e3 * ms(t0, t1) / queries, 1e3 * ms(t1, t2) / queries);
+    printf("(%ld)\n", sum); //两种做法结果相同,应为0
+}
+
+ */
@@ -0,0 +1,136 @@
+#ifndef SGI_STL_OS_SET_H
+#define SGI_STL_OS_SET_H
+
+#include "02-allocator/stl_alloc.h"
+#include "07-functional/stl_function.h"
+#include "05-container/stl_tree.h"
+
+//os_set(order statistic set): 接口与set相同,另外能在O(log N)内回答
+//"第k小的元素是谁"(select)与"比x小的元素有几个"(rank).
+//底层是以__rb_tree_size_augment增强的RB-tree,每个节点多记录一个子树大小,
+//插入/删除时沿路径与旋转处顺便维护,复杂度与set相同
+
+template <class Key, class Compare = less<Key>, class Alloc = alloc>
+class os_set;
+
+template <class Key, class Compare, class Alloc>
+inline bool operator==(const os_set<Key, Compare, Alloc>& x,
+                       const os_set<Key, Compare, Alloc>& y);
+
+template <class Key, class Compare, class Alloc>
+class os_set {
+public:
+    typedef Key key_type;
+    typedef Key value_type;
+    typedef Compare key_compare;
+    typedef Compare value_compare;
+private:
+    typedef rb_tree<key_type, value_type, identity<value_type>, key_compare, Alloc,
+                    __rb_tree_size_augment> rep_type;
+    rep_type t;
+public:
+    typedef typename rep_type::const_pointer pointer;
+    typedef typename rep_type::const_pointer const_pointer;
+    typedef typename rep_type::const_reference reference;
+    typedef typename rep_type::const_reference const_reference;
+    //与set相同,迭代器不允许写入元素
+    typedef typename rep_type::const_iterator iterator;
+    typedef typename rep_type::const_iterator const_iterator;
+    typedef typename rep_type::size_type size_type;
+    typedef typename rep_type::difference_type difference_type;
+
+    os_set() : t(Compare()) {}
+    explicit os_set(const Compare& comp) : t(comp) {}
+    template <class InputIterator>
+    os_set(InputIterator first, InputIterator last) :
+        t(Compare()) { t.insert_unique(first, last); }
+    template <class InputIterator>
+    os_set(InputIterator first, InputIterator last, const Compare& comp) :
+        t(comp) { t.insert_unique(first, last); }
+
+    //accessors
+    key_compare key_comp() const { return t.key_comp(); }
+    value_compare value_comp() const { return t.key_comp(); }
+    iterator begin() const { return t.begin(); }
+    iterator end() const { return t.end(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    size_type max_size() const { return t.max_size(); }
+
+    //insert/erase
+    pair<iterator, bool> insert(const value_type& x)
+    {
+        pair<typename rep_type::iterator, bool> p = t.insert_unique(x);
+        return pair<iterator, bool>(p.first, p.second);
+    }
+    iterator insert(iterator position, const value_type& x)
+    {
+        typedef typename rep_type::iterator rep_iterator;
+        return t.insert_unique((rep_iterator&)position, x);
+    }
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last) { t.insert_unique(first, last); }
+    void erase(iterator position)
+    {
+        typedef typename rep_type::iterator rep_iterator;
+        t.erase((rep_iterator&)position);
+    }
+    size_type erase(const key_type& x) { return t.erase(x); }
+    void erase(iterator first, iterator last)
+    {
+        typedef typename rep_type::iterator rep_iterator;
+        t.erase((rep_iterator&)first, (rep_iterator&)last);
+    }
+    //删除键值落在[a, b)的元素(如依时间排序的逾期项目),O(log N + k),见rb_tree::erase_range()
+    size_type erase_range(const key_type& a, const key_type& b) { return t.erase_range(a, b); }
+    //删除pred(元素)为真的全部元素,连续一段要删除者一次切下,见rb_tree::erase_if()
+    template <class Predicate>
+    size_type erase_if(Predicate pred) { return t.erase_if(pred); }
+    void clear() { t.clear(); }
+
+    //set operations
+    iterator find(const key_type& x) const { return t.find(x); }
+    size_type count(const key_type& x) const { return t.count(x); }
+    iterator lower_bound(const key_type& x) const { return t.lower_bound(x); }
+    iterator upper_bound(const key_type& x) const { return t.upper_bound(x); }
+    pair<iterator, iterator> equal_range(const key_type& x) const { return t.equal_range(x); }
+
+    //order statistics, 皆为O(log N)
+    //第k小(由0起算)的元素;k >= size()时返回end()
+    iterator select(size_type k) const { return t.select(k); }
+    //小于x的元素个数;x在set中时即其名次
+    size_type rank(const key_type& x) const { return t.rank(x); }
+    //position之前的元素个数
+    size_type index(iterator position) const { return t.index(position); }
+    //等同于distance(first, last),但不必逐一走过
+    difference_type distance(iterator first, iterator last) const { return t.distance(first, last); }
+    //键值落在[a, b)的元素个数
+    size_type count_range(const key_type& a, const key_type& b) const { return t.count_range(a, b); }
+
+    friend bool operator== __STL_NULL_TMPL_ARGS (const os_set&, const os_set&);
+};
+
+template <class Key, class Compare, class Alloc>
+inline bool operator==(const os_set<Key, Compare, Alloc>& x,
+                       const os_set<Key, Compare, Alloc>& y)
+{
+    return x.size() == y.size() && equal(x.begin(), x.end(), y.begin());
+}
+
+#endif // SGI_STL_OS_SET_H
+
+
+/*
+ * ========= TEST DEMO ============
+ * 百分位数: 以select()取第p百分位的元素,以rank()求某个值落在第几百分位
+
+os_set<int> s;
+for (int i = 0; i < 1000; ++i)
+    s.insert(i * 3);
+std::cout << *s.select(0) << ' ' << *s.select(499) << ' ' << *s.select(999) << std::endl; //0 1497 2997
+std::cout << s.rank(1500) << ' ' << s.rank(1501) << std::endl; //500 501
+std::cout << s.distance(s.lower_bound(300), s.lower_bound(600)) << std::endl; //100
+s.erase(s.select(0));
+std::cout << *s.select(0) << ' ' << s.index(s.find(3)) << std::endl; //3 0
+
+ */
@@ -0,0 +1,161 @@
+#ifndef SGI_STL_PERSISTENT_MAP_H
+#define SGI_STL_PERSISTENT_MAP_H
+
+#include "02-allocator/stl_alloc.h"
+#include "07-functional/stl_function.h"
+#include "05-container/stl_persistent_tree.h"
+
+/*
+ * persistent_map: 不可变(immutable)、结构共享的map,原理见<stl_persistent_tree.h>
+ *
+ * 复制是O(1)(只共享根节点),每次insert/erase只产生O(log N)个新节点,其余与旧版本共享.
+ * 适合"多线程频繁读取、偶尔更新"的表格(设定、路由表等): 以persistent_cell发布目前版本,
+ * 读者取得快照后不必加锁,写者也不必像map那样先整个复制一份再修改.
+ *
+ * 与map的接口差异: 迭代器是只读的forward iterator;insert/erase不返回迭代器;
+ * 没有operator[](修改元素要产生新节点),改以insert_or_assign()取代.
+ */
+
+template <class Key, class T, class Compare = less<Key>, class Alloc = malloc_alloc>
+class persistent_map {
+public:
+    typedef Key key_type;
+    typedef T data_type;
+    typedef T mapped_type;
+    typedef pair<const Key, T> value_type;
+    typedef Compare key_compare;
+private:
+    typedef persistent_tree<key_type, value_type, select1st<value_type>, key_compare, Alloc> rep_type;
+    rep_type t;
+public:
+    typedef typename rep_type::const_pointer pointer;
+    typedef typename rep_type::const_pointer const_pointer;
+    typedef typename rep_type::const_reference reference;
+    typedef typename rep_type::const_reference const_reference;
+    //元素可能与其他版本共享,迭代器不允许写入
+    typedef typename rep_type::const_iterator iterator;
+    typedef typename rep_type::const_iterator const_iterator;
+    typedef typename rep_type::size_type size_type;
+    typedef typename rep_type::difference_type difference_type;
+
+    persistent_map() : t(Compare()) {}
+    explicit persistent_map(const Compare& comp) : t(comp) {}
+    template <class InputIterator>
+    persistent_map(InputIterator first, InputIterator last) : t(Compare()) { insert(first, last); }
+    template <class InputIterator>
+    persistent_map(InputIterator first, InputIterator last, const Compare& comp) : t(comp) { insert(first, last); }
+
+    //accessors
+    key_compare key_comp() const { return t.key_comp(); }
+    const_iterator begin() const { return t.begin(); }
+    const_iterator end() const { return t.end(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    size_type max_size() const { return t.max_size(); }
+    void swap(persistent_map& x) { t.swap(x.t); }
+    //两者是否为同一个版本,见persistent_cell::compare_and_publish()
+    bool identical(const persistent_map& x) const { return t.identical(x.t); }
+
+    //insert/erase: 只影响*this,其他版本(快照)不变
+    //键值不存在时插入x,返回是否插入
+    bool insert(const value_type& x) { return t.insert_unique(x); }
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        for (; first != last; ++first)
+            t.insert_unique(*first);
+    }
+    //键值不存在时插入(k, v),已存在时以v取代旧值;返回是否为新插入
+    bool insert_or_assign(const key_type& k, const data_type& v) { return t.assign_unique(value_type(k, v)); }
+    size_type erase(const key_type& x) { return t.erase(x); }
+    void clear() { t.clear(); }
+
+    //map operations
+    const_iterator find(const key_type& x) const { return t.find(x); }
+    size_type count(const key_type& x) const { return t.count(x); }
+    const_iterator lower_bound(const key_type& x) const { return t.lower_bound(x); }
+    const_iterator upper_bound(const key_type& x) const { return t.upper_bound(x); }
+    pair<const_iterator, const_iterator> equal_range(const key_type& x) const { return t.equal_range(x); }
+};
+
+template <class Key, class T, class Compare, class Alloc>
+inline bool operator==(const persistent_map<Key, T, Compare, Alloc>& x,
+                       const persistent_map<Key, T, Compare, Alloc>& y)
+{
+    return x.identical(y) || (x.size() == y.size() && equal(x.begin(), x.end(), y.begin()));
+}
+
+#endif // SGI_STL_PERSISTENT_MAP_H
+
+
+/*
+ * ========= BENCHMARK DEMO ============
+ * 路由表: 一个写者每秒更新若干次,多个读者不断查找.
+ * 原本的做法是复制整个map(rb_tree::__copy)、修改、在锁内换上新指针,每次更新O(N);
+ * persistent_map每次更新O(log N)个新节点,读者取快照只是参考计数加一
+
+#include <map>
+#include <cstdio>
+#include <pthread.h>
+#include <sys/time.h>
+
+static double now()
+{
+    timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+typedef persistent_map<unsigned, unsigned> route_table;
+static persistent_cell<route_table> cell;
+static volatile int stop = 0;
+static const unsigned n = 1000000;
+
+void* reader(void* p)
+{
+    unsigned long hits = 0, k = (unsigned long)p;
+    while (!stop) {
+        route_table snap = cell.snapshot(); //之后的查找都不加锁
+        for (int i = 0; i < 1000; ++i, k = k * 1103515245 + 12345)
+            hits += snap.count(unsigned(k % (2 * n)));
+    }
+    return (void*)hits;
+}
+
+int main()
+{
+    std::map<unsigned, unsigned> m;
+    route_table pm;
+    for (unsigned i = 0; i < n; ++i) {
+        m[2 * i] = i;
+        pm.insert_or_assign(2 * i, i);
+    }
+    cell.publish(pm);
+
+    const int updates = 50;
+    double t0 = now();
+    for (int i = 0; i < updates; ++i) { //复制整个map再修改
+        std::map<unsigned, unsigned> copy(m);
+        copy[2 * i + 1] = i;
+        m.swap(copy);
+    }
+    double t1 = now();
+    printf("copy map + update      %10.2f us/update\n", (t1 - t0) * 1e6 / updates);
+
+    pthread_t tid[4];
+    for (long i = 0; i < 4; ++i)
+        pthread_create(&tid[i], 0, reader, (void*)i);
+    t0 = now();
+    for (int i = 0; i < 100000; ++i) { //读者同时在查找
+        route_table next = cell.snapshot();
+        next.insert_or_assign(unsigned(i % (2 * n)) | 1, i);
+        cell.publish(next);
+    }
+    t1 = now();
+    stop = 1;
+    for (int i = 0; i < 4; ++i)
+        pthread_join(tid[i], 0);
+    printf("persistent_map update  %10.2f us/update (4 readers running)\n", (t1 - t0) * 1e6 / 100000);
+}
+
+ */
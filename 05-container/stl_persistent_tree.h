@@ -0,0 +1,642 @@
+#ifndef SGI_STL_PERSISTENT_TREE_H
+#define SGI_STL_PERSISTENT_TREE_H
+
+#include <stddef.h>
+#include "01-config/stl_config.h"
+#include "01-config/stl_threads.h"
+#include "02-allocator/stl_alloc.h"
+#include "02-allocator/stl_construct.h"
+#include "03-iterator/stl_iterator.h"
+#include "05-container/stl_pair.h"
+
+/*
+ * persistent_tree: 持久化(persistent)的红黑树,persistent_map的底层机制
+ *
+ * "持久化"是指修改不会破坏旧版本: 每次insert/erase都产生一棵新树,旧树原封不动,
+ * 两者共享所有没有改变的子树. 做法是路径复制(path copying): 只复制从根部到修改处
+ * 这一路上的节点(以及rebalance碰到的节点),共O(log N)个,其余节点直接共享.
+ *
+ * 节点一经共享就不再修改,所以需要以参考计数(reference count)决定何时释放:
+ * refs是指向此节点的父节点与树根的个数,以原子操作增减,降为0的线程负责释放.
+ * 因此一份树(的根)可以在O(1)内复制成快照,交给其他线程读取而完全不必加锁,
+ * 即使写者同时在自己的版本上修改.
+ *
+ * 节点没有parent指针(同一个节点可能同时是好几棵树中不同节点的子节点),
+ * 所以rb_tree那种由下往上的rebalance无法使用. 这里改以join为基本操作(与rb_tree::union_with()相同):
+ *   insert(v): 依v的键值把树split成L与R,再join(L, v, R)
+ *   erase(k):  依k split成L与R(丢弃等于k的节点),再join2(L, R)
+ * split与join都是O(log N),而且只产生O(log N)个新节点.
+ * 操作进行中的新节点只属于这次操作(refs为1),可以直接修改,不必再复制.
+ *
+ * 迭代器没有parent指针可走,所以自带一个堆栈,记录尚未走访的祖先.
+ * 只提供const迭代器: 元素可能与其他版本共享,不能就地修改.
+ * 修改*this会使它的迭代器失效(被换下的节点可能随即释放);要一边走访一边修改,先复制一份快照来走访.
+ *
+ * 多线程: 同一个persistent_tree物件不可同时被多个线程使用(与一般容器相同);
+ * 不同的物件(例如各线程自己的快照)即使共享节点,也可以同时读写.
+ * 节点可能由任何一个线程释放,所以缺省使用malloc_alloc(alloc的free lists并未加锁).
+ */
+
+template <class Value>
+struct __persistent_tree_node {
+    typedef __persistent_tree_node* link_type;
+
+    link_type left;
+    link_type right;
+    volatile size_t refs; //指向此节点的父节点与树根的个数
+    bool red;
+    Value value_field;
+};
+
+//中序迭代器. path[0, depth)是由根部往下、键值不小于目前元素而尚未走访的节点,
+//path[depth - 1]即目前所指的节点;depth为0表示end()
+template <class Value, class Node>
+struct __persistent_tree_iterator {
+    typedef __persistent_tree_iterator<Value, Node> self;
+
+    typedef forward_iterator_tag iterator_category;
+    typedef Value value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const Value& reference;
+    typedef const Value* pointer;
+
+    //红黑树的高度不超过2log(N + 1)
+    enum { max_depth = 2 * 8 * sizeof(size_t) };
+
+    const Node* path[max_depth];
+    int depth;
+
+    __persistent_tree_iterator() : depth(0) {}
+    __persistent_tree_iterator(const self& x) : depth(x.depth)
+    {
+        for (int i = 0; i < depth; ++i) //只复制用到的部分
+            path[i] = x.path[i];
+    }
+    self& operator=(const self& x)
+    {
+        depth = x.depth;
+        for (int i = 0; i < depth; ++i)
+            path[i] = x.path[i];
+        return *this;
+    }
+
+    reference operator*() const { return path[depth - 1]->value_field; }
+    pointer operator->() const { return &(operator*()); }
+
+    //有右子树就走到右子树的最左节点,否则回到堆栈中的下一个祖先
+    self& operator++()
+    {
+        const Node* x = path[--depth]->right;
+        push_left(x);
+        return *this;
+    }
+    self operator++(int) { self tmp = *this; ++*this; return tmp; }
+    bool operator==(const self& x) const
+    {
+        return depth == x.depth && (depth == 0 || path[depth - 1] == x.path[depth - 1]);
+    }
+    bool operator!=(const self& x) const { return !(*this == x); }
+
+    void push_left(const Node* x)
+    {
+        for (; x; x = x->left)
+            path[depth++] = x;
+    }
+};
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc = malloc_alloc>
+class persistent_tree {
+public:
+    typedef Key key_type;
+    typedef Value value_type;
+    typedef const value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef const value_type& reference;
+    typedef const value_type& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+protected:
+    typedef __persistent_tree_node<Value> node;
+    typedef node* link_type;
+    typedef simple_alloc<node, Alloc> node_allocator;
+public:
+    typedef __persistent_tree_iterator<Value, node> const_iterator;
+    typedef const_iterator iterator;
+protected:
+    link_type root;
+    size_type node_count;
+    size_type black_height; //由根部到任一空节点路上的黑色节点数(含根)
+    Compare key_compare;
+public:
+    persistent_tree(const Compare& comp = Compare())
+        : root(0), node_count(0), black_height(0), key_compare(comp) {}
+    //复制只是共享同一个根节点: O(1),之后两者各自修改互不影响
+    persistent_tree(const persistent_tree& x)
+        : root(ref(x.root)), node_count(x.node_count), black_height(x.black_height),
+          key_compare(x.key_compare) {}
+    persistent_tree& operator=(const persistent_tree& x)
+    {
+        persistent_tree tmp(x);
+        swap(tmp);
+        return *this;
+    }
+    ~persistent_tree() { release(root); }
+
+    Compare key_comp() const { return key_compare; }
+    const_iterator begin() const
+    {
+        const_iterator it;
+        it.push_left(root);
+        return it;
+    }
+    const_iterator end() const { return const_iterator(); }
+    bool empty() const { return node_count == 0; }
+    size_type size() const { return node_count; }
+    size_type max_size() const { return size_type(-1); }
+    //两者是否为同一个版本(共享同一个根节点),判断快照是否已经过时只需O(1)
+    bool identical(const persistent_tree& x) const { return root == x.root && node_count == x.node_count; }
+
+    void swap(persistent_tree& t)
+    {
+        __STD::swap(root, t.root);
+        __STD::swap(node_count, t.node_count);
+        __STD::swap(black_height, t.black_height);
+        __STD::swap(key_compare, t.key_compare);
+    }
+
+    //以下修改都只影响*this,与它共享节点的其他版本不变.
+    //元素的复制或键值比较抛出异常时*this不变
+    bool insert_unique(const value_type& v);
+    //键值已存在时以v取代旧元素;返回是否为新插入
+    bool assign_unique(const value_type& v);
+    size_type erase(const key_type& k);
+    void clear()
+    {
+        release(root);
+        root = 0;
+        node_count = 0;
+        black_height = 0;
+    }
+
+    //查找操作. 都只是读取,可以与其他版本的修改同时进行
+    const_iterator find(const key_type& k) const
+    {
+        const_iterator it = lower_bound(k);
+        return (it == end() || key_compare(k, KeyOfValue()(*it))) ? end() : it;
+    }
+    size_type count(const key_type& k) const { return find(k) == end() ? 0 : 1; }
+    const_iterator lower_bound(const key_type& k) const
+    {
+        const_iterator it;
+        for (link_type x = root; x; )
+            if (!key_compare(key(x), k)) { //x不小于k,记下它再往左找
+                it.path[it.depth++] = x;
+                x = x->left;
+            }
+            else
+                x = x->right;
+        return it;
+    }
+    const_iterator upper_bound(const key_type& k) const
+    {
+        const_iterator it;
+        for (link_type x = root; x; )
+            if (key_compare(k, key(x))) {
+                it.path[it.depth++] = x;
+                x = x->left;
+            }
+            else
+                x = x->right;
+        return it;
+    }
+    pair<const_iterator, const_iterator> equal_range(const key_type& k) const
+    {
+        return pair<const_iterator, const_iterator>(lower_bound(k), upper_bound(k));
+    }
+
+protected:
+    static const Key& key(link_type x) { return KeyOfValue()(x->value_field); }
+    static bool is_red(link_type x) { return x && x->red; }
+
+    static link_type create_node(const value_type& v)
+    {
+        link_type tmp = node_allocator::allocate();
+        __STL_TRY {
+            construct(&tmp->value_field, v);
+        }
+        __STL_UNWIND(node_allocator::deallocate(tmp));
+        tmp->left = tmp->right = 0;
+        tmp->refs = 1;
+        tmp->red = true;
+        return tmp;
+    }
+    static void destroy_node(link_type x)
+    {
+        destory(&x->value_field);
+        node_allocator::deallocate(x);
+    }
+    static link_type ref(link_type x)
+    {
+        if (x)
+            __stl_atomic_add(&x->refs, size_t(1));
+        return x;
+    }
+    //放弃一个参考,降为0就释放节点并放弃它对子节点的参考. 只递归左子树,右子树以循环处理
+    static void release(link_type x)
+    {
+        while (x && __stl_atomic_add(&x->refs, size_t(-1)) == 0) {
+            link_type r = x->right;
+            release(x->left);
+            destroy_node(x);
+            x = r;
+        }
+    }
+
+    /*
+     * 以下函数的参数与返回值都是"拥有的参考": 调用者交出参数的参考,取得返回值的参考.
+     * 抛出异常时,函数负责放弃所有交给它的参考,所以调用者手上不会残留孤立的节点.
+     * h开头的参数是对应子树的黑高度.
+     */
+
+    //取得x的一个可以修改的版本,其左右子树交给l与r,新节点的left/right为0.
+    //只有这次操作自己产生的节点refs为1,可以直接拿来用;其他都与旧版本共享,必须复制.
+    //复制失败时x仍归调用者
+    static link_type expose(link_type x, link_type& l, link_type& r)
+    {
+        if (__stl_atomic_load(&x->refs) == 1) {
+            l = x->left;
+            r = x->right;
+        } else {
+            link_type tmp = create_node(x->value_field);
+            tmp->red = x->red;
+            l = ref(x->left);
+            r = ref(x->right);
+            release(x);
+            x = tmp;
+        }
+        x->left = x->right = 0;
+        return x;
+    }
+    //使*link所指节点成为黑色(共享者先复制). 失败时*link不变
+    static void blacken(link_type* link)
+    {
+        link_type x = *link;
+        if (!x->red)
+            return;
+        if (__stl_atomic_load(&x->refs) != 1) {
+            link_type tmp = create_node(x->value_field);
+            tmp->left = ref(x->left);
+            tmp->right = ref(x->right);
+            release(x);
+            *link = x = tmp;
+        }
+        x->red = false;
+    }
+    static link_type rotate_left(link_type x)
+    {
+        link_type y = x->right;
+        x->right = y->left;
+        y->left = x;
+        return y;
+    }
+    static link_type rotate_right(link_type x)
+    {
+        link_type y = x->left;
+        x->left = y->right;
+        y->right = x;
+        return y;
+    }
+
+    static link_type join_right(link_type l, size_type hl, link_type m, link_type r, size_type hr);
+    static link_type join_left(link_type l, size_type hl, link_type m, link_type r, size_type hr);
+    //m是可以修改的单一节点: 以m为分界把l(键值皆小于m)与r(皆大于m)接成一棵树,h为其黑高度
+    static link_type join(link_type l, size_type hl, link_type m, link_type r, size_type hr,
+                          size_type& h);
+    //摘下x的最大节点,其余部分交给l
+    static link_type split_last(link_type x, size_type hx, link_type& l, size_type& hl);
+    //接上键值皆小于r的l
+    static link_type join2(link_type l, size_type hl, link_type r, size_type hr, size_type& h);
+    //依k把x分成l(键值小于k)与r(大于k),返回键值等于k的节点(仍为原来的节点,只交出参考),没有则为0
+    link_type split(link_type x, size_type hx, const key_type& k,
+                    link_type& l, size_type& hl, link_type& r, size_type& hr) const;
+};
+
+//hl > hr(或l为红色而两者黑高度相同): 沿l的右侧往下,找到黑高度为hr的黑色节点,由m接上r
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::link_type
+persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::
+    join_right(link_type l, size_type hl, link_type m, link_type r, size_type hr)
+{
+    if (!is_red(l) && hl == hr) {
+        m->left = l;
+        m->right = r;
+        m->red = true;
+        return m;
+    }
+    link_type a, b, t;
+    __STL_TRY {
+        t = expose(l, a, b);
+    }
+    __STL_UNWIND((release(l), destroy_node(m), release(r)));
+    __STL_TRY {
+        b = join_right(b, t->red ? hl : hl - 1, m, r, hr);
+    }
+    __STL_UNWIND((release(a), destroy_node(t)));
+    t->left = a;
+    t->right = b;
+    //接上之后若出现连续两个红色节点,且上面还有一个黑色节点: 染黑最下面的红色节点再左旋
+    if (!t->red && b->red && is_red(b->right)) {
+        __STL_TRY {
+            blacken(&b->right);
+        }
+        __STL_UNWIND(release(t));
+        return rotate_left(t);
+    }
+    return t;
+}
+
+//与join_right()对称
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::link_type
+persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::
+    join_left(link_type l, size_type hl, link_type m, link_type r, size_type hr)
+{
+    if (!is_red(r) && hl == hr) {
+        m->left = l;
+        m->right = r;
+        m->red = true;
+        return m;
+    }
+    link_type a, b, t;
+    __STL_TRY {
+        t = expose(r, a, b);
+    }
+    __STL_UNWIND((release(l), destroy_node(m), release(r)));
+    __STL_TRY {
+        a = join_left(l, hl, m, a, t->red ? hr : hr - 1);
+    }
+    __STL_UNWIND((release(b), destroy_node(t)));
+    t->left = a;
+    t->right = b;
+    if (!t->red && a->red && is_red(a->left)) {
+        __STL_TRY {
+            blacken(&a->left);
+        }
+        __STL_UNWIND(release(t));
+        return rotate_right(t);
+    }
+    return t;
+}
+
+//join_right()/join_left()的结果黑高度不变,根部可能与其右(左)子节点同为红色,此时染黑根部
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::link_type
+persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::
+    join(link_type l, size_type hl, link_type m, link_type r, size_type hr, size_type& h)
+{
+    if (hl > hr) {
+        link_type t = join_right(l, hl, m, r, hr);
+        h = hl;
+        if (t->red && is_red(t->right)) {
+            t->red = false;
+            ++h;
+        }
+        return t;
+    }
+    if (hl < hr) {
+        link_type t = join_left(l, hl, m, r, hr);
+        h = hr;
+        if (t->red && is_red(t->left)) {
+            t->red = false;
+            ++h;
+        }
+        return t;
+    }
+    m->left = l;
+    m->right = r;
+    m->red = !is_red(l) && !is_red(r);
+    h = m->red ? hl : hl + 1;
+    return m;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::link_type
+persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::
+    split_last(link_type x, size_type hx, link_type& l, size_type& hl)
+{
+    link_type a, b, t;
+    __STL_TRY {
+        t = expose(x, a, b);
+    }
+    __STL_UNWIND(release(x));
+    const size_type hc = t->red ? hx : hx - 1;
+    if (!b) {
+        l = a;
+        hl = hc;
+        return t;
+    }
+    link_type last, r;
+    size_type hr;
+    __STL_TRY {
+        last = split_last(b, hc, r, hr);
+    }
+    __STL_UNWIND((release(a), destroy_node(t)));
+    __STL_TRY {
+        l = join(a, hc, t, r, hr, hl);
+    }
+    __STL_UNWIND(destroy_node(last));
+    return last;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::link_type
+persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::
+    join2(link_type l, size_type hl, link_type r, size_type hr, size_type& h)
+{
+    if (!l) {
+        h = hr;
+        return r;
+    }
+    if (!r) {
+        h = hl;
+        return l;
+    }
+    link_type m, l2;
+    size_type h2;
+    __STL_TRY {
+        m = split_last(l, hl, l2, h2);
+    }
+    __STL_UNWIND(release(r));
+    return join(l2, h2, m, r, hr, h);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::link_type
+persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::
+    split(link_type x, size_type hx, const key_type& k,
+          link_type& l, size_type& hl, link_type& r, size_type& hr) const
+{
+    if (!x) {
+        l = r = 0;
+        hl = hr = 0;
+        return 0;
+    }
+    bool less_k, greater_k;
+    __STL_TRY {
+        less_k = key_compare(k, key(x));
+        greater_k = !less_k && key_compare(key(x), k);
+    }
+    __STL_UNWIND(release(x));
+    const size_type hc = x->red ? hx : hx - 1;
+    if (!less_k && !greater_k) { //键值等于k: 两个子树就是答案,x本身交还调用者
+        l = ref(x->left);
+        r = ref(x->right);
+        hl = hr = hc;
+        return x;
+    }
+    link_type a, b, t;
+    __STL_TRY {
+        t = expose(x, a, b);
+    }
+    __STL_UNWIND(release(x));
+    link_type found, mid;
+    size_type hmid;
+    if (less_k) { //k在左子树: 左子树split出的右半部与t、右子树接成r
+        __STL_TRY {
+            found = split(a, hc, k, l, hl, mid, hmid);
+        }
+        __STL_UNWIND((destroy_node(t), release(b)));
+        __STL_TRY {
+            r = join(mid, hmid, t, b, hc, hr);
+        }
+        __STL_UNWIND((release(l), release(found)));
+    } else {
+        __STL_TRY {
+            found = split(b, hc, k, mid, hmid, r, hr);
+        }
+        __STL_UNWIND((destroy_node(t), release(a)));
+        __STL_TRY {
+            l = join(a, hc, t, mid, hmid, hl);
+        }
+        __STL_UNWIND((release(r), release(found)));
+    }
+    return found;
+}
+
+//先查找: 键值已存在时不必产生任何新节点.
+//交给split()的是根部的另一个参考,所以旧树的节点refs至少为2,全程不会被就地修改,
+//抛出异常时*this因而不变
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+bool persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::insert_unique(const value_type& v)
+{
+    if (find(KeyOfValue()(v)) != end())
+        return false;
+    link_type z = create_node(v);
+    link_type l, r, t;
+    size_type hl, hr, h;
+    __STL_TRY {
+        split(ref(root), black_height, KeyOfValue()(v), l, hl, r, hr);
+    }
+    __STL_UNWIND(destroy_node(z));
+    t = join(l, hl, z, r, hr, h);
+    release(root);
+    root = t;
+    black_height = h;
+    ++node_count;
+    return true;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+bool persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::assign_unique(const value_type& v)
+{
+    link_type z = create_node(v);
+    link_type l, r, t, found;
+    size_type hl, hr, h;
+    __STL_TRY {
+        found = split(ref(root), black_height, KeyOfValue()(v), l, hl, r, hr);
+    }
+    __STL_UNWIND(destroy_node(z));
+    __STL_TRY {
+        t = join(l, hl, z, r, hr, h);
+    }
+    __STL_UNWIND(release(found));
+    release(found);
+    release(root);
+    root = t;
+    black_height = h;
+    if (!found)
+        ++node_count;
+    return found == 0;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::size_type
+persistent_tree<Key, Value, KeyOfValue, Compare, Alloc>::erase(const key_type& k)
+{
+    if (find(k) == end())
+        return 0;
+    link_type l, r, t, found;
+    size_type hl, hr, h;
+    found = split(ref(root), black_height, k, l, hl, r, hr);
+    __STL_TRY {
+        t = join2(l, hl, r, hr, h);
+    }
+    __STL_UNWIND(release(found));
+    release(found);
+    release(root);
+    root = t;
+    black_height = h;
+    --node_count;
+    return 1;
+}
+
+/*
+ * persistent_cell: 供多线程共享"目前版本"的容器,Tree为persistent_tree或persistent_map等.
+ *
+ * 读者以snapshot()取得目前版本的快照: 临界区只是复制根节点指针并把参考计数加一,
+ * 之后对快照的读取完全不必加锁,也不会看到写者修改到一半的状态.
+ * 写者在自己的版本上修改(O(log N)个新节点),再以publish()换上;
+ * 多个写者同时修改时,以compare_and_publish()确认期间没有别人换过版本,失败就重取快照再做一次.
+ * 被换下的旧版本在锁外释放,其节点要等到最后一份快照解构才真正归还.
+ */
+template <class Tree>
+class persistent_cell {
+private:
+    Tree current;
+    mutable __stl_spin_lock lock;
+public:
+    persistent_cell() { lock.initialize(); }
+    explicit persistent_cell(const Tree& t) : current(t) { lock.initialize(); }
+
+    Tree snapshot() const
+    {
+        __stl_auto_lock<__stl_spin_lock> guard(lock);
+        return current;
+    }
+    void publish(const Tree& t)
+    {
+        Tree tmp(t);
+        {
+            __stl_auto_lock<__stl_spin_lock> guard(lock);
+            current.swap(tmp);
+        }
+        //tmp(旧版本)在此解构,不占用锁
+    }
+    //目前版本仍是expected时才换上desired,返回是否成功
+    bool compare_and_publish(const Tree& expected, const Tree& desired)
+    {
+        Tree tmp(desired);
+        {
+            __stl_auto_lock<__stl_spin_lock> guard(lock);
+            if (!current.identical(expected))
+                return false;
+            current.swap(tmp);
+        }
+        return true;
+    }
+private:
+    persistent_cell(const persistent_cell&);
+    void operator=(const persistent_cell&);
+};
+
+#endif // SGI_STL_PERSISTENT_TREE_H
@@ -0,0 +1,151 @@
+#ifndef SGI_STL_POOL_SET_H
+#define SGI_STL_POOL_SET_H
+
+#include "02-allocator/stl_alloc.h"
+#include "07-functional/stl_function.h"
+#include "05-container/stl_pool_tree.h"
+
+//pool_set: 接口与set相同,底层是以32位索引连结、节点放在连续节点池中的pool_rb_tree,
+//每个元素的额外开销只有12字节. 原理与限制见<stl_pool_tree.h>;
+//插入可能使reference/pointer失效,迭代器则仍然有效
+
+template <class Key, class Compare = less<Key>, class Alloc = alloc>
+class pool_set;
+
+template <class Key, class Compare, class Alloc>
+inline bool operator==(const pool_set<Key, Compare, Alloc>& x,
+                       const pool_set<Key, Compare, Alloc>& y);
+
+template <class Key, class Compare, class Alloc>
+class pool_set {
+public:
+    typedef Key key_type;
+    typedef Key value_type;
+    typedef Compare key_compare;
+    typedef Compare value_compare;
+private:
+    typedef pool_rb_tree<key_type, value_type, identity<value_type>, key_compare, Alloc> rep_type;
+    rep_type t;
+public:
+    typedef typename rep_type::const_pointer pointer;
+    typedef typename rep_type::const_pointer const_pointer;
+    typedef typename rep_type::const_reference reference;
+    typedef typename rep_type::const_reference const_reference;
+    //与set相同,迭代器不允许写入元素
+    typedef typename rep_type::const_iterator iterator;
+    typedef typename rep_type::const_iterator const_iterator;
+    typedef typename rep_type::size_type size_type;
+    typedef typename rep_type::difference_type difference_type;
+
+    pool_set() : t(Compare()) {}
+    explicit pool_set(const Compare& comp) : t(comp) {}
+    template <class InputIterator>
+    pool_set(InputIterator first, InputIterator last) :
+        t(Compare()) { t.insert_unique(first, last); }
+    template <class InputIterator>
+    pool_set(InputIterator first, InputIterator last, const Compare& comp) :
+        t(comp) { t.insert_unique(first, last); }
+
+    //accessors
+    key_compare key_comp() const { return t.key_comp(); }
+    value_compare value_comp() const { return t.key_comp(); }
+    iterator begin() const { return t.begin(); }
+    iterator end() const { return t.end(); }
+    bool empty() const { return t.empty(); }
+    size_type size() const { return t.size(); }
+    size_type max_size() const { return t.max_size(); }
+    void swap(pool_set& x) { t.swap(x.t); }
+    void reserve(size_type n) { t.reserve(n); }
+
+    //insert/erase
+    pair<iterator, bool> insert(const value_type& x)
+    {
+        pair<typename rep_type::iterator, bool> p = t.insert_unique(x);
+        return pair<iterator, bool>(p.first, p.second);
+    }
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last) { t.insert_unique(first, last); }
+    void erase(iterator position)
+    {
+        typedef typename rep_type::iterator rep_iterator;
+        t.erase((rep_iterator&)position);
+    }
+    size_type erase(const key_type& x) { return t.erase(x); }
+    void erase(iterator first, iterator last)
+    {
+        typedef typename rep_type::iterator rep_iterator;
+        t.erase((rep_iterator&)first, (rep_iterator&)last);
+    }
+    void clear() { t.clear(); }
+
+    //set operations
+    iterator find(const key_type& x) const { return t.find(x); }
+    size_type count(const key_type& x) const { return t.count(x); }
+    iterator lower_bound(const key_type& x) const { return t.lower_bound(x); }
+    iterator upper_bound(const key_type& x) const { return t.upper_bound(x); }
+    pair<iterator, iterator> equal_range(const key_type& x) const { return t.equal_range(x); }
+
+    friend bool operator== __STL_NULL_TMPL_ARGS (const pool_set&, const pool_set&);
+};
+
+template <class Key, class Compare, class Alloc>
+inline bool operator==(const pool_set<Key, Compare, Alloc>& x,
+                       const pool_set<Key, Compare, Alloc>& y)
+{
+    return x.t == y.t;
+}
+
+#endif // SGI_STL_POOL_SET_H
+
+
+/*
+ * ========= BENCHMARK DEMO ============
+ * 每个元素占用的记忆体与随机查找的速度: set<int>(节点各自配置,颜色已并入父节点指针)
+ * 对照pool_set<int>(32位索引、连续节点池). 记忆体以malloc的统计取得,包含配置器的额外开销
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+//大的池子由mmap配置,不计入uordblks,要另外加上hblkhd
+static size_t heap_in_use()
+{
+    struct mallinfo mi = mallinfo();
+    return size_t(mi.uordblks) + size_t(mi.hblkhd);
+}
+
+template <class S>
+void run(const char* name, const unsigned* keys, size_t n)
+{
+    size_t before = heap_in_use();
+    S* s = new S;
+    for (size_t i = 0; i < n; ++i)
+        s->insert(int(keys[i]));
+    double bytes = double(heap_in_use() - before) / s->size();
+
+    unsigned long hits = 0;
+    clock_t t0 = clock();
+    for (int r = 0; r < 5; ++r)
+        for (size_t i = 0; i < n; ++i)
+            hits += s->find(int(keys[(i * 7919) % n] + r % 2)) != s->end();
+    double ns = 1e9 * double(clock() - t0) / CLOCKS_PER_SEC / (5 * n);
+    printf("%-14s %9zu elements %6.1f bytes/element %7.1f ns/find (%lu)\n", name, s->size(), bytes, ns, hits);
+    delete s;
+}
+
+int main()
+{
+    printf("sizeof node: rb_tree %zu, pool_rb_tree %zu\n",
+           sizeof(__rb_tree_node<int>), sizeof(__pool_tree_node<int>));
+    for (size_t n = 1000; n <= 10000000; n *= 10) {
+        unsigned* keys = new unsigned[n];
+        for (size_t i = 0; i < n; ++i)
+            keys[i] = unsigned(rand()) * 2;
+        run<set<int> >("set<int>", keys, n);
+        run<pool_set<int> >("pool_set<int>", keys, n);
+        delete[] keys;
+    }
+}
+
+ */
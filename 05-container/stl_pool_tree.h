@@ -0,0 +1,696 @@
+#ifndef SGI_STL_POOL_TREE_H
+#define SGI_STL_POOL_TREE_H
+
+#include <stddef.h>
+#include "01-config/stl_config.h"
+#include "02-allocator/stl_alloc.h"
+#include "02-allocator/stl_construct.h"
+#include "03-iterator/stl_iterator.h"
+#include "05-container/stl_pair.h"
+#include "06-algorithms/stl_algobase.h"
+#include "05-container/stl_tree.h" // __rb_tree_color_type
+#ifdef __STL_USE_EXCEPTIONS
+#include <stdexcept> // length_error
+#endif
+
+/*
+ * pool_rb_tree: 节点放在一块连续的节点池里、彼此以32位索引连结的RB-tree
+ *
+ * rb_tree的节点即使把颜色塞进父节点指针(见__rb_tree_node_base),在64位平台上
+ * 光是三个指针就占24字节,set<int>的节点有四分之三是连结. 元素少于2^31个时,
+ * 改用32位的索引只要12字节,set<int>的节点因而由32字节降为16字节;
+ * 节点一个挨一个放在同一块记忆体中,也不再有每个节点各自配置的额外开销.
+ *
+ * 索引的用法仿照rb_tree的header技巧:
+ *   池中第0格是header(不含元素): 它的parent是root,left是leftmost,right是rightmost
+ *   左右子节点为0表示没有子节点(header不会是任何节点的子节点,不致混淆)
+ *   root的parent为0,即header;迭代器走到0即为end()
+ * tagged_parent的最低位是颜色(红为0),其余31位是父节点索引,与rb_tree的作法一致.
+ * 删除的节点串在free list上(以left连结)供之后的插入重复使用.
+ *
+ * 与rb_tree的差异: 池子满了就配置两倍大的新池,把元素逐一复制过去,
+ * 所以插入可能使reference与pointer失效(迭代器只记索引,仍然有效);
+ * 元素的复制代价高时宜先reserve(). 元素个数最多2^31 - 2个(即max_size()),超过时丢出length_error.
+ * 迭代器记着的是容器的pool成员的位址而非池子本身,swap()之后原有的迭代器会指到
+ * 另一个容器的池子中同一个索引,所以swap()使两边的迭代器都失效(reference与pointer仍然有效).
+ */
+
+typedef unsigned int __pool_tree_index;
+
+template <class Value>
+struct __pool_tree_node {
+    typedef __rb_tree_color_type color_type;
+    typedef __pool_tree_index index_type;
+
+    index_type tagged_parent; //父节点索引 << 1 | 颜色
+    index_type left;
+    index_type right;
+    Value value_field;
+
+    index_type parent() const { return tagged_parent >> 1; }
+    color_type color() const { return color_type(tagged_parent & 1); }
+    void set_parent(index_type p) { tagged_parent = (p << 1) | (tagged_parent & 1); }
+    void set_color(color_type c) { tagged_parent = (tagged_parent & ~index_type(1)) | index_type(c); }
+};
+
+//闲置节点的tagged_parent: 父节点索引超过上限,不会与使用中的节点混淆
+static const __pool_tree_index __pool_tree_free = ~__pool_tree_index(0);
+
+/* 以下全局函数以节点池p与索引操作,算法与rb_tree的同名函数相同 */
+
+//中序的下一个节点,最后一个节点的下一个为0(header)
+template <class Node>
+inline __pool_tree_index __pool_tree_next(const Node* p, __pool_tree_index x)
+{
+    if (p[x].right != 0) {
+        x = p[x].right;
+        while (p[x].left != 0)
+            x = p[x].left;
+        return x;
+    }
+    __pool_tree_index y = p[x].parent();
+    while (y != 0 && x == p[y].right) { //header的索引为0,不必像rb_tree那样特别处理
+        x = y;
+        y = p[y].parent();
+    }
+    return y;
+}
+
+//中序的前一个节点,header(end())的前一个为rightmost
+template <class Node>
+inline __pool_tree_index __pool_tree_prev(const Node* p, __pool_tree_index x)
+{
+    if (x == 0)
+        return p[0].right;
+    if (p[x].left != 0) {
+        x = p[x].left;
+        while (p[x].right != 0)
+            x = p[x].right;
+        return x;
+    }
+    __pool_tree_index y = p[x].parent();
+    while (y != 0 && x == p[y].left) {
+        x = y;
+        y = p[y].parent();
+    }
+    return y;
+}
+
+//以y取代x在其父节点之下的位置;x为root时改写header
+template <class Node>
+inline void __pool_tree_replace_child(Node* p, __pool_tree_index x, __pool_tree_index y)
+{
+    const __pool_tree_index xp = p[x].parent();
+    if (xp == 0)
+        p[0].set_parent(y);
+    else if (x == p[xp].left)
+        p[xp].left = y;
+    else
+        p[xp].right = y;
+}
+
+template <class Node>
+inline void __pool_tree_rotate_left(Node* p, __pool_tree_index x)
+{
+    const __pool_tree_index y = p[x].right;
+    p[x].right = p[y].left;
+    if (p[y].left != 0)
+        p[p[y].left].set_parent(x);
+    __pool_tree_replace_child(p, x, y);
+    p[y].set_parent(p[x].parent());
+    p[y].left = x;
+    p[x].set_parent(y);
+}
+
+template <class Node>
+inline void __pool_tree_rotate_right(Node* p, __pool_tree_index x)
+{
+    const __pool_tree_index y = p[x].left;
+    p[x].left = p[y].right;
+    if (p[y].right != 0)
+        p[p[y].right].set_parent(x);
+    __pool_tree_replace_child(p, x, y);
+    p[y].set_parent(p[x].parent());
+    p[y].right = x;
+    p[x].set_parent(y);
+}
+
+//新挂上的红节点x可能与父节点连续为红,往上修正,见__rb_tree_fix_red()
+template <class Node>
+void __pool_tree_rebalance(Node* p, __pool_tree_index x)
+{
+    while (x != p[0].parent() && p[p[x].parent()].color() == __rb_tree_red) {
+        __pool_tree_index xp = p[x].parent();
+        const __pool_tree_index g = p[xp].parent();
+        if (xp == p[g].left) {
+            const __pool_tree_index y = p[g].right; //伯父节点
+            if (y != 0 && p[y].color() == __rb_tree_red) {
+                p[xp].set_color(__rb_tree_black);
+                p[y].set_color(__rb_tree_black);
+                p[g].set_color(__rb_tree_red);
+                x = g;
+            } else {
+                if (x == p[xp].right) {
+                    x = xp;
+                    __pool_tree_rotate_left(p, x);
+                    xp = p[x].parent();
+                }
+                p[xp].set_color(__rb_tree_black);
+                p[g].set_color(__rb_tree_red);
+                __pool_tree_rotate_right(p, g);
+            }
+        } else {
+            const __pool_tree_index y = p[g].left;
+            if (y != 0 && p[y].color() == __rb_tree_red) {
+                p[xp].set_color(__rb_tree_black);
+                p[y].set_color(__rb_tree_black);
+                p[g].set_color(__rb_tree_red);
+                x = g;
+            } else {
+                if (x == p[xp].left) {
+                    x = xp;
+                    __pool_tree_rotate_right(p, x);
+                    xp = p[x].parent();
+                }
+                p[xp].set_color(__rb_tree_black);
+                p[g].set_color(__rb_tree_red);
+                __pool_tree_rotate_left(p, g);
+            }
+        }
+    }
+    p[p[0].parent()].set_color(__rb_tree_black); //根节点永远为黑
+}
+
+//把z由树中摘除并恢复平衡(连同header的leftmost/rightmost),见__rb_tree_rebalance_for_erase()
+template <class Node>
+void __pool_tree_rebalance_for_erase(Node* p, __pool_tree_index z)
+{
+    __pool_tree_index y = z;
+    __pool_tree_index x = 0;
+    __pool_tree_index x_parent = 0;
+    if (p[y].left == 0)
+        x = p[y].right;
+    else if (p[y].right == 0)
+        x = p[y].left;
+    else {
+        y = p[y].right;
+        while (p[y].left != 0)
+            y = p[y].left;
+        x = p[y].right;
+    }
+    if (y != z) { //以后继y顶替z
+        p[p[z].left].set_parent(y);
+        p[y].left = p[z].left;
+        if (y != p[z].right) {
+            x_parent = p[y].parent();
+            if (x != 0)
+                p[x].set_parent(x_parent);
+            p[x_parent].left = x; //y必为左子节点
+            p[y].right = p[z].right;
+            p[p[z].right].set_parent(y);
+        } else
+            x_parent = y;
+        __pool_tree_replace_child(p, z, y);
+        p[y].set_parent(p[z].parent());
+        const __rb_tree_color_type c = p[y].color();
+        p[y].set_color(p[z].color());
+        p[z].set_color(c);
+        y = z; //y改指实际被移走的位置(其颜色已换成y原来的)
+    } else {
+        x_parent = p[y].parent();
+        if (x != 0)
+            p[x].set_parent(x_parent);
+        __pool_tree_replace_child(p, z, x);
+        if (p[0].left == z) {
+            if (p[z].right == 0) //z的左子节点必为0
+                p[0].left = p[z].parent(); //z为root时leftmost即成为header
+            else {
+                __pool_tree_index m = x;
+                while (p[m].left != 0)
+                    m = p[m].left;
+                p[0].left = m;
+            }
+        }
+        if (p[0].right == z) {
+            if (p[z].left == 0)
+                p[0].right = p[z].parent();
+            else {
+                __pool_tree_index m = x;
+                while (p[m].right != 0)
+                    m = p[m].right;
+                p[0].right = m;
+            }
+        }
+    }
+    if (p[y].color() == __rb_tree_red)
+        return;
+    //移走的是黑节点,必须修补
+    while (x != p[0].parent() && (x == 0 || p[x].color() == __rb_tree_black)) {
+        if (x == p[x_parent].left) {
+            __pool_tree_index w = p[x_parent].right; //兄弟节点
+            if (p[w].color() == __rb_tree_red) {
+                p[w].set_color(__rb_tree_black);
+                p[x_parent].set_color(__rb_tree_red);
+                __pool_tree_rotate_left(p, x_parent);
+                w = p[x_parent].right;
+            }
+            if ((p[w].left == 0 || p[p[w].left].color() == __rb_tree_black) &&
+                (p[w].right == 0 || p[p[w].right].color() == __rb_tree_black)) {
+                p[w].set_color(__rb_tree_red);
+                x = x_parent;
+                x_parent = p[x_parent].parent();
+            } else {
+                if (p[w].right == 0 || p[p[w].right].color() == __rb_tree_black) {
+                    p[p[w].left].set_color(__rb_tree_black);
+                    p[w].set_color(__rb_tree_red);
+                    __pool_tree_rotate_right(p, w);
+                    w = p[x_parent].right;
+                }
+                p[w].set_color(p[x_parent].color());
+                p[x_parent].set_color(__rb_tree_black);
+                if (p[w].right != 0)
+                    p[p[w].right].set_color(__rb_tree_black);
+                __pool_tree_rotate_left(p, x_parent);
+                break;
+            }
+        } else { //对称
+            __pool_tree_index w = p[x_parent].left;
+            if (p[w].color() == __rb_tree_red) {
+                p[w].set_color(__rb_tree_black);
+                p[x_parent].set_color(__rb_tree_red);
+                __pool_tree_rotate_right(p, x_parent);
+                w = p[x_parent].left;
+            }
+            if ((p[w].right == 0 || p[p[w].right].color() == __rb_tree_black) &&
+                (p[w].left == 0 || p[p[w].left].color() == __rb_tree_black)) {
+                p[w].set_color(__rb_tree_red);
+                x = x_parent;
+                x_parent = p[x_parent].parent();
+            } else {
+                if (p[w].left == 0 || p[p[w].left].color() == __rb_tree_black) {
+                    p[p[w].right].set_color(__rb_tree_black);
+                    p[w].set_color(__rb_tree_red);
+                    __pool_tree_rotate_left(p, w);
+                    w = p[x_parent].left;
+                }
+                p[w].set_color(p[x_parent].color());
+                p[x_parent].set_color(__rb_tree_black);
+                if (p[w].left != 0)
+                    p[p[w].left].set_color(__rb_tree_black);
+                __pool_tree_rotate_right(p, x_parent);
+                break;
+            }
+        }
+    }
+    if (x != 0)
+        p[x].set_color(__rb_tree_black);
+}
+
+//迭代器只记录节点池(的地址所在)与索引,池子换新之后依然有效
+template <class Value, class Ref, class Ptr>
+struct __pool_tree_iterator {
+    typedef bidirectional_iterator_tag iterator_category;
+    typedef Value value_type;
+    typedef Ref reference;
+    typedef Ptr pointer;
+    typedef ptrdiff_t difference_type;
+    typedef __pool_tree_iterator<Value, Value&, Value*> iterator;
+    typedef __pool_tree_iterator<Value, Ref, Ptr> self;
+    typedef __pool_tree_node<Value> node;
+
+    node* const* pool; //指向容器的pool栏位
+    __pool_tree_index index;
+
+    __pool_tree_iterator() : pool(0), index(0) {}
+    __pool_tree_iterator(node* const* p, __pool_tree_index i) : pool(p), index(i) {}
+    __pool_tree_iterator(const iterator& x) : pool(x.pool), index(x.index) {}
+
+    reference operator*() const { return (*pool)[index].value_field; }
+    #ifndef __SGI_STL_NO_ARROW_OPERATOR
+    pointer operator->() const { return &(operator*()); }
+    #endif // __SGI_STL_NO_ARROW_OPERATOR
+
+    self& operator++() { index = __pool_tree_next(*pool, index); return *this; }
+    self& operator--() { index = __pool_tree_prev(*pool, index); return *this; }
+    self operator++(int) { self tmp = *this; ++*this; return tmp; }
+    self operator--(int) { self tmp = *this; --*this; return tmp; }
+
+    bool operator==(const self& x) const { return index == x.index; }
+    bool operator!=(const self& x) const { return index != x.index; }
+};
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc = alloc>
+class pool_rb_tree {
+public:
+    typedef Key key_type;
+    typedef Value value_type;
+    typedef value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef __pool_tree_iterator<value_type, reference, pointer> iterator;
+    typedef __pool_tree_iterator<value_type, const_reference, const_pointer> const_iterator;
+protected:
+    typedef __pool_tree_index index_type;
+    typedef __pool_tree_node<Value> node;
+    typedef simple_alloc<node, Alloc> pool_allocator;
+
+    enum { __initial_capacity = 16 };
+
+    node* pool;         //pool[0]为header
+    size_type capacity; //pool的格数
+    size_type used;     //曾经用过的格数(含header),其后皆未用过
+    index_type free_list; //被删除而可重复使用的格子,以left串接,0为串尾
+    size_type node_count;
+    Compare key_compare;
+
+    static const Key& key(const node& x) { return KeyOfValue()(x.value_field); }
+    index_type root() const { return pool[0].parent(); }
+public:
+    pool_rb_tree(const Compare& comp = Compare())
+        : pool(0), capacity(0), used(0), free_list(0), node_count(0), key_compare(comp)
+    {
+        init(__initial_capacity);
+    }
+    pool_rb_tree(const pool_rb_tree& x)
+        : pool(0), capacity(0), used(0), free_list(x.free_list),
+          node_count(x.node_count), key_compare(x.key_compare)
+    {
+        //索引不变,整个池子照原样复制即可(连free list一起)
+        init(x.used);
+        __STL_TRY {
+            copy_slots(x.pool, x.used, pool);
+        }
+        __STL_UNWIND(pool_allocator::deallocate(pool, capacity));
+        used = x.used;
+    }
+    ~pool_rb_tree()
+    {
+        destroy_slots();
+        pool_allocator::deallocate(pool, capacity);
+    }
+    pool_rb_tree& operator=(const pool_rb_tree& x)
+    {
+        if (this != &x) {
+            pool_rb_tree tmp(x);
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    //accessors
+    Compare key_comp() const { return key_compare; }
+    iterator begin() { return iterator(&pool, pool[0].left); }
+    const_iterator begin() const { return const_iterator(&pool, pool[0].left); }
+    iterator end() { return iterator(&pool, 0); }
+    const_iterator end() const { return const_iterator(&pool, 0); }
+    bool empty() const { return node_count == 0; }
+    size_type size() const { return node_count; }
+    size_type max_size() const { return size_type(__pool_tree_free >> 1) - 1; }
+    void swap(pool_rb_tree& t)
+    {
+        __STD::swap(pool, t.pool);
+        __STD::swap(capacity, t.capacity);
+        __STD::swap(used, t.used);
+        __STD::swap(free_list, t.free_list);
+        __STD::swap(node_count, t.node_count);
+        __STD::swap(key_compare, t.key_compare);
+    }
+    //预先配置足以容纳n个元素的池子,之后的插入不再复制元素
+    void reserve(size_type n)
+    {
+        if (n > max_size())
+            __length_error();
+        if (n + 1 > capacity)
+            grow(n + 1);
+    }
+
+    //insert/erase
+    pair<iterator, bool> insert_unique(const value_type& v);
+    iterator insert_equal(const value_type& v);
+    template <class InputIterator>
+    void insert_unique(InputIterator first, InputIterator last)
+    {
+        for (; first != last; ++first)
+            insert_unique(*first);
+    }
+    template <class InputIterator>
+    void insert_equal(InputIterator first, InputIterator last)
+    {
+        for (; first != last; ++first)
+            insert_equal(*first);
+    }
+    void erase(iterator position)
+    {
+        __pool_tree_rebalance_for_erase(pool, position.index);
+        put_slot(position.index);
+        --node_count;
+    }
+    size_type erase(const key_type& k);
+    void erase(iterator first, iterator last)
+    {
+        if (first == begin() && last == end())
+            clear();
+        else
+            while (first != last)
+                erase(first++);
+    }
+    //池子的大小不变
+    void clear()
+    {
+        destroy_slots();
+        used = 1;
+        free_list = 0;
+        node_count = 0;
+        pool[0].tagged_parent = 0;
+        pool[0].left = pool[0].right = 0;
+    }
+
+    //set operations
+    iterator find(const key_type& k)
+    {
+        const index_type j = lower_index(k);
+        return iterator(&pool, j == 0 || key_compare(k, key(pool[j])) ? 0 : j);
+    }
+    const_iterator find(const key_type& k) const
+    {
+        const index_type j = lower_index(k);
+        return const_iterator(&pool, j == 0 || key_compare(k, key(pool[j])) ? 0 : j);
+    }
+    size_type count(const key_type& k) const
+    {
+        size_type n = 0;
+        for (index_type j = lower_index(k), u = upper_index(k); j != u; j = __pool_tree_next(pool, j))
+            ++n;
+        return n;
+    }
+    iterator lower_bound(const key_type& k) { return iterator(&pool, lower_index(k)); }
+    const_iterator lower_bound(const key_type& k) const { return const_iterator(&pool, lower_index(k)); }
+    iterator upper_bound(const key_type& k) { return iterator(&pool, upper_index(k)); }
+    const_iterator upper_bound(const key_type& k) const { return const_iterator(&pool, upper_index(k)); }
+    pair<iterator, iterator> equal_range(const key_type& k)
+    {
+        return pair<iterator, iterator>(lower_bound(k), upper_bound(k));
+    }
+    pair<const_iterator, const_iterator> equal_range(const key_type& k) const
+    {
+        return pair<const_iterator, const_iterator>(lower_bound(k), upper_bound(k));
+    }
+protected:
+    //键值不小于k的第一个节点,没有则为0
+    index_type lower_index(const key_type& k) const
+    {
+        index_type y = 0;
+        for (index_type x = root(); x != 0; )
+            if (!key_compare(key(pool[x]), k))
+                y = x, x = pool[x].left;
+            else
+                x = pool[x].right;
+        return y;
+    }
+    index_type upper_index(const key_type& k) const
+    {
+        index_type y = 0;
+        for (index_type x = root(); x != 0; )
+            if (key_compare(k, key(pool[x])))
+                y = x, x = pool[x].left;
+            else
+                x = pool[x].right;
+        return y;
+    }
+
+    //把v放在y之下(left_side决定左右),y为0表示树原本是空的
+    iterator __insert(index_type y, bool left_side, const value_type& v)
+    {
+        const index_type z = get_slot(v); //可能换新池子,之后才取用pool
+        if (y == 0) {
+            pool[0].set_parent(z);
+            pool[0].left = pool[0].right = z;
+        } else if (left_side) {
+            pool[y].left = z;
+            if (y == pool[0].left)
+                pool[0].left = z;
+        } else {
+            pool[y].right = z;
+            if (y == pool[0].right)
+                pool[0].right = z;
+        }
+        pool[z].tagged_parent = y << 1; //新节点必为红
+        pool[z].left = pool[z].right = 0;
+        __pool_tree_rebalance(pool, z);
+        ++node_count;
+        return iterator(&pool, z);
+    }
+
+    //取得一格并在其中构造v
+    index_type get_slot(const value_type& v)
+    {
+        index_type i = free_list;
+        if (i != 0) {
+            construct(&pool[i].value_field, v);
+            free_list = pool[i].left;
+            return i;
+        }
+        if (used > max_size()) //再多一格,索引就放不进tagged_parent的31位
+            __length_error();
+        i = index_type(used);
+        if (used == capacity) {
+            //加倍,但不超过索引所能表示的max_size() + 1格(含header)
+            const size_type n = capacity > max_size() / 2 ? max_size() + 1 : capacity * 2;
+            grow(n, &v); //v可能就在旧池子中(如insert_equal(*begin())),须在释放旧池子前构造
+        } else
+            construct(&pool[i].value_field, v);
+        ++used;
+        return i;
+    }
+    static void __length_error()
+    {
+#ifdef __STL_USE_EXCEPTIONS
+        throw std::length_error("pool_rb_tree");
+#else
+        __stl_assert(!"pool_rb_tree: too many elements");
+#endif
+    }
+    void put_slot(index_type i)
+    {
+        destory(&pool[i].value_field);
+        pool[i].tagged_parent = __pool_tree_free;
+        pool[i].left = free_list;
+        free_list = i;
+    }
+
+    //配置n格(至少一格,给header)
+    void init(size_type n)
+    {
+        capacity = n < __initial_capacity ? size_type(__initial_capacity) : n;
+        pool = pool_allocator::allocate(capacity);
+        used = 1;
+        pool[0].tagged_parent = 0; //header为红色,root为0
+        pool[0].left = pool[0].right = 0;
+    }
+    //换成n格的新池子,索引不变. v不为0时顺便在新池子的第used格构造*v
+    void grow(size_type n, const value_type* v = 0)
+    {
+        node* tmp = pool_allocator::allocate(n);
+        __STL_TRY {
+            copy_slots(pool, used, tmp);
+            if (v) {
+                __STL_TRY {
+                    construct(&tmp[used].value_field, *v);
+                }
+                __STL_UNWIND(destroy_slots(tmp, used));
+            }
+        }
+        __STL_UNWIND(pool_allocator::deallocate(tmp, n));
+        destroy_slots();
+        pool_allocator::deallocate(pool, capacity);
+        pool = tmp;
+        capacity = n;
+    }
+    //把src的前n格复制到dest: 连结照抄,使用中的格子复制元素.失败时已构造的都析构掉
+    static void copy_slots(const node* src, size_type n, node* dest)
+    {
+        size_type i = 0;
+        __STL_TRY {
+            for (; i < n; ++i) {
+                dest[i].tagged_parent = src[i].tagged_parent;
+                dest[i].left = src[i].left;
+                dest[i].right = src[i].right;
+                if (i != 0 && src[i].tagged_parent != __pool_tree_free)
+                    construct(&dest[i].value_field, src[i].value_field);
+            }
+        }
+        __STL_UNWIND(destroy_slots(dest, i));
+    }
+    void destroy_slots() { destroy_slots(pool, used); }
+    static void destroy_slots(node* p, size_type n)
+    {
+        for (size_type i = 1; i < n; ++i)
+            if (p[i].tagged_parent != __pool_tree_free)
+                destory(&p[i].value_field);
+    }
+};
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+pair<typename pool_rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::iterator, bool>
+pool_rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::insert_unique(const value_type& v)
+{
+    const Key& k = KeyOfValue()(v);
+    index_type y = 0;
+    index_type x = root();
+    bool comp = true;
+    while (x != 0) {
+        y = x;
+        comp = key_compare(k, key(pool[x]));
+        x = comp ? pool[x].left : pool[x].right;
+    }
+    //与rb_tree::insert_unique()相同: 检查插入点的前一个节点是否键值相同
+    index_type j = y;
+    if (comp) {
+        if (j == pool[0].left) //插入点为最左(或树为空)
+            return pair<iterator, bool>(__insert(y, true, v), true);
+        j = __pool_tree_prev(pool, j);
+    }
+    if (key_compare(key(pool[j]), k))
+        return pair<iterator, bool>(__insert(y, comp, v), true);
+    return pair<iterator, bool>(iterator(&pool, j), false);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename pool_rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::iterator
+pool_rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::insert_equal(const value_type& v)
+{
+    const Key& k = KeyOfValue()(v);
+    index_type y = 0;
+    bool comp = true;
+    for (index_type x = root(); x != 0; ) {
+        y = x;
+        comp = key_compare(k, key(pool[x]));
+        x = comp ? pool[x].left : pool[x].right;
+    }
+    return __insert(y, comp, v);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+typename pool_rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::size_type
+pool_rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::erase(const key_type& k)
+{
+    pair<iterator, iterator> p = equal_range(k);
+    size_type n = 0;
+    while (p.first != p.second) {
+        erase(p.first++);
+        ++n;
+    }
+    return n;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+inline bool operator==(const pool_rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& x,
+                       const pool_rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& y)
+{
+    return x.size() == y.size() && equal(x.begin(), x.end(), y.begin());
+}
+
+#endif // SGI_STL_POOL_TREE_H
@@ -40,6 +40,8 @@ public:
     typedef typename rep_type::const_reverse_iterator const_reverse_iterator;
     typedef typename rep_type::size_type size_type;
     typedef typename rep_type::difference_type difference_type;
+    //节点把手,见rb_tree::node_type
+    typedef typename rep_type::node_type node_type;
 
     /* allocator/deallocator
      * 注意set一定使用RB-tree的insert_unique()而非insert_equal()
@@ -86,6 +88,9 @@ public:
     {
         t.insert_unique(first, last);
     }
+    //set为空且[first, last)已严格递增时,O(N)建树而不做任何比较,见rb_tree::from_sorted()
+    template <class ForwardIterator>
+    void from_sorted(ForwardIterator first, ForwardIterator last) { t.from_sorted(first, last); }
     void erase(iterator position)
     {
         typedef typename rep_type::iterator rep_iterator;
@@ -97,14 +102,59 @@ public:
         typedef typename rep_type::iterator rep_iterator;
         t.erase((rep_iterator&)first, (rep_iterator&)last);
     }
+    //删除键值落在[a, b)的元素(如依时间排序的逾期项目),O(log N + k),见rb_tree::erase_range()
+    size_type erase_range(const key_type& a, const key_type& b) { return t.erase_range(a, b); }
+    //删除pred(元素)为真的全部元素,连续一段要删除者一次切下,见rb_tree::erase_if()
+    template <class Predicate>
+    size_type erase_if(Predicate pred) { return t.erase_if(pred); }
     void clear() { t.clear(); }
 
+    //节点的摘下与插回: 不配置记忆体、不复制元素,见map
+    node_type extract(iterator position)
+    {
+        typedef typename rep_type::iterator rep_iterator;
+        return t.extract((rep_iterator&)position);
+    }
+    node_type extract(const key_type& x) { return t.extract(x); }
+    pair<iterator, bool> insert(node_type& nh)
+    {
+        pair<typename rep_type::iterator, bool> p = t.insert_unique(nh);
+        return pair<iterator, bool>(p.first, p.second);
+    }
+    void merge(set<Key, Compare, Alloc>& x) { t.merge_unique(x.t); }
+
+    //整体集合运算: x的节点直接搬入或释放(不配置、不复制),结束后x为空.
+    //O(m log(n/m + 1)),threads不为1时平行执行(0为全部硬件线程),见rb_tree::union_with()
+    void union_with(set<Key, Compare, Alloc>& x, size_type threads = 1) { t.union_with(x.t, threads); }
+    void intersect_with(set<Key, Compare, Alloc>& x, size_type threads = 1) { t.intersect_with(x.t, threads); }
+    void difference_with(set<Key, Compare, Alloc>& x, size_type threads = 1) { t.difference_with(x.t, threads); }
+    //键值不小于k的元素移到空的right中,O(log N + min(|l|, |r|)),较小一侧须逐一计数;
+    //把键值都较大的right整个接到后面,O(log N)
+    void split(const key_type& k, set<Key, Compare, Alloc>& right) { t.split(k, right.t); }
+    void join(set<Key, Compare, Alloc>& right) { t.join(right.t); }
+
     //set operations:
     iterator find(const key_type& x) const { return t.find(x); }
     size_type count(const key_type& x) const { return t.count(x); }
     iterator lower_bound(const key_type& x) const { return t.lower_bound(x); }
     iterator upper_bound(const key_type& x) const { return t.upper_bound(x); }
     pair<iterator, iterator> equal_range(const key_type& x) const { return t.equal_range(x); }
+    //异质查找: 仅当Compare透明(如less<void>)时开放,可用const char*等直接查找,见rb_tree
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    find(const K& x) const { return t.find(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, size_type>::type
+    count(const K& x) const { return t.count(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    lower_bound(const K& x) const { return t.lower_bound(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    upper_bound(const K& x) const { return t.upper_bound(x); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, pair<iterator, iterator> >::type
+    equal_range(const K& x) const { return t.equal_range(x); }
     //以下__STL_NULL_TMPL_ARGS被定义为<>,详见1.9.1节
     #define __STL_NULL_TMPL_ARGS <> //zyw因未添加第一章配置,此处定义该宏
     friend bool operator== __STL_NULL_TMPL_ARGS(const set&, const set&);
@@ -5,6 +5,8 @@
 #include "02-allocator/stl_alloc.h"
 
 #include "05-container/stl_pair.h" //zyw自己手动加的
+#include "03-iterator/type_traits.h" // __enable_if_transparent
+#include "01-config/stl_threads.h" // __stl_parallel_run
 
 /* 
  * RB_TREE RULES
@@ -72,17 +74,26 @@
 
 typedef bool __rb_tree_color_type;
 const __rb_tree_color_type __rb_tree_red = false;   //红色为0
-const __rb_tree_color_type __rb_tree_black = false; //黑色为1
+const __rb_tree_color_type __rb_tree_black = true;  //黑色为1
 
 struct __rb_tree_node_base {
     typedef __rb_tree_color_type color_type;
     typedef __rb_tree_node_base* base_ptr;
 
-    color_type color; //节点颜色,非红即黑
-    base_ptr parent;  //RB树的许多操作必须知道父节点
+    //父节点地址与节点颜色共用一个字: 节点至少按指针对齐,地址的最低位必为0,正好拿来存颜色.
+    //64位平台上少了一个被补齐成8字节的color栏位,set<int>的节点由40字节降为32字节.
+    //红色为0,所以红节点的tagged_parent就是父节点地址本身(header即利用这一点,见rb_tree::root())
+    base_ptr tagged_parent;
     base_ptr left;    //指向左节点
     base_ptr right;   //指向右节点
 
+    //RB树的许多操作必须知道父节点
+    base_ptr parent() const { return base_ptr(size_t(tagged_parent) & ~size_t(1)); }
+    //节点颜色,非红即黑
+    color_type color() const { return color_type(size_t(tagged_parent) & 1); }
+    void set_parent(base_ptr p) { tagged_parent = base_ptr(size_t(p) | (size_t(tagged_parent) & 1)); }
+    void set_color(color_type c) { tagged_parent = base_ptr((size_t(tagged_parent) & ~size_t(1)) | size_t(c)); }
+
     static base_ptr minimum(base_ptr x)
     {
         while (x->left != 0) 
@@ -97,9 +108,61 @@ struct __rb_tree_node_base {
     }
 };
 
-template <class Value>
-struct __rb_tree_node : public __rb_tree_node_base {
-    typedef __rb_tree_node<Value>* link_type;
+/*
+ * 增强(augmented)RB-tree
+ * 节点上另外维护一份由子树算出的资讯,树形每次改变时顺便重算,就能回答普通RB-tree答不了的查询.
+ * 树形只在三处改变: 新节点挂上、节点摘除,以及rebalance中的旋转;旋转只改变x与y两个节点的子树,
+ * 所以只需依"先x后y"重算两者. 以上都是O(1)或O(log N)的额外工作,不改变各操作的复杂度.
+ *
+ * 增强策略(Augment)提供:
+ *   node_base                  节点的基类(额外的栏位放在这里,value_field之前)
+ *   update(x)                  由x的左右子节点重算x
+ *   insert_path(x, root)       新节点x刚挂上(尚未rebalance),修正x及其各祖先
+ *   erase_path(x, root)        节点摘除后,由x往上修正到root(x可能是header)
+ */
+struct __rb_tree_no_augment {
+    typedef __rb_tree_node_base node_base;
+    static void update(__rb_tree_node_base*) {}
+    static void insert_path(__rb_tree_node_base*, __rb_tree_node_base*) {}
+    static void erase_path(__rb_tree_node_base*, __rb_tree_node_base*) {}
+};
+
+//顺序统计(order statistic): 每个节点记录以它为根的子树的节点数,
+//于是第k小的元素(select)与元素的名次(rank)都能由根往下O(log N)求得
+struct __rb_tree_size_node_base : public __rb_tree_node_base {
+    size_t size; //以本节点为根的子树节点数(含自己)
+};
+
+struct __rb_tree_size_augment {
+    typedef __rb_tree_size_node_base node_base;
+
+    static size_t size(__rb_tree_node_base* x) { return x ? ((node_base*)x)->size : 0; }
+    static void update(__rb_tree_node_base* x)
+    {
+        ((node_base*)x)->size = 1 + size(x->left) + size(x->right);
+    }
+    //新节点为叶节点,自己为1,由它到root的每个祖先都多了一个节点
+    static void insert_path(__rb_tree_node_base* x, __rb_tree_node_base* root)
+    {
+        ((node_base*)x)->size = 1;
+        while (x != root) {
+            x = x->parent();
+            ++((node_base*)x)->size;
+        }
+    }
+    //摘除后x以上的子树形状可能已变(后继节点顶替了被删者),逐一重算而非单纯减1
+    static void erase_path(__rb_tree_node_base* x, __rb_tree_node_base* root)
+    {
+        if (root == 0)
+            return;
+        for (__rb_tree_node_base* header = root->parent(); x != header; x = x->parent())
+            update(x);
+    }
+};
+
+template <class Value, class Base = __rb_tree_node_base>
+struct __rb_tree_node : public Base {
+    typedef __rb_tree_node<Value, Base>* link_type;
     Value value_field; //节点值
 };
 
@@ -119,10 +182,10 @@ struct __rb_tree_base_iterator {
             while (node->left != 0)     //然后一直往左子树走到底
                 node = node->left;      //即是解答
         } else {                        //没有右子节点(状况2)
-            base_ptr y = node->parent;  //找出父节点
+            base_ptr y = node->parent(); //找出父节点
             while (node == y->right) {  //如果现行节点本身是个右子节
                 node = y;               //就一直上溯,直到"不为右子节点"止
-                y = y->parent;
+                y = y->parent();
             }
             if (node->right != y)       //若此时的右节点不等于此时的父节点(状况3)
                 node = y;               //此时的父节点即为解答,否则此时的node为解答(状况4)
@@ -135,8 +198,8 @@ struct __rb_tree_base_iterator {
     //以下其实可实现于operator--内,因为再无他处会调用此函数了
     void decrement()
     {
-        if (node->color == __rb_tree_red && //如果是红节点,且父节点的父节点等于自己
-            node->parent->parent == node) { //父节点的父节点等于自己
+        if (node->color() == __rb_tree_red && //如果是红节点,且父节点的父节点等于自己
+            node->parent()->parent() == node) { //父节点的父节点等于自己
             node = node->right;             //状况(1)右子节点即为解答
         //以上情况发生于node为header时(亦即node为end时)
         //注意,header之右子节点即mostright, 指向整棵树的max节点
@@ -146,10 +209,10 @@ struct __rb_tree_base_iterator {
                 y = y->right;               //一直往右子节点走到底
             node = y;                       //最后即为答案
         } else {                            //既非根节点,亦无左子节点
-            base_ptr y = node->parent;      //状况3,找出父节点
+            base_ptr y = node->parent();    //状况3,找出父节点
             while (node == y->left) {       //当现行节点身为左子节点
                 node = y;                   //一直交替往上走,直到现行节点
-                y = y->parent;              //不为左子节点
+                y = y->parent();            //不为左子节点
             }
             node = y;                       //此时之父节点即为答案          
         }
@@ -157,16 +220,16 @@ struct __rb_tree_base_iterator {
 };
 //以上双层架构与slist极相似
 
-//RB-tree的迭代器
-template <class Value, class Ref, class Ptr>
+//RB-tree的迭代器. NodeBase须与树的节点基类一致,才能由node找到value_field
+template <class Value, class Ref, class Ptr, class NodeBase = __rb_tree_node_base>
 struct __rb_tree_iterator : public __rb_tree_base_iterator {
     typedef Value value_type;
     typedef Ref reference;
     typedef Ptr pointer;
-    typedef __rb_tree_iterator<Value, Value&, Value*> iterator;
-    typedef __rb_tree_iterator<Value, const Value&, const Value*> const_iterator;
-    typedef __rb_tree_iterator<Value, Ref, Ptr> self;
-    typedef __rb_tree_node<Value>* link_type;
+    typedef __rb_tree_iterator<Value, Value&, Value*, NodeBase> iterator;
+    typedef __rb_tree_iterator<Value, const Value&, const Value*, NodeBase> const_iterator;
+    typedef __rb_tree_iterator<Value, Ref, Ptr, NodeBase> self;
+    typedef __rb_tree_node<Value, NodeBase>* link_type;
 
     __rb_tree_iterator() {}
     __rb_tree_iterator(link_type x) { node = x; }
@@ -189,12 +252,64 @@ struct __rb_tree_iterator : public __rb_tree_base_iterator {
     //会进入__rb_tree_base_iterator::decrement()的状况1
 };
 
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc = alloc>
+//整体集合运算(union_with等)丢弃的节点先以right串起来,运算结束后才由调用者线程释放:
+//平行执行时各线程各用一个串行,配置器因而不必是thread-safe的
+struct __rb_tree_chain {
+    typedef __rb_tree_node_base* base_ptr;
+    base_ptr head;
+    base_ptr tail;
+    size_t n;
+
+    __rb_tree_chain() : head(0), tail(0), n(0) {}
+    void push(base_ptr x)
+    {
+        x->right = 0;
+        if (tail)
+            tail->right = x;
+        else
+            head = x;
+        tail = x;
+        ++n;
+    }
+    //整棵子树: 左子树递归,右子树以循环处理
+    void push_tree(base_ptr x)
+    {
+        while (x != 0) {
+            push_tree(x->left);
+            base_ptr r = x->right;
+            push(x);
+            x = r;
+        }
+    }
+    void splice(__rb_tree_chain& c)
+    {
+        if (c.head == 0)
+            return;
+        if (tail)
+            tail->right = c.head;
+        else
+            head = c.head;
+        tail = c.tail;
+        n += c.n;
+        c.head = c.tail = 0;
+        c.n = 0;
+    }
+};
+
+//平行的整体集合运算中,两棵树合计至少这么多个元素才值得多开一个线程
+static const size_t __rb_tree_parallel_grain = 32768;
+//区间删除时,超过这么多个元素才改以split/join整段切下,否则逐一删除较快
+static const size_t __rb_tree_erase_grain = 16;
+
+//Augment为增强策略,缺省不维护任何额外资讯;顺序统计见os_map/os_set
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc = alloc,
+          class Augment = __rb_tree_no_augment>
 class rb_tree {
 protected:
     typedef void* void_pointer;
     typedef __rb_tree_node_base* base_ptr;
-    typedef __rb_tree_node<Value> rb_tree_node;
+    typedef typename Augment::node_base node_base;
+    typedef __rb_tree_node<Value, node_base> rb_tree_node;
     typedef simple_alloc<rb_tree_node, alloc> rb_tree_node_allocator;
     typedef __rb_tree_color_type color_type;
 public:
@@ -214,6 +329,7 @@ protected:
 
     link_type create_node(const value_type& x) { 
         link_type tmp = get_node(); //配置空间
+        tmp->tagged_parent = 0; //先为红色、没有父节点,之后才个别设定颜色与父节点
         __STL_TRY {
             construct(&tmp->value_field, x); //构造函数
         }
@@ -223,7 +339,7 @@ protected:
 
     link_type clone_node(link_type x) { //复制一个节点(的值和色)
         link_type tmp = create_node(x->value_field);
-        tmp->color = x->color;
+        tmp->set_color(x->color());
         tmp->left = 0;
         tmp->right = 0;
         return tmp;
@@ -240,24 +356,25 @@ protected:
     Compare key_compare;    //节点间的键值大小比较准则,应该会是function object
 
     //以下三个函数用来方便取得header的成员
-    link_type& root() const { return (link_type&) header->parent; }
+    //header恒为红色(0),它的tagged_parent就是root,可以直接当作指针栏位取用
+    link_type& root() const { return (link_type&) header->tagged_parent; }
     link_type& leftmost() const { return (link_type&) header->left; }
     link_type& rightmost() const { return (link_type&) header->right; }
 
     //以下六个函数用来方便取得节点x的成员
     static link_type& left(link_type x) { return (link_type&)(x->left); }
     static link_type& right(link_type x) { return (link_type&)(x->right); }
-    static link_type& parent(link_type x) { return (link_type&)(x->parent); }
+    static link_type parent(link_type x) { return (link_type) x->parent(); }
     static reference value(link_type x) { return (link_type&)(x->value_field); }
     static const Key& key(link_type x) { return KeyOfValue(value(x)); }
-    static color_type& color(link_type x) { return (color_type&)(x->color); }
+    static color_type color(link_type x) { return x->color(); }
 
     static link_type& left(base_ptr x) { return (link_type&)(x->left); }
     static link_type& right(base_ptr x) { return (link_type&)(x->right); }
-    static link_type& parent(base_ptr x) { return (link_type&)(x->parent); }
+    static link_type parent(base_ptr x) { return (link_type) x->parent(); }
     static reference value(base_ptr x) { return (link_type&)(x->value_field); }
     static const Key& key(base_ptr x) { return KeyOfValue(value(x)); }
-    static color_type& color(base_ptr x) { return (color_type&)(x->color); }
+    static color_type color(base_ptr x) { return x->color(); }
 
     static link_type minimum(link_type x) {
         return (link_type) __rb_tree_node_base::minimum(x);
@@ -267,19 +384,58 @@ protected:
     }
 
 public:
-    typedef __rb_tree_iterator<value_type, reference, pointer> iterator;
-    typedef __rb_tree_iterator<const value_type, const reference, const pointer> const_iterator;
+    typedef __rb_tree_iterator<value_type, reference, pointer, node_base> iterator;
+    typedef __rb_tree_iterator<value_type, const value_type&, const value_type*, node_base> const_iterator;
+
+    //节点把手(node handle): 拥有一个由extract()摘下、仍含着元素的节点.
+    //把它插回同型别的树只是重新挂上,不配置记忆体、不复制元素;把手解构时若仍拥有节点就释放它.
+    //没有move语意可用,复制即转移所有权(与auto_ptr相同),被复制的把手成为空把手
+    class node_type {
+        friend class rb_tree;
+    private:
+        mutable link_type ptr;
+        explicit node_type(link_type p) : ptr(p) {}
+    public:
+        node_type() : ptr(0) {}
+        node_type(const node_type& x) : ptr(x.ptr) { x.ptr = 0; }
+        node_type& operator=(const node_type& x)
+        {
+            if (this != &x) {
+                release();
+                ptr = x.ptr;
+                x.ptr = 0;
+            }
+            return *this;
+        }
+        ~node_type() { release(); }
+
+        bool empty() const { return ptr == 0; }
+        value_type& value() const { return ptr->value_field; }
+        //节点不在树中,可以修改键值后再插回(例如map的rekey),不必重新配置
+        Key& key() const { return const_cast<Key&>(KeyOfValue()(ptr->value_field)); }
+        void swap(node_type& x) { __STD::swap(ptr, x.ptr); }
+    private:
+        void release()
+        {
+            if (ptr) {
+                destory(&ptr->value_field);
+                rb_tree_node_allocator::deallocate(ptr);
+                ptr = 0;
+            }
+        }
+    };
 
 private:
     //真正执行插入操作的函数
     iterator __insert(base_ptr x, base_ptr y, const Value& v);
+    iterator __insert_node(base_ptr x, base_ptr y, link_type z);
+    bool __unique_pos(const Key& k, link_type& x, link_type& y);
     link_type __copy(link_type x, link_type p);
-    void __erase(link_type x);
+    size_type __erase(link_type x);
     void init() {
         header = get_node(); //产生一个节点空间,令header指向它
-        color(header) = __rb_tree_red; //令header为红色, 
+        root() = 0; //同时令header为红色(见__rb_tree_node_base), 
         //用来区分header和root(在iterator.operator++中)
-        root() = 0;
         leftmost() = header;  //令header的左子节点为自己
         rightmost() = header; //令header的右子节点为自己
 
@@ -292,13 +448,15 @@ public:
         : node_count(0), key_compare(comp) { init(); }
     ~rb_tree() { clear(); put_node(header); }
 
-    rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& operator=(
-        const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& x);
+    rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>& operator=(
+        const rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>& x);
 public:
     //accessors
     Compare key_comp() const { return key_compare; }
     iterator begin() { return leftmost(); } //RB树的起头最左(最小)节点处
+    const_iterator begin() const { return leftmost(); }
     iterator end() { return header; } //RB树的终点为header所指处
+    const_iterator end() const { return header; }
     bool empty() const { return node_count == 0; }
     size_type size() const { return node_count; }
     size_type max_size() const { return size_type(-1); }
@@ -308,113 +466,678 @@ public:
     pair<iterator, bool> insert_unique(const Value& x);
     //将x插入到RB-tree中(允许节点重复)
     iterator insert_equal(const Value& x);
+    //以position为提示: 若新值恰好应插在position之前(例如依序append时position为end()),
+    //只需与position及其前一个节点各比较一次,省去由根往下的查找,摊还O(1);提示不对则退回一般插入
+    iterator insert_unique(iterator position, const Value& x);
+    iterator insert_equal(iterator position, const Value& x);
+    //区间插入: 空树且输入已经有序时改以__build_sorted()在O(N)内建树,
+    //否则逐一以end()为提示插入(输入大致有序时每次仍为摊还O(1))
+    template <class InputIterator>
+    void insert_unique(InputIterator first, InputIterator last)
+    {
+        __insert_range(first, last, true, iterator_category(first));
+    }
+    template <class InputIterator>
+    void insert_equal(InputIterator first, InputIterator last)
+    {
+        __insert_range(first, last, false, iterator_category(first));
+    }
+    //调用者保证树为空,且[first, last)已依Compare排序(map/set还须不重复):
+    //直接在O(N)内建成平衡的RB-tree,不做任何键值比较,也不做任何旋转
+    template <class ForwardIterator>
+    void from_sorted(ForwardIterator first, ForwardIterator last)
+    {
+        __stl_assert(empty());
+        __build_sorted(first, __STD::distance(first, last)); //rb_tree::distance()遮蔽了全局版本
+    }
     //查找操作
-    iterator find(const Key& k);
+    iterator find(const Key& k) { return iterator(__find(k)); }
+    const_iterator find(const Key& k) const { return const_iterator(__find(k)); }
+    size_type count(const Key& k) const { return __count(k); }
+    //第一个不小于k的节点
+    iterator lower_bound(const Key& k) { return iterator(__lower_bound(k)); }
+    const_iterator lower_bound(const Key& k) const { return const_iterator(__lower_bound(k)); }
+    //第一个大于k的节点
+    iterator upper_bound(const Key& k) { return iterator(__upper_bound(k)); }
+    const_iterator upper_bound(const Key& k) const { return const_iterator(__upper_bound(k)); }
+    pair<iterator, iterator> equal_range(const Key& k) {
+        return pair<iterator, iterator>(lower_bound(k), upper_bound(k));
+    }
+    pair<const_iterator, const_iterator> equal_range(const Key& k) const {
+        return pair<const_iterator, const_iterator>(lower_bound(k), upper_bound(k));
+    }
+
+    //异质查找: Compare透明(如less<void>)时,可以用任何能与Key比较的型别查找,
+    //例如以const char*查找string键值,不必构造临时的Key
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    find(const K& k) { return iterator(__find(k)); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, size_type>::type
+    count(const K& k) const { return __count(k); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    lower_bound(const K& k) { return iterator(__lower_bound(k)); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, iterator>::type
+    upper_bound(const K& k) { return iterator(__upper_bound(k)); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, pair<iterator, iterator> >::type
+    equal_range(const K& k) {
+        return pair<iterator, iterator>(iterator(__lower_bound(k)), iterator(__upper_bound(k)));
+    }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, const_iterator>::type
+    find(const K& k) const { return const_iterator(__find(k)); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, const_iterator>::type
+    lower_bound(const K& k) const { return const_iterator(__lower_bound(k)); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, const_iterator>::type
+    upper_bound(const K& k) const { return const_iterator(__upper_bound(k)); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, pair<const_iterator, const_iterator> >::type
+    equal_range(const K& k) const {
+        return pair<const_iterator, const_iterator>(const_iterator(__lower_bound(k)),
+                                                    const_iterator(__upper_bound(k)));
+    }
+    //节点的摘下与插回: 在两棵树之间搬移元素、或修改键值,都不必销毁再重建节点
+    //摘下position所指节点(树中其他迭代器仍然有效)
+    node_type extract(iterator position)
+    {
+        base_ptr y = __rb_tree_rebalance_for_erase(position.node, header->tagged_parent,
+                                                   header->left, header->right, Augment());
+        --node_count;
+        return node_type((link_type) y);
+    }
+    //摘下键值为k的(第一个)节点,没有则返回空把手
+    node_type extract(const Key& k)
+    {
+        iterator i = find(k);
+        return i == end() ? node_type() : extract(i);
+    }
+    //插回nh所拥有的节点: 成功则nh成为空把手;键值重复时不插入,节点仍留在nh中,
+    //返回的迭代器指向树中键值相同的元素. nh为空时返回(end(), false)
+    pair<iterator, bool> insert_unique(node_type& nh);
+    iterator insert_equal(node_type& nh);
+    //把source的节点逐一搬进*this(键值重复者留在source中),不配置记忆体
+    void merge_unique(rb_tree& source);
+    void merge_equal(rb_tree& source);
+
     //删除操作
-    void erase(const iterator& x);
+    void erase(iterator position);
+    size_type erase(const Key& k);
+    void erase(iterator first, iterator last);
+    void clear()
+    {
+        if (node_count != 0) {
+            __erase(root());
+            leftmost() = header;
+            root() = 0;
+            rightmost() = header;
+            node_count = 0;
+        }
+    }
+    //删除键值落在[a, b)的全部元素,返回删除的个数. 以split切下整段、join接回两侧,
+    //O(log N + k)(k为删除个数),不必每删一个就rebalance一次. 重复的键值亦可. Compare不可抛出异常
+    size_type erase_range(const Key& a, const Key& b)
+    {
+        return key_compare(a, b) ? __erase_split(a, &b) : 0;
+    }
+    //删除pred(元素)为真的全部元素,返回删除的个数. 每个元素只判断一次,
+    //连续一段要删除的元素一次切下,不必每个都rebalance
+    template <class Predicate>
+    size_type erase_if(Predicate pred);
+
+    //顺序统计: 以下须以__rb_tree_size_augment为Augment(见os_map/os_set),皆为O(log N)
+    //第k小(由0起算)的元素;k >= size()时返回end()
+    iterator select(size_type k) { return iterator(__select(k)); }
+    const_iterator select(size_type k) const { return const_iterator(__select(k)); }
+    //position之前的元素个数(position为end()时即size())
+    size_type index(const_iterator position) const;
+    //小于k的元素个数,亦即lower_bound(k)的index
+    size_type rank(const Key& k) const { return __rank(k); }
+    template <class K>
+    typename __enable_if_transparent<Compare, K, size_type>::type
+    rank(const K& k) const { return __rank(k); }
+    //[first, last)的元素个数,不必逐一走过
+    difference_type distance(const_iterator first, const_iterator last) const
+    {
+        return difference_type(index(last)) - difference_type(index(first));
+    }
+    //键值落在[a, b)的元素个数,不必逐一走过
+    size_type count_range(const Key& a, const Key& b) const
+    {
+        return key_compare(a, b) ? __rank(b) - __rank(a) : 0;
+    }
+
+    /*
+     * 以join/split实现的整体集合运算(仅适用于键值不重复的树,即set/map).
+     * x的节点直接搬进*this或被释放,不配置记忆体、不复制元素,结束后x为空树.
+     * 以*this的根为轴切开x,两侧分别递归,再join回去: 设m、n为较小与较大的一方,
+     * 复杂度O(m log(n/m + 1)),把小集合并入大集合只需O(m log n),而非set_union的O(m + n).
+     * 两个子问题互不相干,可以平行: threads为1(缺省)时单线程,为0时使用全部硬件线程.
+     * 元素相同时保留*this的(与insert_unique相同). Compare不可抛出异常,平行时还须能同时呼叫
+     */
+    void union_with(rb_tree& x, size_type threads = 1) { __set_op_with(__op_union, x, threads); }
+    //只留下键值也在x中的元素
+    void intersect_with(rb_tree& x, size_type threads = 1) { __set_op_with(__op_intersection, x, threads); }
+    //去掉键值在x中的元素
+    void difference_with(rb_tree& x, size_type threads = 1) { __set_op_with(__op_difference, x, threads); }
+    //把键值不小于k的元素移到right(right必须为空). 重复的键值亦可.
+    //切开本身O(log N);维护了子树大小(如os_set)时两侧的元素个数直接读出,
+    //否则还要数出较小的一侧,另加O(min(|l|, |r|)),见__left_count()
+    void split(const Key& k, rb_tree& right);
+    //把right的元素全部接在*this之后,right成为空树. 调用者保证right的元素都不排在*this的之前. O(log N)
+    void join(rb_tree& right);
+private:
+    enum __set_op_type { __op_union, __op_intersection, __op_difference };
+    struct __set_op_task;
+    void __set_op_with(__set_op_type op, rb_tree& x, size_type threads);
+    base_ptr __set_op(__set_op_type op, base_ptr a, size_type ha, base_ptr b, size_type hb,
+                      size_type& h, __rb_tree_chain& g, size_type par_depth) const;
+    base_ptr __split(base_ptr x, size_type hx, const Key& k, bool unique,
+                     base_ptr& l, size_type& hl, base_ptr& r, size_type& hr) const;
+    size_type __erase_split(const Key& a, const Key* b);
+    //x之前的元素键值都小于x的键值(x为begin()或end()时亦然): 由此切开不会拆散重复的键值
+    bool __key_boundary(iterator x) const
+    {
+        if (x.node == header || x.node == leftmost())
+            return true;
+        iterator y = x;
+        --y;
+        return key_compare(key(y.node), key(x.node));
+    }
+    //以r为新的树形(r可为0),node_count改为n
+    void __reset_root(base_ptr r, size_type n)
+    {
+        root() = (link_type) r;
+        if (r) {
+            r->set_parent(header);
+            r->set_color(__rb_tree_black);
+            leftmost() = minimum((link_type) r);
+            rightmost() = maximum((link_type) r);
+        } else {
+            leftmost() = header;
+            rightmost() = header;
+        }
+        node_count = n;
+    }
+    //split之后l、r合计n个节点,求l的节点数: 维护了子树大小就直接读出;
+    //否则两边交替以加倍的上限计数,较小的一边数完即止,O(min(|l|, |r|))
+    size_type __left_count(base_ptr l, base_ptr, size_type, __rb_tree_size_augment) const
+    {
+        return __rb_tree_size_augment::size(l);
+    }
+    template <class A>
+    size_type __left_count(base_ptr l, base_ptr r, size_type n, A) const
+    {
+        for (size_type cap = 16; ; cap *= 2) {
+            size_type c = 0;
+            __count_upto(l, cap, c);
+            if (c < cap)
+                return c;
+            c = 0;
+            __count_upto(r, cap, c);
+            if (c < cap)
+                return n - c;
+        }
+    }
+    static void __count_upto(base_ptr x, size_type cap, size_type& c)
+    {
+        for (; x != 0 && c < cap; x = x->right) {
+            __count_upto(x->left, cap, c);
+            if (c < cap)
+                ++c;
+        }
+    }
+    link_type __select(size_type k) const;
+    template <class K> size_type __rank(const K& k) const;
+
+    //以下查找函数以模板实现,供一般版本与异质版本共用
+    template <class K> link_type __lower_bound(const K& k) const;
+    template <class K> link_type __upper_bound(const K& k) const;
+    template <class K> link_type __find(const K& k) const;
+    template <class K> size_type __count(const K& k) const;
+
+    template <class InputIterator>
+    void __insert_range(InputIterator first, InputIterator last, bool unique, input_iterator_tag)
+    {
+        for (; first != last; ++first)
+            if (unique)
+                insert_unique(end(), *first);
+            else
+                insert_equal(end(), *first);
+    }
+    //前向迭代器可以先走一遍检查是否有序,有序才线性建树
+    template <class ForwardIterator>
+    void __insert_range(ForwardIterator first, ForwardIterator last, bool unique, forward_iterator_tag)
+    {
+        size_type n;
+        if (empty() && __sorted_length(first, last, unique, n))
+            __build_sorted(first, n);
+        else
+            __insert_range(first, last, unique, input_iterator_tag());
+    }
+    //[first, last)是否有序(unique时还须严格递增);是则以n返回其长度. 最多比较N - 1次
+    template <class ForwardIterator>
+    bool __sorted_length(ForwardIterator first, ForwardIterator last, bool unique, size_type& n) const
+    {
+        n = 0;
+        if (first == last)
+            return true;
+        ForwardIterator prev = first;
+        for (n = 1; ++first != last; prev = first, ++n) {
+            if (key_compare(KeyOfValue()(*first), KeyOfValue()(*prev)))
+                return false;
+            if (unique && !key_compare(KeyOfValue()(*prev), KeyOfValue()(*first)))
+                return false;
+        }
+        return true;
+    }
+    template <class ForwardIterator>
+    void __build_sorted(ForwardIterator first, size_type n);
+    link_type __link_sorted(link_type& list, size_type n, size_type depth, size_type red_depth);
 };
 
 //全局函数: 新节点必为红节点, 如果插入处之父节点亦为红节点,就违反红黑树规则
 //此时必须做树形旋转(及颜色改变,在程序它处)
+//旋转后x成为y的子节点,增强资讯须先重算x再重算y
+template <class Augment>
 inline void
-__rb_tree_rotate_left(__rb_tree_node_base* x, __rb_tree_node_base*& root)
+__rb_tree_rotate_left(__rb_tree_node_base* x, __rb_tree_node_base*& root, Augment)
 {
     //x为旋转点
     __rb_tree_node_base* y = x->right; //令y为旋转点的右子节点
     x->right = y->left;
     if (y->left != 0)
-        y->left->parent = x; //别忘了回马枪设定父节点
-    y->parent = x->parent;
+        y->left->set_parent(x); //别忘了回马枪设定父节点
+    y->set_parent(x->parent());
 
     //令y完全顶替x地位(必须将x对应父节点的关系完全接过来)
     if (x == root) //x为根节点
         root = y;
-    else if (x == x->parent->left) //x为其父节点的左子节点
-        x->parent->left = y;
+    else if (x == x->parent()->left) //x为其父节点的左子节点
+        x->parent()->left = y;
     else
-        x->parent->right = y;
+        x->parent()->right = y;
     y->left = x;
-    x->parent = y;
+    x->set_parent(y);
+    Augment::update(x);
+    Augment::update(y);
 }
 
 //全局函数: 新节点必为红节点,如果插入处之父节点亦为红节点,就违反红黑树规则,此时必须
 //做树形旋转(及颜色改变,在程序其他处)
+template <class Augment>
 inline void 
-__rb_tree_rotate_right(__rb_tree_node_base* x, __rb_tree_node_base*& root)
+__rb_tree_rotate_right(__rb_tree_node_base* x, __rb_tree_node_base*& root, Augment)
 {
     //x为旋转点
     __rb_tree_node_base* y = x->left; //y为旋转点的左子节点
     x->left = y->right;
     if (y->right != 0)
-        y->right->parent = x; //别忘了回马枪设定父节点
-    y->parent = x->parent;
+        y->right->set_parent(x); //别忘了回马枪设定父节点
+    y->set_parent(x->parent());
 
     //令y完全顶替x的地位(必须将x对其父节点的关系完全接收过来)
     if (x == root)
         root = y;
-    else if (x == x->parent->right) //x为其父节点的右子节点
-        x->parent->right = y;
+    else if (x == x->parent()->right) //x为其父节点的右子节点
+        x->parent()->right = y;
     else //x为其父节点的左子节点
-        x->parent->left = y;
+        x->parent()->left = y;
     y->right = x;
-    x->parent = y;
-}
-
-//全局函数: 重新令树形平衡(改变颜色及旋转树形)
-//参数一: 新增节点, 参数二: root
-inline void __rb_tree_rebalance(__rb_tree_node_base* x, __rb_tree_node_base*& root)
-{
-    x->color = __rb_tree_red; //新节点必为红
-    while (x != root && x->parent->color == __rb_tree_red) { //父节点为红
-        if (x->parent == x->parent->parent->left) { //父节点为祖父节点之左子节点
-            __rb_tree_node_base* y = x->parent->parent->right; //令y为伯父节点
-            if (y && y->color == __rb_tree_red) { //伯父节点存在,且为红
-                x->parent->color = __rb_tree_black; //更改父节点为黑
-                y->color = __rb_tree_black; //更改伯父节点为黑
-                x->parent->parent->color = __rb_tree_red; //更改祖父节点为红
-                x = x->parent->parent;
+    x->set_parent(y);
+    Augment::update(x);
+    Augment::update(y);
+}
+
+//全局函数: x为红节点且其左右子树合法(黑高度相同),修正x与父节点连续为红的情形(改变颜色及旋转树形).
+//新增节点与join接上的节点都以它恢复平衡. 返回根节点是否由红改黑: 若是,整棵树的黑高度加1
+template <class Augment>
+inline bool __rb_tree_fix_red(__rb_tree_node_base* x, __rb_tree_node_base*& root, Augment a)
+{
+    while (x != root && x->parent()->color() == __rb_tree_red) { //父节点为红
+        if (x->parent() == x->parent()->parent()->left) { //父节点为祖父节点之左子节点
+            __rb_tree_node_base* y = x->parent()->parent()->right; //令y为伯父节点
+            if (y && y->color() == __rb_tree_red) { //伯父节点存在,且为红
+                x->parent()->set_color(__rb_tree_black); //更改父节点为黑
+                y->set_color(__rb_tree_black); //更改伯父节点为黑
+                x->parent()->parent()->set_color(__rb_tree_red); //更改祖父节点为红
+                x = x->parent()->parent();
             } else { //无伯父节点或者伯父节点为黑
-                if (x == x->parent->right) { //如果新节点为父节点之右子节点
-                    x = x->parent;
-                    __rb_tree_rotate_left(x, root); //第一参数为左旋点
+                if (x == x->parent()->right) { //如果新节点为父节点之右子节点
+                    x = x->parent();
+                    __rb_tree_rotate_left(x, root, a); //第一参数为左旋点
                 }
-                x->parent->color = __rb_tree_black; //改变颜色
-                x->parent->parent->color = __rb_tree_red;
-                __rb_tree_rotate_right(x->parent->parent, root); //第一参数为右旋点
+                x->parent()->set_color(__rb_tree_black); //改变颜色
+                x->parent()->parent()->set_color(__rb_tree_red);
+                __rb_tree_rotate_right(x->parent()->parent(), root, a); //第一参数为右旋点
             }
         } else { //父节点为祖父节点之右子节点
-            __rb_tree_node_base* y = x->parent->parent->left; //令y为伯父节点
-            if (y && y->color == __rb_tree_red) { //有伯父节点,且为红
-                x->parent->color = __rb_tree_red; //更改父节点为黑
-                y->color = __rb_tree_black;       //更改伯父节点为黑
-                x->parent->parent->color = __rb_tree_red; //更改祖父节点为红
-                x = x->parent->parent; //准备继续往上层检查
+            __rb_tree_node_base* y = x->parent()->parent()->left; //令y为伯父节点
+            if (y && y->color() == __rb_tree_red) { //有伯父节点,且为红
+                x->parent()->set_color(__rb_tree_black); //更改父节点为黑
+                y->set_color(__rb_tree_black);       //更改伯父节点为黑
+                x->parent()->parent()->set_color(__rb_tree_red); //更改祖父节点为红
+                x = x->parent()->parent(); //准备继续往上层检查
             } else { //无伯父节点, 或伯父节点为黑
-                if (x == x->parent->left) { //如果新节点为父节点之左节点
-                    x = x->parent;
-                    __rb_tree_rotate_right(x, root); //第一参数为右旋节点
+                if (x == x->parent()->left) { //如果新节点为父节点之左节点
+                    x = x->parent();
+                    __rb_tree_rotate_right(x, root, a); //第一参数为右旋节点
                 }
-                x->parent->color = __rb_tree_black; //改变颜色
-                x->parent->parent->color = __rb_tree_red;
-                __rb_tree_rotate_right(x->parent->parent, root); //第一参数为左旋点
+                x->parent()->set_color(__rb_tree_black); //改变颜色
+                x->parent()->parent()->set_color(__rb_tree_red);
+                __rb_tree_rotate_left(x->parent()->parent(), root, a); //第一参数为左旋点
             }
         }
     } //while结束
-    root->color = __rb_tree_black; //根节点永远为黑
+    bool grown = root->color() == __rb_tree_red;
+    root->set_color(__rb_tree_black); //根节点永远为黑
+    return grown;
 }
 
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-inline typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::iterator
-rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__insert(base_ptr x_, base_ptr y_, const Value &v)
+//全局函数: 重新令树形平衡
+//参数一: 新增节点, 参数二: root, 参数三: 增强策略
+template <class Augment>
+inline void __rb_tree_rebalance(__rb_tree_node_base* x, __rb_tree_node_base*& root, Augment a)
 {
-    //参数x_为新值插入点, 参数y_为插入点之父节点, 参数v为新值
+    Augment::insert_path(x, root); //旋转之前先把新节点计入路径上的增强资讯
+    x->set_color(__rb_tree_red); //新节点必为红
+    __rb_tree_fix_red(x, root, a);
+}
+
+/*
+ * 全局函数: 把z由树中摘除并恢复平衡,返回实际要释放的节点(即z)
+ * z有两个子节点时,以其后继y(右子树的最左节点)顶替z的位置与颜色,问题转成删除y原来的位置;
+ * 被移走的位置若为黑,经过它的路径少了一个黑节点,由x(顶上来的子节点,可能为NULL)往上修补:
+ *   兄弟w为红: 旋转使w变黑,转成以下情形
+ *   w的两个子节点皆黑: w改红,问题上移到父节点
+ *   w的远侧子节点为红(必要时先对w旋转,把近侧的红子节点转到远侧): 对父节点旋转后即告完成
+ * 增强资讯在摘除后、修补旋转前,由x的父节点往上重算到root
+ */
+template <class Augment>
+inline __rb_tree_node_base*
+__rb_tree_rebalance_for_erase(__rb_tree_node_base* z, __rb_tree_node_base*& root,
+                              __rb_tree_node_base*& leftmost, __rb_tree_node_base*& rightmost,
+                              Augment a)
+{
+    __rb_tree_node_base* y = z;
+    __rb_tree_node_base* x = 0;
+    __rb_tree_node_base* x_parent = 0;
+    if (y->left == 0)       //z至多有一个子节点, y == z
+        x = y->right;       //x可能为NULL
+    else if (y->right == 0) //z恰有一个子节点, y == z
+        x = y->left;
+    else {                  //z有两个子节点,令y为z的后继, x可能为NULL
+        y = y->right;
+        while (y->left != 0)
+            y = y->left;
+        x = y->right;
+    }
+    if (y != z) { //以y顶替z
+        z->left->set_parent(y);
+        y->left = z->left;
+        if (y != z->right) {
+            x_parent = y->parent();
+            if (x)
+                x->set_parent(y->parent());
+            y->parent()->left = x; //y必为左子节点
+            y->right = z->right;
+            z->right->set_parent(y);
+        } else
+            x_parent = y;
+        if (root == z)
+            root = y;
+        else if (z->parent()->left == z)
+            z->parent()->left = y;
+        else
+            z->parent()->right = y;
+        y->set_parent(z->parent());
+        const __rb_tree_color_type c = y->color();
+        y->set_color(z->color());
+        z->set_color(c);
+        y = z; //y此后指向实际要删除的节点
+    } else { //y == z
+        x_parent = y->parent();
+        if (x)
+            x->set_parent(y->parent());
+        if (root == z)
+            root = x;
+        else if (z->parent()->left == z)
+            z->parent()->left = x;
+        else
+            z->parent()->right = x;
+        if (leftmost == z) {
+            if (z->right == 0) //此时z->left亦为0
+                leftmost = z->parent(); //z为root时leftmost即成为header
+            else
+                leftmost = __rb_tree_node_base::minimum(x);
+        }
+        if (rightmost == z) {
+            if (z->left == 0) //此时z->right亦为0
+                rightmost = z->parent();
+            else //x == z->left
+                rightmost = __rb_tree_node_base::maximum(x);
+        }
+    }
+    Augment::erase_path(x_parent, root);
+
+    if (y->color() != __rb_tree_red) { //移走的是黑节点,必须修补
+        while (x != root && (x == 0 || x->color() == __rb_tree_black))
+            if (x == x_parent->left) {
+                __rb_tree_node_base* w = x_parent->right; //兄弟节点
+                if (w->color() == __rb_tree_red) {
+                    w->set_color(__rb_tree_black);
+                    x_parent->set_color(__rb_tree_red);
+                    __rb_tree_rotate_left(x_parent, root, a);
+                    w = x_parent->right;
+                }
+                if ((w->left == 0 || w->left->color() == __rb_tree_black) &&
+                    (w->right == 0 || w->right->color() == __rb_tree_black)) {
+                    w->set_color(__rb_tree_red);
+                    x = x_parent;
+                    x_parent = x_parent->parent();
+                } else {
+                    if (w->right == 0 || w->right->color() == __rb_tree_black) {
+                        w->left->set_color(__rb_tree_black);
+                        w->set_color(__rb_tree_red);
+                        __rb_tree_rotate_right(w, root, a);
+                        w = x_parent->right;
+                    }
+                    w->set_color(x_parent->color());
+                    x_parent->set_color(__rb_tree_black);
+                    if (w->right)
+                        w->right->set_color(__rb_tree_black);
+                    __rb_tree_rotate_left(x_parent, root, a);
+                    break;
+                }
+            } else { //与上面相同,左右互换
+                __rb_tree_node_base* w = x_parent->left;
+                if (w->color() == __rb_tree_red) {
+                    w->set_color(__rb_tree_black);
+                    x_parent->set_color(__rb_tree_red);
+                    __rb_tree_rotate_right(x_parent, root, a);
+                    w = x_parent->left;
+                }
+                if ((w->right == 0 || w->right->color() == __rb_tree_black) &&
+                    (w->left == 0 || w->left->color() == __rb_tree_black)) {
+                    w->set_color(__rb_tree_red);
+                    x = x_parent;
+                    x_parent = x_parent->parent();
+                } else {
+                    if (w->left == 0 || w->left->color() == __rb_tree_black) {
+                        w->right->set_color(__rb_tree_black);
+                        w->set_color(__rb_tree_red);
+                        __rb_tree_rotate_left(w, root, a);
+                        w = x_parent->left;
+                    }
+                    w->set_color(x_parent->color());
+                    x_parent->set_color(__rb_tree_black);
+                    if (w->left)
+                        w->left->set_color(__rb_tree_black);
+                    __rb_tree_rotate_right(x_parent, root, a);
+                    break;
+                }
+            }
+        if (x)
+            x->set_color(__rb_tree_black);
+    }
+    return y;
+}
+
+/*
+ * join与split: 整体集合运算的基本操作
+ * 黑高度(black height)指由某节点(含)到NULL的路径上黑节点的个数,NULL为0.
+ *
+ * join(l, k, r): l的元素都排在k之前,r的都排在k之后,以k把两棵树接成一棵.
+ *   两者黑高度相同时k就是新根;否则沿较高者的右(左)脊往下,找到与较矮者黑高度相同的黑节点c,
+ *   把涂红的k放在c的位置(c与较矮者成为k的两个子节点),再以__rb_tree_fix_red()往上修正.
+ *   复杂度O(|hl - hr| + 1). 各函数都把黑高度当作参数传递,不必每次由根往下数.
+ * split: 见rb_tree::__split(),沿查找路径切开,把路径两侧的子树依次join起来,总共O(log N)
+ */
+
+//全局函数: 由x沿左脊往下计算黑高度,O(log N),只在整体操作开始时用一次
+inline size_t __rb_tree_black_height(__rb_tree_node_base* x)
+{
+    size_t h = 0;
+    for (; x != 0; x = x->left)
+        if (x->color() == __rb_tree_black)
+            ++h;
+    return h;
+}
+
+//全局函数: 以k接合l(黑高度hl)与r(黑高度hr),返回新根,新的黑高度由h返回.
+//结果的根为黑,其parent为0
+template <class Augment>
+__rb_tree_node_base*
+__rb_tree_join(__rb_tree_node_base* l, size_t hl, __rb_tree_node_base* k,
+               __rb_tree_node_base* r, size_t hr, size_t& h, Augment a)
+{
+    //把根涂黑不违反任何规则,只是黑高度加1
+    if (l) {
+        l->set_parent(0);
+        if (l->color() == __rb_tree_red) {
+            l->set_color(__rb_tree_black);
+            ++hl;
+        }
+    }
+    if (r) {
+        r->set_parent(0);
+        if (r->color() == __rb_tree_red) {
+            r->set_color(__rb_tree_black);
+            ++hr;
+        }
+    }
+    if (hl == hr) {
+        k->set_parent(0);
+        k->left = l;
+        k->right = r;
+        if (l)
+            l->set_parent(k);
+        if (r)
+            r->set_parent(k);
+        k->set_color(__rb_tree_black);
+        Augment::update(k);
+        h = hl + 1;
+        return k;
+    }
+
+    __rb_tree_node_base* root;
+    __rb_tree_node_base* p = 0;
+    __rb_tree_node_base* c;
+    if (hl > hr) { //沿l的右脊往下,c的黑高度为hc
+        root = c = l;
+        for (size_t hc = hl; hc != hr || (c != 0 && c->color() == __rb_tree_red); c = c->right) {
+            if (c->color() == __rb_tree_black)
+                --hc;
+            p = c;
+        }
+        k->left = c;
+        k->right = r;
+        p->right = k;
+    } else { //对称: 沿r的左脊往下
+        root = c = r;
+        for (size_t hc = hr; hc != hl || (c != 0 && c->color() == __rb_tree_red); c = c->left) {
+            if (c->color() == __rb_tree_black)
+                --hc;
+            p = c;
+        }
+        k->left = l;
+        k->right = c;
+        p->left = k;
+    }
+    k->set_parent(p);
+    if (k->left)
+        k->left->set_parent(k);
+    if (k->right)
+        k->right->set_parent(k);
+    k->set_color(__rb_tree_red);
+    for (__rb_tree_node_base* x = k; x != 0; x = x->parent())
+        Augment::update(x);
+    h = (hl > hr ? hl : hr) + __rb_tree_fix_red(k, root, a);
+    return root;
+}
+
+//全局函数: 由x(黑高度hx)中摘下最右节点m,返回其余节点组成的树,其黑高度由h返回
+template <class Augment>
+__rb_tree_node_base*
+__rb_tree_split_last(__rb_tree_node_base* x, size_t hx, __rb_tree_node_base*& m, size_t& h, Augment a)
+{
+    const size_t hc = hx - (x->color() == __rb_tree_black);
+    if (x->right == 0) {
+        m = x;
+        h = hc;
+        return x->left;
+    }
+    size_t hr;
+    __rb_tree_node_base* rest = __rb_tree_split_last(x->right, hc, m, hr, a);
+    return __rb_tree_join(x->left, hc, x, rest, hr, h, a);
+}
+
+//全局函数: 没有中间节点的join,借用l的最右节点当作k
+template <class Augment>
+__rb_tree_node_base*
+__rb_tree_join2(__rb_tree_node_base* l, size_t hl, __rb_tree_node_base* r, size_t hr,
+                size_t& h, Augment a)
+{
+    if (l == 0) {
+        h = hr;
+        return r;
+    }
+    if (r == 0) {
+        h = hl;
+        return l;
+    }
+    __rb_tree_node_base* m;
+    size_t hm;
+    l = __rb_tree_split_last(l, hl, m, hm, a);
+    return __rb_tree_join(l, hm, m, r, hr, h, a);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+inline typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::iterator
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::__insert(base_ptr x_, base_ptr y_, const Value &v)
+{
+    link_type z = create_node(v); //产生一个新节点
+    __STL_TRY {
+        return __insert_node(x_, y_, z);
+    }
+    __STL_UNWIND(destory_node(z)); //只有key_compare可能抛出异常,此时z尚未挂上
+}
+
+//把节点z挂上树并rebalance: 新建的节点与node handle插回的节点共用
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::iterator
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::__insert_node(base_ptr x_, base_ptr y_, link_type z)
+{
+    //参数x_为新值插入点, 参数y_为插入点之父节点, 参数z为新节点
     link_type x = (link_type) x_; //maybe root
     link_type y = (link_type) y_; //maybe head 
-    link_type z;
 
     //key_compare键值大小比较准则(function object)
-    if (y == header || x || key_compare(KeyOfValue()(v), key(y))) {
-        z = create_node(v); //产生一个新节点
+    if (y == header || x || key_compare(key(z), key(y))) {
         left(y) = z; //这使得y即为header时, leftmost() = z
         if (y == header) {
             root() = z;
@@ -422,24 +1145,23 @@ rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__insert(base_ptr x_, base_ptr
         } else if (y == leftmost()) //如果y为最左节点
             leftmost() = z; //维护leftmost(),使它永远指向最左节点
     } else {
-        z = create_node(v); //产生一个新节点
         right(y) = z; //令新节点成为插入点之父节点y的右子节点
         if (y == rightmost())
             rightmost() = z; //维护rightmost(),使它永远指向最右节点
     }
-    parent(z) = y; //设定新节点的父节点
+    z->set_parent(y); //设定新节点的父节点
     left(z) = 0;   //设定新节点的左子节点
     right(z) = 0;  //设定新节点的右子节点
     //新节点的颜色将在__rb_tree_reblance()设定(并调整)
-    __rb_tree_rebalance(z, header->parent); //参数一为新增节点, 参数二为root
+    __rb_tree_rebalance(z, header->tagged_parent, Augment()); //参数一为新增节点, 参数二为root
     ++node_count; //节点数累加
     return iterator(z); //返回迭代器,指向新增节点
 }
 
 //插入新值, 节点值允许重复, 返回值是一个RB-tree迭代器,指向新增节点
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::iterator
-rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::insert_equal(const Value& v)
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::iterator
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::insert_equal(const Value& v)
 {
     link_type y = header;
     link_type x = root();
@@ -455,16 +1177,30 @@ rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::insert_equal(const Value& v)
 //插入新值: 节点值不允许重复,若重复则插入无效
 //注意: 返回值是个pair,第一个是个RB-tree迭代器,指向新增节点
 //第二叉元素表示插入成功与否
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-pair<typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::iterator, bool>
-rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::insert_unique(const Value& v)
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+pair<typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::iterator, bool>
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::insert_unique(const Value& v)
 {
-    link_type y = header;
-    link_type x = root(); //从根节点开始
+    link_type x, y;
+    if (__unique_pos(KeyOfValue()(v), x, y))
+        return pair<iterator, bool>(__insert(x, y, v), true);
+        //以上x为新值插入点,y为插入点之父节点,v为新值
+    //表示新值一定与树中键值重复,那么就不应该插入新值
+    return pair<iterator, bool>(iterator(y), false);
+}
+
+//insert_unique()的查找部分: 可以插入时返回true, x为插入点, y为插入点之父节点;
+//键值与树中重复时返回false, y为键值相同的那个节点
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+bool rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::__unique_pos(const Key& k,
+                                                                            link_type& x, link_type& y)
+{
+    y = header;
+    x = root(); //从根节点开始
     bool comp = true;
     while (x != 0) { //从根节点开始,往下寻找适当的插入点
         y = x;
-        comp = key_compare(KeyOfValue()(v), key(x)); //v键值小于目前节点之键值?
+        comp = key_compare(k, key(x)); //k小于目前节点之键值?
         x = comp ? left(x) : right(x); //遇大于则往左,遇小于等于则往右
     }
     //离开循环后y即为插入点之父节点(此时它必为叶节点)
@@ -472,32 +1208,574 @@ rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::insert_unique(const Value& v)
     iterator j = iterator(y); //令迭代器j指向插入点之父节点y
     if (comp) //如果离开while循环时comp为真(表示遇大,将插入于左侧)
         if (j == begin()) //如果插入点之父节点为最左节点
-            return pair<iterator, bool>(__insert(x, y, v), true);
-            //以上x为插入点,y为插入点之父节点,v为新值
+            return true;
         else //否则(插入点之父节点不为最左节点)
             --j; //调整j,回头准备测试...
-    if (key_compare(key(j.node), KeyOfValue()(v))) //小于新值(表示遇到小值,将插入于右侧)
-        return pair<iterator, bool>(__insert(x, y, v), true);
-        //以上x为新值插入点,y为插入点之父节点,v为新值
-    
-    //进行至此,表示新值一定与树中键值重复,那么就不应该插入新值
-    return pair<iterator, bool>(j, false);
+    if (key_compare(key(j.node), k)) //小于新值(表示遇到小值,将插入于右侧)
+        return true;
+
+    //进行至此,表示新值一定与树中键值重复
+    y = (link_type) j.node;
+    return false;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+pair<typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::iterator, bool>
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::insert_unique(node_type& nh)
+{
+    if (nh.empty())
+        return pair<iterator, bool>(end(), false);
+    link_type x, y;
+    if (!__unique_pos(key(nh.ptr), x, y))
+        return pair<iterator, bool>(iterator(y), false);
+    link_type z = nh.ptr;
+    nh.ptr = 0;
+    return pair<iterator, bool>(__insert_node(x, y, z), true);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::iterator
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::insert_equal(node_type& nh)
+{
+    if (nh.empty())
+        return end();
+    link_type y = header;
+    link_type x = root();
+    while (x != 0) { //与insert_equal(const Value&)相同
+        y = x;
+        x = key_compare(key(nh.ptr), key(x)) ? left(x) : right(x);
+    }
+    link_type z = nh.ptr;
+    nh.ptr = 0;
+    return __insert_node(x, y, z);
+}
+
+//先为节点找好插入点,可以插入才由source摘下,所以键值重复的节点原封不动留在source中
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::merge_unique(rb_tree& source)
+{
+    if (&source == this)
+        return;
+    iterator i = source.begin();
+    while (i != source.end()) {
+        link_type z = (link_type) i.node;
+        ++i; //先前进,z摘下后i仍然有效
+        link_type x, y;
+        if (__unique_pos(key(z), x, y)) {
+            __rb_tree_rebalance_for_erase(z, source.header->tagged_parent, source.header->left,
+                                          source.header->right, Augment());
+            --source.node_count;
+            __insert_node(x, y, z);
+        }
+    }
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::merge_equal(rb_tree& source)
+{
+    if (&source == this)
+        return;
+    while (!source.empty()) {
+        node_type nh = source.extract(source.begin());
+        insert_equal(nh);
+    }
+}
+
+//带提示的插入: 新值应落在position的前一个节点before与position之间时,直接挂上去
+//before没有右子节点就成为它的右子节点,否则position必是before右子树的最左节点(没有左子节点),
+//就成为position的左子节点. 两种情形都只需一次__insert()(其rebalance摊还O(1))
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::iterator
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::insert_unique(iterator position, const Value& v)
+{
+    if (position.node == header->left) { //begin()
+        if (size() > 0 && key_compare(KeyOfValue()(v), key(position.node)))
+            return __insert(position.node, position.node, v); //第一参数非0,表示挂在左侧
+        return insert_unique(v).first;
+    }
+    if (position.node == header) { //end(): 依序append的情形
+        if (key_compare(key(rightmost()), KeyOfValue()(v)))
+            return __insert(0, rightmost(), v);
+        return insert_unique(v).first;
+    }
+    iterator before = position;
+    --before;
+    if (key_compare(key(before.node), KeyOfValue()(v)) &&
+        key_compare(KeyOfValue()(v), key(position.node))) {
+        if (right(before.node) == 0)
+            return __insert(0, before.node, v);
+        return __insert(position.node, position.node, v);
+    }
+    return insert_unique(v).first;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::iterator
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::insert_equal(iterator position, const Value& v)
+{
+    if (position.node == header->left) { //begin()
+        if (size() > 0 && !key_compare(key(position.node), KeyOfValue()(v)))
+            return __insert(position.node, position.node, v);
+        return insert_equal(v);
+    }
+    if (position.node == header) { //end()
+        if (!key_compare(KeyOfValue()(v), key(rightmost())))
+            return __insert(0, rightmost(), v);
+        return insert_equal(v);
+    }
+    iterator before = position;
+    --before;
+    if (!key_compare(KeyOfValue()(v), key(before.node)) &&
+        !key_compare(key(position.node), KeyOfValue()(v))) {
+        if (right(before.node) == 0)
+            return __insert(0, before.node, v);
+        return __insert(position.node, position.node, v);
+    }
+    return insert_equal(v);
+}
+
+/*
+ * 由有序输入线性建树
+ * 以中点为根递归地切分,左右子树的大小至多差1,于是深度小于 h = floor(log2(n + 1)) 的各层全满,
+ * 只有最后一层(深度h)可能不满. 把深度h的节点涂红、其余涂黑:
+ * 每条由根到NULL的路径都恰好经过h个黑节点,红节点的父节点必为黑,完全符合RB-tree规则.
+ *
+ * 先依序产生全部n个节点,暂以right串成串行(此阶段失败则逐一释放,树保持为空),
+ * 再以__link_sorted()中序地把它们接成树: 第二阶段不配置记忆体、不比较、不旋转,不会失败.
+ */
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+template <class ForwardIterator>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::__build_sorted(ForwardIterator first, size_type n)
+{
+    if (n == 0)
+        return;
+    link_type list = 0;
+    link_type tail = 0;
+    __STL_TRY {
+        for (size_type i = 0; i < n; ++i, ++first) {
+            link_type z = create_node(*first);
+            right(z) = 0;
+            if (tail)
+                right(tail) = z;
+            else
+                list = z;
+            tail = z;
+        }
+    }
+    __STL_UNWIND(while (list) { link_type next = right(list); destory_node(list); list = next; });
+
+    size_type red_depth = 0; //floor(log2(n + 1))
+    for (size_type m = n + 1; m > 1; m >>= 1)
+        ++red_depth;
+    link_type r = __link_sorted(list, n, 0, red_depth);
+    root() = r;
+    r->set_parent(header);
+    leftmost() = minimum(r);
+    rightmost() = maximum(r);
+    node_count = n;
+}
+
+//取用list前端的n个节点,中序地组成一棵子树并返回其根;depth为子树根的深度
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::link_type
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::__link_sorted(link_type& list, size_type n,
+                                                              size_type depth, size_type red_depth)
+{
+    if (n == 0)
+        return 0;
+    const size_type left_n = (n - 1) / 2;
+    link_type l = __link_sorted(list, left_n, depth + 1, red_depth);
+    link_type x = list;
+    list = right(list); //先取下一个,x的right稍后才设定
+    x->set_color(depth == red_depth ? __rb_tree_red : __rb_tree_black);
+    left(x) = l;
+    if (l)
+        l->set_parent(x);
+    link_type r = __link_sorted(list, n - 1 - left_n, depth + 1, red_depth);
+    right(x) = r;
+    if (r)
+        r->set_parent(x);
+    Augment::update(x); //子树已接好,由下而上算出增强资讯
+    return x;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+inline void
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::erase(iterator position)
+{
+    link_type y = (link_type) __rb_tree_rebalance_for_erase(position.node, header->tagged_parent,
+                                                            header->left, header->right,
+                                                            Augment());
+    destory_node(y);
+    --node_count;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::size_type
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::erase(const Key& k)
+{
+    pair<iterator, iterator> p = equal_range(k);
+    const size_type n = node_count;
+    erase(p.first, p.second);
+    return n - node_count;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::erase(iterator first, iterator last)
+{
+    if (first == begin() && last == end()) {
+        clear();
+        return;
+    }
+    //区间短时逐一删除;较长且两端都落在键值的分界上(键值不重复时必然如此)时,
+    //改以split整段切下再join回两侧,免去每个元素一次的rebalance
+    iterator i = first;
+    for (size_type c = 0; c < __rb_tree_erase_grain && i != last; ++c)
+        ++i;
+    if (i != last && __key_boundary(first) && __key_boundary(last))
+        __erase_split(key(first.node), last.node == header ? 0 : &key(last.node));
+    else
+        while (first != last)
+            erase(first++);
+}
+
+//以a、b两次split切出键值在[a, b)的一段(b为0时直到最后),两侧join接回,
+//切下的整棵子树以__erase()释放. 调用者保证a < b
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::size_type
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::__erase_split(const Key& a, const Key* b)
+{
+    base_ptr l, m, r = 0;
+    size_type hl, hm, hr = 0, h;
+    __split(root(), __rb_tree_black_height(root()), a, false, l, hl, m, hm);
+    if (b)
+        __split(m, hm, *b, false, m, hm, r, hr);
+    base_ptr t = __rb_tree_join2(l, hl, r, hr, h, Augment());
+    const size_type k = __erase((link_type) m);
+    __reset_root(t, node_count - k);
+    return k;
 }
 
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-inline typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::iterator
-rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::find(const Key &k)
+//依序判断每个元素,连续一段要删除的元素交给erase(first, last): 段落较长时以split/join整段切下.
+//依时间排序的逾期项目等,要删除的元素往往聚在一起,整个过程接近O(N + (段数) log N).
+//pred抛出异常时,已删除的不再恢复,树仍然完好
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+template <class Predicate>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::size_type
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::erase_if(Predicate pred)
+{
+    const size_type n = node_count;
+    iterator i = begin();
+    while (i != end()) {
+        if (!pred(*i)) {
+            ++i;
+            continue;
+        }
+        iterator first = i;
+        while (++i != end() && pred(*i))
+            ;
+        erase(first, i); //i本身不删除,仍然有效
+        if (i != end())
+            ++i;
+    }
+    return n - node_count;
+}
+
+//删除以x为根的整棵子树,不做rebalance: 右子树递归,左子树以循环处理. 返回删除的节点数
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::size_type
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::__erase(link_type x)
+{
+    size_type n = 0;
+    while (x != 0) {
+        n += __erase(right(x)) + 1;
+        link_type y = left(x);
+        destory_node(x);
+        x = y;
+    }
+    return n;
+}
+
+//以k切开以x为根(黑高度hx)的子树: 键值小于k者组成l,其余组成r,两者的黑高度由hl、hr返回.
+//unique时键值等于k的节点(至多一个)不放入r而单独返回,否则返回0.
+//沿查找路径往下,路径上的节点连同它另一侧的子树,依序join到l或r上
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::base_ptr
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::__split(base_ptr x, size_type hx,
+    const Key& k, bool unique, base_ptr& l, size_type& hl, base_ptr& r, size_type& hr) const
+{
+    if (x == 0) {
+        l = r = 0;
+        hl = hr = 0;
+        return 0;
+    }
+    const size_type hc = hx - (x->color() == __rb_tree_black);
+    base_ptr xl = x->left;
+    base_ptr xr = x->right;
+    base_ptr m = 0;
+    if (key_compare(key(x), k)) { //x及其左子树都归l
+        m = __split(xr, hc, k, unique, l, hl, r, hr);
+        l = __rb_tree_join(xl, hc, x, l, hl, hl, Augment());
+    } else if (!unique || key_compare(k, key(x))) { //x及其右子树都归r
+        m = __split(xl, hc, k, unique, l, hl, r, hr);
+        r = __rb_tree_join(r, hr, x, xr, hc, hr, Augment());
+    } else { //x的键值等于k
+        l = xl;
+        hl = hc;
+        r = xr;
+        hr = hc;
+        m = x;
+    }
+    return m;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::split(const Key& k, rb_tree& right)
+{
+    __stl_assert(&right != this);
+    __stl_assert(right.empty());
+    base_ptr l, r;
+    size_type hl, hr;
+    __split(root(), __rb_tree_black_height(root()), k, false, l, hl, r, hr);
+    const size_type n = node_count;
+    const size_type nl = __left_count(l, r, n, Augment());
+    __reset_root(l, nl);
+    right.__reset_root(r, n - nl);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::join(rb_tree& right)
+{
+    if (&right == this) //"right的元素都不排在*this之前"只在空树时成立,无事可做
+        return;
+    base_ptr l = root();
+    base_ptr r = right.root();
+    size_type h;
+    base_ptr t = __rb_tree_join2(l, __rb_tree_black_height(l), r, __rb_tree_black_height(r), h, Augment());
+    const size_type n = node_count + right.node_count;
+    right.__reset_root(0, 0);
+    __reset_root(t, n);
+}
+
+//平行执行时的一份子问题: 第i份处理a[i]与b[i]
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+struct rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::__set_op_task {
+    const rb_tree* tree;
+    __set_op_type op;
+    size_type par_depth;
+    base_ptr a[2];
+    size_type ha;
+    base_ptr b[2];
+    size_type hb[2];
+    base_ptr result[2];
+    size_type h[2];
+    __rb_tree_chain g[2];
+
+    void operator()(size_t i)
+    {
+        result[i] = tree->__set_op(op, a[i], ha, b[i], hb[i], h[i], g[i], par_depth);
+    }
+};
+
+//a、b为两棵(子)树与其黑高度,返回运算结果的根,其黑高度由h返回,不要的节点串入g
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::base_ptr
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::__set_op(__set_op_type op,
+    base_ptr a, size_type ha, base_ptr b, size_type hb,
+    size_type& h, __rb_tree_chain& g, size_type par_depth) const
+{
+    if (a == 0 || b == 0) {
+        if (op == __op_union) {
+            h = a ? ha : hb;
+            return a ? a : b;
+        }
+        g.push_tree(b);
+        if (op == __op_difference) {
+            h = ha;
+            return a;
+        }
+        g.push_tree(a);
+        h = 0;
+        return 0;
+    }
+    //以a的根切开b,a的左右子树分别与切出来的两半运算
+    base_ptr l, r;
+    size_type hl, hr;
+    base_ptr dup = __split(b, hb, key(a), true, l, hl, r, hr);
+    const size_type hc = ha - (a->color() == __rb_tree_black);
+    if (par_depth > 0) {
+        __set_op_task task;
+        task.tree = this;
+        task.op = op;
+        task.par_depth = par_depth - 1;
+        task.a[0] = a->left;
+        task.a[1] = a->right;
+        task.ha = hc;
+        task.b[0] = l;
+        task.b[1] = r;
+        task.hb[0] = hl;
+        task.hb[1] = hr;
+        __stl_parallel_run(2, task);
+        l = task.result[0];
+        r = task.result[1];
+        hl = task.h[0];
+        hr = task.h[1];
+        g.splice(task.g[0]);
+        g.splice(task.g[1]);
+    } else {
+        l = __set_op(op, a->left, hc, l, hl, hl, g, 0);
+        r = __set_op(op, a->right, hc, r, hr, hr, g, 0);
+    }
+    if (dup)
+        g.push(dup);
+    //a的根是否留在结果中: union必留;intersection在b中也有才留;difference在b中没有才留
+    if (op == __op_union || (op == __op_intersection) == (dup != 0))
+        return __rb_tree_join(l, hl, a, r, hr, h, Augment());
+    g.push(a);
+    return __rb_tree_join2(l, hl, r, hr, h, Augment());
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+void rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::__set_op_with(__set_op_type op,
+    rb_tree& x, size_type threads)
+{
+    if (&x == this) { //与自己运算: 联集、交集不变,差集为空
+        if (op == __op_difference)
+            clear();
+        return;
+    }
+    const size_type n = node_count + x.node_count;
+    //平行的层数: 每往下一层,子问题加倍
+    if (threads == 0)
+        threads = __stl_hardware_concurrency();
+    if (threads > n / __rb_tree_parallel_grain)
+        threads = n / __rb_tree_parallel_grain;
+    size_type par_depth = 0;
+    while ((size_type(2) << par_depth) <= threads &&
+           (size_type(2) << par_depth) <= __stl_max_parallel_threads)
+        ++par_depth;
+
+    base_ptr a = root();
+    base_ptr b = x.root();
+    x.__reset_root(0, 0); //x的节点全数交由以下运算处理
+    __rb_tree_chain g;
+    size_type h;
+    base_ptr t = __set_op(op, a, __rb_tree_black_height(a), b, __rb_tree_black_height(b), h, g, par_depth);
+    __reset_root(t, n - g.n);
+    for (base_ptr p = g.head; p != 0; ) {
+        base_ptr next = p->right;
+        destory_node((link_type) p);
+        p = next;
+    }
+}
+
+//由根往下: 左子树有l个节点,k < l往左,k == l即为本节点,否则扣掉l + 1往右
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::link_type
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::__select(size_type k) const
+{
+    if (k >= node_count)
+        return header;
+    link_type x = root();
+    for (;;) {
+        size_type l = Augment::size(x->left);
+        if (k < l)
+            x = left(x);
+        else if (k == l)
+            return x;
+        else {
+            k -= l + 1;
+            x = right(x);
+        }
+    }
+}
+
+//由position往上: 每当自己是右子节点,父节点及其左子树都排在前面
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::size_type
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::index(const_iterator position) const
+{
+    base_ptr x = position.node;
+    if (x == header)
+        return node_count;
+    size_type r = Augment::size(x->left);
+    for (; x != root(); x = x->parent())
+        if (x == x->parent()->right)
+            r += Augment::size(x->parent()->left) + 1;
+    return r;
+}
+
+//与__lower_bound()同一条路径,往右走时把左子树与本节点计入
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+template <class K>
+typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::size_type
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::__rank(const K& k) const
+{
+    size_type r = 0;
+    link_type x = root();
+    while (x != 0)
+        if (!key_compare(key(x), k))
+            x = left(x);
+        else {
+            r += Augment::size(x->left) + 1;
+            x = right(x);
+        }
+    return r;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+template <class K>
+inline typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::link_type
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::__lower_bound(const K& k) const
 {
     link_type y = header; //Last node which is not less than k.
     link_type x = root(); //Current node
 
     while (x != 0) //以下: key_compare是节点值大小的比较准则,应该是个function object
-        if (!key_compare(key(x), k)) //到这里表示x键值大于k,遇到大值就向左走
-            y = x, x = left(); //注意语法
+        if (!key_compare(key(x), k)) //到这里表示x键值不小于k,就向左走
+            y = x, x = left(x); //注意语法
         else //进行到这里, 表示x键值小于k,遇到小值就向右走
             x = right(x);
-    iterator j = iterator(y);
-    return (j == end() || key_compare(k, key(j.node))) ? end() : j;
+    return y;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+template <class K>
+inline typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::link_type
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::__upper_bound(const K& k) const
+{
+    link_type y = header; //Last node which is greater than k.
+    link_type x = root(); //Current node
+
+    while (x != 0)
+        if (key_compare(k, key(x))) //x键值大于k,就向左走
+            y = x, x = left(x);
+        else
+            x = right(x);
+    return y;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+template <class K>
+inline typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::link_type
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::__find(const K& k) const
+{
+    link_type j = __lower_bound(k);
+    //j不小于k;若k也不小于j,两者即相等
+    return (j == header || key_compare(k, key(j))) ? header : j;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc, class Augment>
+template <class K>
+inline typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::size_type
+rb_tree<Key, Value, KeyOfValue, Compare, Alloc, Augment>::__count(const K& k) const
+{
+    iterator first(__lower_bound(k));
+    iterator last(__upper_bound(k));
+    size_type n = 0;
+    for (; first != last; ++first)
+        ++n;
+    return n;
 }
 
 #endif // SGI_STL_RB_TREE_H
@@ -524,7 +1802,7 @@ __rb_tree_base_iterator rbtite;
 
 for (; it1 != it2; ++it1) {
     rbtite = __rb_tree_base_iterator(it1);
-    std::cout << *it1 << '(' << rbtite.node->color << ") ";
+    std::cout << *it1 << '(' << rbtite.node->color() << ") ";
 }
 std::cout << std::endl;
 
@@ -1281,6 +1281,51 @@ RandomAccessIterator last, const T& value, Distance*, random_access_iterator)
     return first;
 }
 
+//__lower_bound: forward_iterator, comp版本
+template <class ForwardIterator, class T, class Compare, class Distance>
+ForwardIterator __lower_bound(ForwardIterator first, ForwardIterator last,
+const T& value, Compare comp, Distance*, forward_iterator_tag)
+{
+    Distance len = 0;
+    distance(first, last, len);
+    Distance half;
+    ForwardIterator middle;
+
+    while (len > 0) {
+        half = len >> 1;
+        middle = first;
+        advance(middle, half);
+        if (comp(*middle, value)) {
+            first = middle;
+            ++first;
+            len = len - half - 1;
+        } else
+            len = half;
+    }
+    return first;
+}
+
+//__lower_bound: random_access_iterator, comp版本
+template <class RandomAccessIterator, class T, class Compare, class Distance>
+RandomAccessIterator __lower_bound(RandomAccessIterator first, RandomAccessIterator last,
+const T& value, Compare comp, Distance*, random_access_iterator_tag)
+{
+    Distance len = last - first;
+    Distance half;
+    RandomAccessIterator middle;
+
+    while (len > 0) {
+        half = len >> 1;
+        middle = first + half;
+        if (comp(*middle, value)) {
+            first = middle + 1;
+            len = len - half - 1;
+        } else
+            len = half;
+    }
+    return first;
+}
+
 //====== upper_bound(应用于有序空间) =======
 //version 1: operator<
 template <class ForwardIterator, class T>
@@ -1347,6 +1392,53 @@ RandomAccessIterator last, const T& value, Distance*, random_access_iterator)
     return first;
 }
 
+//__upper_bound: forward_iterator, comp版本
+template <class ForwardIterator, class T, class Compare, class Distance>
+ForwardIterator __upper_bound(ForwardIterator first, ForwardIterator last,
+const T& value, Compare comp, Distance*, forward_iterator_tag)
+{
+    Distance len = 0;
+    distance(first, last, len);
+    Distance half;
+    ForwardIterator middle;
+
+    while (len > 0) {
+        half = len >> 1;
+        middle = first;
+        advance(middle, half);
+        if (comp(value, *middle)) {
+            len = half;
+        } else {
+            first = middle;
+            ++first;
+            len = len - half - 1;
+        }
+    }
+    return first;
+}
+
+//__upper_bound: random_access_iterator, comp版本
+template <class RandomAccessIterator, class T, class Compare, class Distance>
+RandomAccessIterator __upper_bound(RandomAccessIterator first, RandomAccessIterator last,
+const T& value, Compare comp, Distance*, random_access_iterator_tag)
+{
+    Distance len = last - first;
+    Distance half;
+    RandomAccessIterator middle;
+
+    while (len > 0) {
+        half = len >> 1;
+        middle = first + half;
+        if (comp(value, *middle)) {
+            len = half;
+        } else {
+            first = middle + 1;
+            len = len - half - 1;
+        }
+    }
+    return first;
+}
+
 //===== binary_search(应用于有序空间) ======
 //version 1
 template <class ForwardIterator, class T>
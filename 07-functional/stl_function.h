@@ -114,6 +114,23 @@ struct less : public binary_function<T, T, bool> {
     bool operator()(const T& x, const T& y) const { return x<y; }
 };
 
+//透明(transparent)版本: equal_to<void>与less<void>可比较任意两个型别,
+//以它们作为set/map/hash_map的比较准则,即可用const char*直接查找string键值,
+//不必为每次查找构造临时的string(见<type_traits.h>的__enable_if_transparent)
+__STL_TEMPLATE_NULL
+struct equal_to<void> {
+    typedef void is_transparent;
+    template <class T, class U>
+    bool operator()(const T& x, const U& y) const { return x==y; }
+};
+
+__STL_TEMPLATE_NULL
+struct less<void> {
+    typedef void is_transparent;
+    template <class T, class U>
+    bool operator()(const T& x, const U& y) const { return x<y; }
+};
+
 template <class T>
 struct greater_equal : public binary_function<T, T, bool> {
     bool operator()(const T& x, const T& y) const { return x>=y; }